@@ -14,6 +14,8 @@
 #elif defined(__WIN64__) || defined(_WIN64) || defined(WIN64)
 #  define EASY_OS_WINDOWS
 #  define EASY_WIN64
+#elif defined(__linux__)
+#  define EASY_OS_LINUX
 #else
 #  error "Unsupported OS"
 #endif
@@ -46,7 +48,10 @@
 #  define EASY_HAS_OVERRIDE_KEYWORD
 //#  define EASY_HAS_NESTED_EXCEPTION
 #elif defined (EASY_GCC)
-#  define EASY_HAS_NOEXCEPT
+#  define EASY_HAS_UNDERLYING_TYPE
+#  define EASY_HAS_FINAL_KEYWORD
+#  define EASY_HAS_OVERRIDE_KEYWORD
+//#  define EASY_HAS_NOEXCEPT // noexcept is put on declarations only, which gcc rejects
 #  define EASY_HAS_EXPLICIT_OPERATOR
 #endif
 
@@ -63,6 +68,17 @@
  * @brief Macro for noexcept keyword.
  */
 
+#ifdef EASY_GCC
+#  define EASY_NOEXCEPT_FALSE noexcept(false)
+#else
+#  define EASY_NOEXCEPT_FALSE
+#endif
+
+/*!
+ * @def EASY_NOEXCEPT_FALSE
+ * @brief Marks destructors which may throw. C++11 destructors are noexcept by default.
+ */
+
 //////////////////////////////////////////////////////////////////////////
 
 #ifdef EASY_HAS_FINAL_KEYWORD
@@ -97,7 +113,7 @@
 #define EASY_TEST_BOOL(Value)   \
   {                             \
     if (!Value)                 \
-      throw std::exception(""); \
+      throw std::logic_error(#Value); \
   }
 
 
@@ -107,6 +123,17 @@
 
 #define EASY_HAS_WCAHR
 
+#ifdef EASY_MSVC_VERSION
+#  define EASY_THREAD_LOCAL __declspec(thread)
+#else
+#  define EASY_THREAD_LOCAL __thread
+#endif
+
+/*!
+ * @def EASY_THREAD_LOCAL
+ * @brief Thread local storage for variables of trivial types, thread_local is not supported.
+ */
+
 //////////////////////////////////////////////////////////////////////////
 
 // boost definitions
@@ -115,4 +142,20 @@
 
 //////////////////////////////////////////////////////////////////////////
 
+/*!
+ * @def EASY_NO_EXCEPTIONS
+ * @brief Build option making error_code_ref and result<T> never throw. Errors reach the callers
+ * only through error_code objects and result<T>, errors nobody receives go to the unhandled error
+ * handler. The rest of the library still uses exceptions, so the compiler must keep them enabled,
+ * and BOOST_NO_EXCEPTIONS does not define it.
+ */
+
+/*!
+ * @def EASY_ERROR_TELEMETRY
+ * @brief Build option counting the errors reported through error_code_ref, see error_telemetry.h.
+ * Not defined by default, so the error paths cost nothing extra.
+ */
+
+//////////////////////////////////////////////////////////////////////////
+
 #endif
\ No newline at end of file
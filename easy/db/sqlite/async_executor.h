@@ -0,0 +1,123 @@
+/*!
+ *  @file   easy/db/sqlite/async_executor.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_DB_SQLITE_ASYNC_EXECUTOR_H_INCLUDED
+#define EASY_DB_SQLITE_ASYNC_EXECUTOR_H_INCLUDED
+
+#include <easy/db/sqlite/config.h>
+#include <easy/db/sqlite/detail/sqlite_detail.h>
+
+#include <easy/db/sqlite/database.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace easy {
+namespace db
+{
+  namespace sqlite
+  {
+    namespace detail
+    {
+      struct async_task;
+    }
+
+    //! Kind of a job submitted to async_executor
+    enum class job_kind
+    {
+      read,  //!< Runs on its own, outside of any transaction
+      write  //!< Runs together with other queued writes in one transaction
+    };
+
+    //! Statistics of an async_executor
+    struct async_executor_stats
+    {
+      async_executor_stats() EASY_NOEXCEPT
+        : reads(), writes(), failed(), transactions(), max_transaction_writes() {
+      }
+
+      uint64 reads;                  //!< Number of completed read jobs
+      uint64 writes;                 //!< Number of completed write jobs
+      uint64 failed;                 //!< Number of jobs completed with an error
+      uint64 transactions;           //!< Number of transactions the writes were grouped into
+      size_t max_transaction_writes; //!< The biggest number of writes in one transaction
+    };
+
+    //! Runs jobs over a database connection owned by a dedicated worker thread.
+    //!
+    //! Jobs are queued through a lock-free queue, so submitting threads never wait for disk I/O.
+    //! Writes queued together are grouped into one transaction, each write in its own savepoint,
+    //! so a failed write is rolled back alone. Write jobs must not begin or commit transactions.
+    //! Jobs and completion callbacks are called on the worker thread.
+    class async_executor
+      : boost::noncopyable
+    {
+    public:
+      //! Job run over the connection. Errors must be reported through ec
+      typedef std::function<void(database&, error_code_ref ec)> job_type;
+
+      //! Called on the worker thread when a job is completed. Write jobs are completed after commit
+      typedef std::function<void(const error_code&)> completion_type;
+
+      //! Default maximum number of writes grouped into one transaction
+      static const size_t default_max_transaction_writes = 1000;
+
+      //! Takes over an opened connection and starts the worker thread
+      explicit async_executor(database && _db, size_t max_transaction_writes = default_max_transaction_writes);
+
+      //! Destructor. Completes the queued jobs and stops the worker thread
+      ~async_executor() EASY_NOEXCEPT;
+
+      //! Queues a job. The future gets the job error
+      std::future<error_code> submit(job_kind kind, job_type job);
+
+      //! Queues a job. The completion is called with the job error
+      void submit(job_kind kind, job_type job, completion_type completion);
+
+      //! Queues a write executing the SQL
+      std::future<error_code> execute(const lite_string& sql);
+
+      //! Queues a write executing the SQL. The completion is called with the error
+      void execute(const lite_string& sql, completion_type completion);
+
+      //! Completes the queued jobs and stops the worker thread. Jobs queued afterwards
+      //! are completed at once with result_code::executor_stopped
+      void stop() EASY_NOEXCEPT;
+
+      //! Returns executor statistics
+      async_executor_stats get_stats() const;
+
+    private:
+      void push(detail::async_task* ptask) EASY_NOEXCEPT;
+      detail::async_task* take_all() EASY_NOEXCEPT;
+      bool wait() EASY_NOEXCEPT;
+      void run() EASY_NOEXCEPT;
+      detail::async_task* run_read(detail::async_task* ptask) EASY_NOEXCEPT;
+      detail::async_task* run_writes(detail::async_task* ptask) EASY_NOEXCEPT;
+      void complete(detail::async_task* ptask) EASY_NOEXCEPT;
+      void complete_stopped(detail::async_task* ptask) EASY_NOEXCEPT;
+    private:
+      database m_db;
+      const size_t m_max_transaction_writes;
+
+      std::atomic<detail::async_task*> m_head; // lock-free stack of queued jobs, the last queued goes first
+      std::atomic<bool> m_stopped;
+      std::atomic<bool> m_sleeping;
+      std::mutex m_mutex;
+      std::condition_variable m_cond;
+      std::thread m_thread;
+
+      mutable std::mutex m_stats_mutex;
+      async_executor_stats m_stats;
+    };
+
+  }
+}}
+
+#endif
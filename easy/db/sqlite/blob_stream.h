@@ -0,0 +1,93 @@
+/*!
+ *  @file   easy/db/sqlite/blob_stream.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_DB_SQLITE_BLOB_STREAM_H_INCLUDED
+#define EASY_DB_SQLITE_BLOB_STREAM_H_INCLUDED
+
+#include <easy/db/sqlite/config.h>
+#include <easy/db/sqlite/detail/sqlite_detail.h>
+
+#include <easy/types.h>
+#include <easy/streams.h>
+
+namespace easy {
+namespace db
+{
+  namespace sqlite
+  {
+    class database;
+
+    //! Access mode of a blob_stream
+    enum class blob_access
+    {
+      read_only,
+      read_write
+    };
+
+    //! Incremental access to a BLOB value. Reads and writes go straight between
+    //! the caller buffers and the database pages, so the value is never loaded as a whole.
+    //!
+    //! The size of the value cannot be changed through the stream. Reserve it beforehand
+    //! with zeroblob(N) in an INSERT or UPDATE. The stream expires when the row is modified
+    //! by other means, and reads and writes fail with SQLITE_ABORT afterwards.
+    class blob_stream
+      : public istream
+      , public ostream
+      , boost::noncopyable
+    {
+    public:
+      typedef std::unique_ptr<detail::blob_impl> impl_ptr;
+    public:
+      blob_stream() EASY_NOEXCEPT;
+      ~blob_stream() EASY_NOEXCEPT;
+      blob_stream(blob_stream && r) EASY_NOEXCEPT;
+      blob_stream& operator = (blob_stream && r) EASY_NOEXCEPT;
+
+      //! Opens the value in the column of the row of the main database
+      blob_stream(database& _db, const lite_string& table, const lite_string& column, int64 rowid,
+        blob_access access = blob_access::read_only, error_code_ref ec = nullptr);
+
+      //! Moves the stream to the value of another row of the same table and rewinds it.
+      //! Much cheaper than opening a new stream
+      bool reopen(int64 rowid, error_code_ref ec = nullptr);
+
+      //! Reads up to size bytes from the current position
+      size_t read(byte* buffer, size_t size, error_code_ref ec = nullptr) EASY_OVERRIDE;
+
+      //! Writes size bytes at the current position. Fails if the value is too small
+      bool write(const byte* data, size_t size, error_code_ref ec = nullptr) EASY_OVERRIDE;
+
+      //! Reads up to size bytes at the offset. The current position is not changed
+      size_t read_at(size_t offset, byte* buffer, size_t size, error_code_ref ec = nullptr);
+
+      //! Writes size bytes at the offset. The current position is not changed
+      bool write_at(size_t offset, const byte* data, size_t size, error_code_ref ec = nullptr);
+
+      //! Moves the current position. Positions beyond the end are clamped to the size
+      void seek(size_t position) EASY_NOEXCEPT;
+
+      //! Returns the current position
+      size_t tell() const EASY_NOEXCEPT;
+
+      //! Returns the size of the value in bytes
+      size_t size() const EASY_NOEXCEPT;
+
+      //! Closes the stream
+      void close() EASY_NOEXCEPT;
+
+      //! Returns true if the stream is open
+      bool is_open() const EASY_NOEXCEPT;
+
+    protected:
+      blob_stream(impl_ptr && r) EASY_NOEXCEPT;
+    private:
+      friend database;
+      impl_ptr m_impl_ptr;
+      size_t m_position;
+    };
+  }
+}}
+
+#endif
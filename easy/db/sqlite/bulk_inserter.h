@@ -0,0 +1,125 @@
+/*!
+ *  @file   easy/db/sqlite/bulk_inserter.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_DB_SQLITE_BULK_INSERTER_H_INCLUDED
+#define EASY_DB_SQLITE_BULK_INSERTER_H_INCLUDED
+
+#include <easy/db/sqlite/config.h>
+#include <easy/db/sqlite/detail/sqlite_detail.h>
+
+#include <easy/db/sqlite/database.h>
+#include <easy/db/sqlite/statement.h>
+
+#include <easy/range.h>
+
+#include <chrono>
+
+namespace easy {
+namespace db
+{
+  namespace sqlite
+  {
+    //! Statistics of a bulk insertion
+    struct bulk_insert_stats
+    {
+      bulk_insert_stats() EASY_NOEXCEPT
+        : rows(), transactions(), seconds() {
+      }
+
+      //! Returns the insertion throughput
+      double get_rows_per_second() const EASY_NOEXCEPT {
+        return seconds > 0 ? rows / seconds : 0;
+      }
+
+      uint64 rows;          //!< Number of committed rows
+      uint64 transactions;  //!< Number of committed transactions
+      double seconds;       //!< Time spent inside transactions
+    };
+
+    //! Inserts rows through one prepared statement wrapping every batch of rows into a transaction.
+    //!
+    //! If a row fails the current transaction is rolled back, so only the rows of the
+    //! previously committed batches are kept. The pending batch is committed on destruction.
+    class bulk_inserter
+      : boost::noncopyable
+    {
+    public:
+      //! Default number of rows committed in one transaction
+      static const size_t default_batch_size = 10000;
+
+      //! Prepares the insert query. The query parameters are bound from each row in order
+      bulk_inserter(database& _db, const lite_string& query, error_code_ref ec = nullptr);
+
+      //! Prepares the insert query and sets the number of rows committed in one transaction
+      bulk_inserter(database& _db, const lite_string& query, size_t batch_size, error_code_ref ec = nullptr);
+
+      //! Destructor. Commits the pending rows
+      ~bulk_inserter() EASY_NOEXCEPT;
+
+      //! Inserts a row represented by a tuple
+      template<class Tuple>
+      bool insert(const Tuple& row, error_code_ref ec = nullptr)
+      {
+        if (!begin_row(ec))
+          return false;
+        // bound with a local code, so the transaction is rolled back before a throwing ec throws
+        error_code bind_ec;
+        if (end_row(m_stmt.bind_tuple(row, bind_ec), ec))
+          return true;
+        if (bind_ec)
+          ec.forward(bind_ec);
+        return false;
+      }
+
+      //! Inserts all the rows of a range of tuples
+      template<class Range>
+      bool insert_range(const Range& rows, error_code_ref ec = nullptr)
+      {
+        for (auto it = std::begin(rows); it != std::end(rows); ++it) {
+          if (!insert(*it, ec))
+            return false;
+        }
+        return true;
+      }
+
+      //! Inserts all the rows produced by an enumerator of tuples
+      template<class Tuple>
+      bool insert_all(enumerator<Tuple>& rows, error_code_ref ec = nullptr)
+      {
+        while (typename enumerator<Tuple>::result_type row = rows.get_next(ec)) {
+          if (!insert(row.get(), ec))
+            return false;
+        }
+        return !ec;
+      }
+
+      //! Commits the pending rows
+      bool flush(error_code_ref ec = nullptr);
+
+      //! Returns the number of rows committed in one transaction
+      size_t get_batch_size() const EASY_NOEXCEPT;
+
+      //! Returns statistics of the committed rows
+      bulk_insert_stats get_stats() const EASY_NOEXCEPT;
+
+    private:
+      bool begin_row(error_code_ref ec);
+      bool end_row(bool bound, error_code_ref ec);
+      void rollback() EASY_NOEXCEPT;
+    private:
+      typedef std::chrono::steady_clock clock_type;
+    private:
+      database& m_db;
+      statement m_stmt;
+      const size_t m_batch_size;
+      size_t m_pending_rows;
+      clock_type::time_point m_batch_start;
+      bulk_insert_stats m_stats;
+    };
+
+  }
+}}
+
+#endif
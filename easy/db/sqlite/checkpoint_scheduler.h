@@ -0,0 +1,123 @@
+/*!
+ *  @file   easy/db/sqlite/checkpoint_scheduler.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_DB_SQLITE_CHECKPOINT_SCHEDULER_H_INCLUDED
+#define EASY_DB_SQLITE_CHECKPOINT_SCHEDULER_H_INCLUDED
+
+#include <easy/db/sqlite/config.h>
+#include <easy/db/sqlite/detail/sqlite_detail.h>
+
+#include <easy/db/sqlite/database.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace easy {
+namespace db
+{
+  namespace sqlite
+  {
+    //! Defines when a checkpoint_scheduler runs checkpoints
+    struct checkpoint_policy
+    {
+      typedef std::chrono::milliseconds duration_type;
+
+      checkpoint_policy() EASY_NOEXCEPT
+        : poll_interval(1000)
+        , passive_interval(30000)
+        , passive_wal_size(4 * 1024 * 1024)
+        , truncate_wal_size(64 * 1024 * 1024) {
+      }
+
+      duration_type poll_interval;    //!< How often the WAL size is checked
+      duration_type passive_interval; //!< Maximum time between passive checkpoints
+      uint64 passive_wal_size;        //!< Size in bytes of the frames not checkpointed yet triggering a passive checkpoint
+      uint64 truncate_wal_size;       //!< WAL size in bytes triggering a truncate checkpoint
+    };
+
+    //! Statistics of a checkpoint_scheduler
+    struct checkpoint_stats
+    {
+      checkpoint_stats() EASY_NOEXCEPT
+        : passive_checkpoints(), truncate_checkpoints(), busy_checkpoints(), failed_checkpoints()
+        , max_wal_size(), total_seconds(), max_seconds() {
+      }
+
+      uint64 passive_checkpoints;  //!< Number of completed passive checkpoints
+      uint64 truncate_checkpoints; //!< Number of completed truncate checkpoints
+      uint64 busy_checkpoints;     //!< Number of checkpoints which could not complete because of readers or writers
+      uint64 failed_checkpoints;   //!< Number of checkpoints failed with other errors
+      uint64 max_wal_size;         //!< The biggest WAL size seen
+      double total_seconds;        //!< Time spent in checkpoints
+      double max_seconds;          //!< The longest checkpoint
+    };
+
+    //! Runs WAL checkpoints of a database file in a background thread.
+    //!
+    //! The scheduler uses its own connection, so it does not interfere with connections
+    //! of other threads. Writers should disable automatic checkpoints
+    //! (database_options::wal_autocheckpoint = 0) to keep checkpoint stalls out of commits.
+    class checkpoint_scheduler
+      : boost::noncopyable
+    {
+    public:
+      //! Opens the database and starts the scheduler thread
+      checkpoint_scheduler(const lite_string& db_file_path, error_code_ref ec = nullptr);
+
+      //! Opens the database and starts the scheduler thread
+      checkpoint_scheduler(const lite_string& db_file_path, const checkpoint_policy& policy, error_code_ref ec = nullptr);
+
+      //! Destructor. Stops the scheduler thread
+      ~checkpoint_scheduler() EASY_NOEXCEPT;
+
+      //! Stops the scheduler thread. No checkpoints are run afterwards
+      void stop() EASY_NOEXCEPT;
+
+      //! Runs a checkpoint immediately on the calling thread. Waits for a checkpoint of the
+      //! scheduler thread in progress
+      bool checkpoint(checkpoint_mode mode, error_code_ref ec = nullptr);
+
+      //! Returns scheduler statistics
+      checkpoint_stats get_stats() const;
+
+    private:
+      void start(const lite_string& db_file_path, error_code_ref ec);
+      void run() EASY_NOEXCEPT;
+      bool run_checkpoint(checkpoint_mode mode, error_code_ref ec);
+      uint64 get_wal_size() const EASY_NOEXCEPT;
+      int64 get_pragma(const lite_string& sql);
+    private:
+      typedef std::chrono::steady_clock clock_type;
+
+      //! Bytes a WAL frame takes in addition to the page
+      static const uint64 wal_frame_header_size = 24;
+    private:
+      const checkpoint_policy m_policy;
+      std::string m_wal_path;
+      std::thread m_thread;
+
+      // the connection is used by one thread at a time, m_mutex is not held meanwhile
+      // so stop and get_stats do not wait for a long checkpoint
+      std::mutex m_db_mutex;
+      database m_db;
+      uint64 m_frame_size;
+      uint64 m_unchecked_frames;  // frames the last checkpoint left in the log
+      uint64 m_checked_wal_size;  // WAL file size after the last checkpoint
+      int64 m_data_version;
+      bool m_written;             // other connections committed since the last checkpoint
+
+      mutable std::mutex m_mutex;
+      std::condition_variable m_stop_cond;
+      bool m_stopped;
+      clock_type::time_point m_last_checkpoint;
+      checkpoint_stats m_stats;
+    };
+
+  }
+}}
+
+#endif
@@ -0,0 +1,135 @@
+/*!
+ *  @file   easy/db/sqlite/connection_pool.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_DB_SQLITE_CONNECTION_POOL_H_INCLUDED
+#define EASY_DB_SQLITE_CONNECTION_POOL_H_INCLUDED
+
+#include <easy/db/sqlite/config.h>
+#include <easy/db/sqlite/detail/sqlite_detail.h>
+
+#include <easy/db/sqlite/database.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace easy {
+namespace db
+{
+  namespace sqlite
+  {
+    class connection_pool;
+
+    //! Statistics of a connection pool
+    struct connection_pool_stats
+    {
+      connection_pool_stats() EASY_NOEXCEPT
+        : readers(), idle_readers(), reader_checkouts(), writer_checkouts()
+        , waits(), timeouts(), total_wait_seconds(), max_wait_seconds() {
+      }
+
+      size_t readers;            //!< Number of read-only connections
+      size_t idle_readers;       //!< Number of read-only connections which are not checked out
+      uint64 reader_checkouts;   //!< Number of successful read-only connection checkouts
+      uint64 writer_checkouts;   //!< Number of successful writer connection checkouts
+      uint64 waits;              //!< Number of checkouts which had to wait for a connection
+      uint64 timeouts;           //!< Number of checkouts failed by timeout
+      double total_wait_seconds; //!< Time spent waiting for connections
+      double max_wait_seconds;   //!< The longest wait for a connection
+    };
+
+    //! Checked out pooled connection. Returns the connection to the pool on destruction.
+    //! Statements created over the connection must not outlive the handle.
+    class pooled_connection
+      : public safe_bool<pooled_connection>
+      , boost::noncopyable
+    {
+    public:
+      pooled_connection() EASY_NOEXCEPT;
+      pooled_connection(pooled_connection && r) EASY_NOEXCEPT;
+      pooled_connection& operator = (pooled_connection && r) EASY_NOEXCEPT;
+      ~pooled_connection() EASY_NOEXCEPT;
+
+      //! Returns the connection to the pool before the handle is destroyed
+      void release() EASY_NOEXCEPT;
+
+      database& operator * () const EASY_NOEXCEPT;
+      database* operator -> () const EASY_NOEXCEPT;
+      database* get() const EASY_NOEXCEPT;
+
+      //! Returns true if the handle holds the writer connection
+      bool is_writer() const EASY_NOEXCEPT;
+
+      bool operator ! () const EASY_NOEXCEPT;
+    private:
+      pooled_connection(connection_pool* pool, database* _db, bool writer) EASY_NOEXCEPT;
+      friend connection_pool;
+    private:
+      connection_pool* m_pool;
+      database* m_db;
+      bool m_writer;
+    };
+
+    //! Pool of read-only connections plus one writer connection over the same database file.
+    //!
+    //! The connections are opened with the specified flags. open_flag::nomutex is a good choice
+    //! since a connection is used by one thread at a time. open_flag::wal cannot be passed to
+    //! sqlite3_open_v2, so it switches the database to the WAL journal mode instead, which lets
+    //! the readers go on while the writer is busy.
+    class connection_pool
+      : boost::noncopyable
+    {
+    public:
+      typedef std::chrono::milliseconds duration_type;
+
+      //! Opens the connections with open_flag::nomutex and open_flag::wal
+      connection_pool(const lite_string& db_file_path, size_t readers, error_code_ref ec = nullptr);
+
+      //! Opens the connections with the specified flags. Access mode flags are set by the pool
+      connection_pool(const lite_string& db_file_path, size_t readers, open_flag flags, error_code_ref ec = nullptr);
+
+      //! Destructor. All the connections must be returned to the pool
+      ~connection_pool() EASY_NOEXCEPT;
+
+      //! Checks out a read-only connection waiting as long as needed
+      pooled_connection acquire_reader(error_code_ref ec = nullptr);
+
+      //! Checks out a read-only connection waiting no longer than the timeout
+      pooled_connection acquire_reader(duration_type timeout, error_code_ref ec = nullptr);
+
+      //! Checks out the writer connection waiting as long as needed
+      pooled_connection acquire_writer(error_code_ref ec = nullptr);
+
+      //! Checks out the writer connection waiting no longer than the timeout
+      pooled_connection acquire_writer(duration_type timeout, error_code_ref ec = nullptr);
+
+      //! Returns pool statistics
+      connection_pool_stats get_stats() const;
+
+    private:
+      void open(const lite_string& db_file_path, size_t readers, open_flag flags, error_code_ref ec);
+      pooled_connection acquire(bool writer, const duration_type* ptimeout, error_code_ref ec);
+      void release(database* _db, bool writer) EASY_NOEXCEPT;
+      friend pooled_connection;
+    private:
+      typedef std::unique_ptr<database> database_ptr;
+      typedef std::chrono::steady_clock clock_type;
+    private:
+      std::vector<database_ptr> m_readers;
+      std::vector<database*> m_idle_readers;
+      database_ptr m_writer;
+      bool m_writer_busy;
+
+      mutable std::mutex m_mutex;
+      std::condition_variable m_reader_cond;
+      std::condition_variable m_writer_cond;
+      connection_pool_stats m_stats;
+    };
+
+  }
+}}
+
+#endif
@@ -9,11 +9,18 @@
 #include <easy/db/sqlite/config.h>
 #include <easy/db/sqlite/detail/sqlite_detail.h>
 
+#include <easy/types.h>
 #include <easy/strings.h>
 #include <easy/error_handling.h>
 #include <easy/flags.h>
 
 #include <easy/db/sqlite/statement.h>
+#include <easy/db/sqlite/blob_stream.h>
+#include <easy/db/sqlite/profiling.h>
+
+#include <boost/optional.hpp>
+
+#include <vector>
 
 namespace easy { 
 namespace db {
@@ -48,6 +55,9 @@ namespace db {
     {
       null_database    = -100,
       null_statement,
+      pool_timeout,
+      executor_stopped,
+      null_blob,
       // sqlite codes
       ok               = SQLITE_OK,
     };
@@ -56,10 +66,76 @@ namespace db {
       : public boost::system::error_category
     {
     public:
-      const char * name() const;
+      const char * name() const BOOST_SYSTEM_NOEXCEPT;
       std::string message(int ev) const EASY_FINAL;
     };
 
+    //! Statistics of the prepared statement cache
+    struct statement_cache_stats
+    {
+      statement_cache_stats() EASY_NOEXCEPT
+        : capacity(), size(), hits(), misses(), evictions() {
+      }
+
+      size_t capacity;  //!< Maximum number of idle statements kept for reuse
+      size_t size;      //!< Number of idle statements currently cached
+      uint64 hits;      //!< Number of statements taken from the cache
+      uint64 misses;    //!< Number of statements prepared because the cache had no match
+      uint64 evictions; //!< Number of statements finalized to keep the cache within its capacity
+    };
+
+    //! Journal mode of a database
+    enum class journal_mode
+    {
+      unchanged, //!< Keep the current mode
+      delete_,
+      truncate,
+      persist,
+      memory,
+      wal,
+      off
+    };
+
+    //! Synchronous level of a database
+    enum class synchronous_mode
+    {
+      unchanged, //!< Keep the current level
+      off,
+      normal,
+      full,
+      extra
+    };
+
+    //! WAL checkpoint mode
+    enum class checkpoint_mode
+    {
+      passive  = SQLITE_CHECKPOINT_PASSIVE,  //!< Checkpoints as many frames as possible without waiting
+      full     = SQLITE_CHECKPOINT_FULL,     //!< Waits for writers, then checkpoints all the frames
+      restart  = SQLITE_CHECKPOINT_RESTART,  //!< Like full, then waits for readers so the next writer restarts the log
+      truncate = SQLITE_CHECKPOINT_TRUNCATE  //!< Like restart, then truncates the log file to zero bytes
+    };
+
+    //! Tuning options applied to a database when it is opened. Unset options are left untouched
+    struct database_options
+    {
+      database_options() EASY_NOEXCEPT
+        : journal(journal_mode::unchanged)
+        , synchronous(synchronous_mode::unchanged) {
+      }
+
+      journal_mode journal;
+      synchronous_mode synchronous;
+      boost::optional<int64> mmap_size;        //!< Maximum number of bytes used for memory-mapped I/O
+      boost::optional<int64> cache_size;       //!< Page cache size. Negative values are kibibytes, positive ones are pages
+      boost::optional<int> wal_autocheckpoint; //!< WAL size in pages triggering an automatic checkpoint. Zero disables it
+      boost::optional<int> busy_timeout;       //!< Milliseconds to wait for a locked database
+
+      //! Profile for write-heavy workloads: WAL journal, NORMAL synchronous level,
+      //! 256 MiB of memory-mapped I/O and 64 MiB of page cache.
+      //! Set wal_autocheckpoint to zero when a checkpoint_scheduler takes care of checkpoints
+      static database_options wal_profile() EASY_NOEXCEPT;
+    };
+
     class database
       : boost::noncopyable
     {
@@ -75,9 +151,49 @@ namespace db {
 
       explicit database(const lite_string& db_file_path, error_code_ref ec = nullptr);
       database(const lite_string& db_file_path, open_flag flags, error_code_ref ec = nullptr);
+      database(const lite_string& db_file_path, open_flag flags, const database_options& options, error_code_ref ec = nullptr);
+
+      //! Applies tuning options to the opened database
+      bool apply_options(const database_options& options, error_code_ref ec = nullptr);
+
+      //! Checkpoints the WAL of the main database
+      bool checkpoint(checkpoint_mode mode, error_code_ref ec = nullptr);
+
+      //! Checkpoints the WAL of the main database. Reports the frames in the log and the frames
+      //! checkpointed so far, also when the checkpoint is busy. Both are -1 without a WAL
+      bool checkpoint(checkpoint_mode mode, int& log_frames, int& checkpointed_frames, error_code_ref ec = nullptr);
 
       bool execute(const lite_string& sql, error_code_ref ec = nullptr);
       statement create_statement(const lite_string& query, error_code_ref ec = nullptr);
+
+      //! Opens the value in the column of the row of the main database for incremental I/O
+      blob_stream open_blob(const lite_string& table, const lite_string& column, int64 rowid,
+        blob_access access = blob_access::read_only, error_code_ref ec = nullptr);
+
+      //! Starts collecting per-statement profiles and reporting slow queries. Replaces the collected profiles
+      bool enable_profiling(const profiling_options& options = profiling_options(), error_code_ref ec = nullptr);
+
+      //! Stops profiling and drops the collected profiles
+      void disable_profiling() EASY_NOEXCEPT;
+
+      //! Returns a copy of the collected profiles, the most time consuming statements go first.
+      //! Can be called from any thread
+      std::vector<query_stats> get_profile_snapshot() const;
+
+      //! Drops the collected profiles. Can be called from any thread
+      void reset_profile() EASY_NOEXCEPT;
+
+      //! Sets the maximum number of idle prepared statements kept for reuse. Zero disables the cache
+      void set_statement_cache_capacity(size_t capacity);
+
+      //! Finalizes all idle cached statements
+      void clear_statement_cache() EASY_NOEXCEPT;
+
+      //! Returns statistics of the prepared statement cache
+      statement_cache_stats get_statement_cache_stats() const EASY_NOEXCEPT;
+
+      //! Default capacity of the prepared statement cache
+      static const size_t default_statement_cache_capacity = 16;
     private:
       impl_ptr m_impl_ptr;
     };
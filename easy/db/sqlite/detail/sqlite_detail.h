@@ -26,6 +26,7 @@ namespace sqlite {
 
     class database_impl;
     class statement_impl;
+    class blob_impl;
   }
 }}}
 
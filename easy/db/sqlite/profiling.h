@@ -0,0 +1,93 @@
+/*!
+ *  @file   easy/db/sqlite/profiling.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_DB_SQLITE_PROFILING_H_INCLUDED
+#define EASY_DB_SQLITE_PROFILING_H_INCLUDED
+
+#include <easy/db/sqlite/config.h>
+
+#include <easy/types.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+namespace easy {
+namespace db
+{
+  namespace sqlite
+  {
+    //! Histogram over power of two buckets. Bucket 0 counts zeros,
+    //! bucket i counts values in [2^(i-1), 2^i), the last bucket counts everything above
+    struct query_histogram
+    {
+      static const size_t bucket_count = 40;
+
+      query_histogram() EASY_NOEXCEPT
+        : count(), sum(), largest(), buckets() {
+      }
+
+      //! Adds a sample
+      void add(uint64 value) EASY_NOEXCEPT;
+
+      //! Returns the upper bound of the bucket holding the percentile, p is in [0, 1]
+      uint64 get_percentile(double p) const EASY_NOEXCEPT;
+
+      //! Returns the mean of the samples
+      double get_mean() const EASY_NOEXCEPT {
+        return count ? static_cast<double>(sum) / count : 0;
+      }
+
+      uint64 count;                 //!< Number of samples
+      uint64 sum;                   //!< Sum of the samples
+      uint64 largest;               //!< The biggest sample
+      uint64 buckets[bucket_count]; //!< Number of samples per bucket
+    };
+
+    //! Profile of one SQL text
+    struct query_stats
+    {
+      std::string sql;
+      query_histogram prepare_us;     //!< Prepare time in microseconds. Statements taken from the cache are not prepared
+      query_histogram step_us;        //!< Time of a run, from the first step to the reset, in microseconds
+      query_histogram rows;           //!< Rows returned by a run
+      query_histogram vm_steps;       //!< Virtual machine operations executed by a run
+      query_histogram fullscan_steps; //!< Full table scan steps of a run. Non-zero values usually mean a missing index
+      query_histogram sorts;          //!< Sort operations of a run. Non-zero values usually mean a missing index
+    };
+
+    //! Run of a statement which took longer than the threshold
+    struct slow_query
+    {
+      slow_query() EASY_NOEXCEPT
+        : step_us(), rows(), vm_steps(), fullscan_steps(), sorts() {
+      }
+
+      std::string sql;
+      uint64 step_us;        //!< Run time in microseconds
+      uint64 rows;           //!< Rows returned
+      uint64 vm_steps;       //!< Virtual machine operations executed
+      uint64 fullscan_steps; //!< Full table scan steps
+      uint64 sorts;          //!< Sort operations
+    };
+
+    //! Options of the database profiling
+    struct profiling_options
+    {
+      typedef std::chrono::microseconds duration_type;
+
+      profiling_options() EASY_NOEXCEPT
+        : slow_query_threshold(100000) {
+      }
+
+      duration_type slow_query_threshold; //!< Runs taking longer are reported to slow_query_callback
+
+      //! Called on the thread running the statement, so it must be fast and must not use the database
+      std::function<void(const slow_query&)> slow_query_callback;
+    };
+  }
+}}
+
+#endif
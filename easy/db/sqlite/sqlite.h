@@ -12,5 +12,10 @@
 
 #include <easy/db/sqlite/statement.h>
 #include <easy/db/sqlite/database.h>
+#include <easy/db/sqlite/bulk_inserter.h>
+#include <easy/db/sqlite/connection_pool.h>
+#include <easy/db/sqlite/checkpoint_scheduler.h>
+#include <easy/db/sqlite/async_executor.h>
+#include <easy/db/sqlite/blob_stream.h>
 
 #endif
\ No newline at end of file
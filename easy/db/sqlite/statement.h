@@ -9,13 +9,58 @@
 #include <easy/db/sqlite/config.h>
 #include <easy/db/sqlite/detail/sqlite_detail.h>
 
-namespace easy { 
+#include <easy/types.h>
+#include <easy/lite_buffer.h>
+#include <easy/range.h>
+
+#include <boost/optional.hpp>
+#include <boost/mpl/or.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <tuple>
+
+namespace easy {
 namespace db
 {
   namespace sqlite
   {
     class database;
 
+    //! Fundamental datatype of a column value
+    enum class column_kind
+    {
+      integer  = SQLITE_INTEGER,
+      floating = SQLITE_FLOAT,
+      text     = SQLITE_TEXT,
+      blob     = SQLITE_BLOB,
+      null     = SQLITE_NULL
+    };
+
+    namespace detail
+    {
+      //! Makes it possible to tell a trailing error_code_ref from a value to be bound
+      template<class T>
+      struct is_error_code_arg
+        : boost::mpl::or_<
+            boost::is_same<T, error_code>,
+            boost::is_same<T, error_code*>,
+            boost::is_same<T, error_code_ref>
+        > {
+      };
+
+      template<class T>
+      struct column_reader;
+
+      template<class Tuple, size_t Index = 0, size_t Size = std::tuple_size<Tuple>::value>
+      struct tuple_binder;
+
+      template<class Tuple, size_t Index = 0, size_t Size = std::tuple_size<Tuple>::value>
+      struct tuple_reader;
+
+      template<class Tuple>
+      class row_enumerator;
+    }
+
     class statement
       : boost::noncopyable
     {
@@ -28,18 +73,294 @@ namespace db
       statement& operator = (statement && r) EASY_NOEXCEPT;
       statement(database& _db, const lite_string& query, error_code_ref ec = nullptr);
 
+      //! Evaluates the statement. Returns true if a new row of data is ready
       bool next(error_code_ref ec = nullptr);
+
+      //! Resets the statement to be evaluated again. Bindings are kept
+      bool reset(error_code_ref ec = nullptr);
+
+      //! Sets all parameters to NULL
+      bool clear_bindings(error_code_ref ec = nullptr);
+
+      //! @{
+      //! Binds a value to the parameter with the specified index. The leftmost parameter has an index of 1.
+      //! Text and blobs are copied by SQLite, so the arguments may be temporaries
+      bool bind_at(int index, nullptr_t, error_code_ref ec = nullptr);
+      bool bind_at(int index, int value, error_code_ref ec = nullptr);
+      bool bind_at(int index, uint32 value, error_code_ref ec = nullptr);
+      bool bind_at(int index, int64 value, error_code_ref ec = nullptr);
+      bool bind_at(int index, double value, error_code_ref ec = nullptr);
+      bool bind_at(int index, const lite_string& value, error_code_ref ec = nullptr);
+      bool bind_at(int index, const lite_buffer<byte>& value, error_code_ref ec = nullptr);
+
+      template<class T>
+      bool bind_at(int index, const boost::optional<T>& value, error_code_ref ec = nullptr) {
+        return value ? bind_at(index, value.get(), ec) : bind_at(index, nullptr, ec);
+      }
+      //! @}
+
+      //! @{
+      //! Binds the values to the parameters starting from the first one
+      template<class A1>
+      bool bind(const A1& a1, error_code_ref ec = nullptr)
+      {
+        return bind_at(1, a1, ec);
+      }
+
+      template<class A1, class A2>
+      typename boost::disable_if<detail::is_error_code_arg<A2>, bool
+      >::type bind(const A1& a1, const A2& a2, error_code_ref ec = nullptr)
+      {
+        return bind_at(1, a1, ec)
+            && bind_at(2, a2, ec);
+      }
+
+      template<class A1, class A2, class A3>
+      typename boost::disable_if<detail::is_error_code_arg<A3>, bool
+      >::type bind(const A1& a1, const A2& a2, const A3& a3, error_code_ref ec = nullptr)
+      {
+        return bind_at(1, a1, ec)
+            && bind_at(2, a2, ec)
+            && bind_at(3, a3, ec);
+      }
+
+      template<class A1, class A2, class A3, class A4>
+      typename boost::disable_if<detail::is_error_code_arg<A4>, bool
+      >::type bind(const A1& a1, const A2& a2, const A3& a3, const A4& a4, error_code_ref ec = nullptr)
+      {
+        return bind_at(1, a1, ec)
+            && bind_at(2, a2, ec)
+            && bind_at(3, a3, ec)
+            && bind_at(4, a4, ec);
+      }
+
+      template<class A1, class A2, class A3, class A4, class A5>
+      typename boost::disable_if<detail::is_error_code_arg<A5>, bool
+      >::type bind(const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, error_code_ref ec = nullptr)
+      {
+        return bind_at(1, a1, ec)
+            && bind_at(2, a2, ec)
+            && bind_at(3, a3, ec)
+            && bind_at(4, a4, ec)
+            && bind_at(5, a5, ec);
+      }
+      //! @}
+
+      //! Binds the tuple elements to the parameters starting from the first one
+      template<class Tuple>
+      bool bind_tuple(const Tuple& values, error_code_ref ec = nullptr)
+      {
+        return detail::tuple_binder<Tuple>::bind(*this, values, ec);
+      }
+
+      //! Returns the number of columns in the result set
+      int get_column_count() const EASY_NOEXCEPT;
+
+      //! Returns the datatype of the column value in the current row. The leftmost column has an index of 0
+      column_kind get_column_kind(int col) const EASY_NOEXCEPT;
+
+      //! Returns true if the column value in the current row is NULL
+      bool is_null(int col) const EASY_NOEXCEPT;
+
+      //! @{
+      //! Column accessors. Text and blobs point straight into the current row
+      //! and stay valid until the next call to next(), reset() or the statement destruction
+      int get_int(int col) const EASY_NOEXCEPT;
+      int64 get_int64(int col) const EASY_NOEXCEPT;
+      double get_double(int col) const EASY_NOEXCEPT;
+      lite_string get_text(int col) const EASY_NOEXCEPT;
+      lite_buffer<byte> get_blob(int col) const EASY_NOEXCEPT;
+      //! @}
+
+      //! Returns the column value converted to T
+      template<class T>
+      T get(int col) const {
+        return detail::column_reader<T>::get(*this, col);
+      }
+
+      //! Reads the leading columns of the current row into the tuple elements
+      template<class Tuple>
+      void get_tuple(Tuple& row) const {
+        detail::tuple_reader<Tuple>::read(*this, row);
+      }
+
+      //! @{
+      //! Creates an enumerator stepping the statement and yielding the rows as tuples.
+      //! Use make_range to iterate over the rows in a for loop. The statement must outlive the enumerator
+      template<class A1>
+      std::unique_ptr<enumerator<std::tuple<A1>>> rows() {
+        return make_rows<std::tuple<A1>>();
+      }
+
+      template<class A1, class A2>
+      std::unique_ptr<enumerator<std::tuple<A1, A2>>> rows() {
+        return make_rows<std::tuple<A1, A2>>();
+      }
+
+      template<class A1, class A2, class A3>
+      std::unique_ptr<enumerator<std::tuple<A1, A2, A3>>> rows() {
+        return make_rows<std::tuple<A1, A2, A3>>();
+      }
+
+      template<class A1, class A2, class A3, class A4>
+      std::unique_ptr<enumerator<std::tuple<A1, A2, A3, A4>>> rows() {
+        return make_rows<std::tuple<A1, A2, A3, A4>>();
+      }
+
+      template<class A1, class A2, class A3, class A4, class A5>
+      std::unique_ptr<enumerator<std::tuple<A1, A2, A3, A4, A5>>> rows() {
+        return make_rows<std::tuple<A1, A2, A3, A4, A5>>();
+      }
+      //! @}
+
     protected:
       statement(impl_ptr && r);
+    private:
+      template<class Tuple>
+      std::unique_ptr<enumerator<Tuple>> make_rows() {
+        return std::unique_ptr<enumerator<Tuple>>(new detail::row_enumerator<Tuple>(*this));
+      }
     private:
       friend database;
       impl_ptr m_impl_ptr;
     };
 
+    namespace detail
+    {
+      template<>
+      struct column_reader<int> {
+        static int get(const statement& st, int col) {
+          return st.get_int(col);
+        }
+      };
+
+      template<>
+      struct column_reader<uint32> {
+        static uint32 get(const statement& st, int col) {
+          return static_cast<uint32>(st.get_int64(col));
+        }
+      };
+
+      template<>
+      struct column_reader<int64> {
+        static int64 get(const statement& st, int col) {
+          return st.get_int64(col);
+        }
+      };
+
+      template<>
+      struct column_reader<bool> {
+        static bool get(const statement& st, int col) {
+          return st.get_int(col) != 0;
+        }
+      };
+
+      template<>
+      struct column_reader<double> {
+        static double get(const statement& st, int col) {
+          return st.get_double(col);
+        }
+      };
+
+      template<>
+      struct column_reader<lite_string> {
+        static lite_string get(const statement& st, int col) {
+          return st.get_text(col);
+        }
+      };
+
+      template<>
+      struct column_reader<lite_buffer<byte>> {
+        static lite_buffer<byte> get(const statement& st, int col) {
+          return st.get_blob(col);
+        }
+      };
+
+      template<>
+      struct column_reader<std::string> {
+        static std::string get(const statement& st, int col) {
+          return st.get_text(col);
+        }
+      };
+
+      template<>
+      struct column_reader<byte_vector> {
+        static byte_vector get(const statement& st, int col) {
+          lite_buffer<byte> blob = st.get_blob(col);
+          return byte_vector(blob.begin(), blob.end());
+        }
+      };
+
+      template<class Tuple, size_t Index, size_t Size>
+      struct tuple_binder {
+        static bool bind(statement& st, const Tuple& values, error_code_ref ec) {
+          return st.bind_at(static_cast<int>(Index + 1), std::get<Index>(values), ec)
+              && tuple_binder<Tuple, Index + 1, Size>::bind(st, values, ec);
+        }
+      };
+
+      template<class Tuple, size_t Size>
+      struct tuple_binder<Tuple, Size, Size> {
+        static bool bind(statement&, const Tuple&, error_code_ref) {
+          return true;
+        }
+      };
+
+      template<class Tuple, size_t Index, size_t Size>
+      struct tuple_reader {
+        static void read(const statement& st, Tuple& row) {
+          typedef typename std::tuple_element<Index, Tuple>::type element_type;
+          std::get<Index>(row) = column_reader<element_type>::get(st, static_cast<int>(Index));
+          tuple_reader<Tuple, Index + 1, Size>::read(st, row);
+        }
+      };
+
+      template<class Tuple, size_t Size>
+      struct tuple_reader<Tuple, Size, Size> {
+        static void read(const statement&, Tuple&) {
+        }
+      };
+
+      //! Steps a statement and yields its rows. Text and blob elements point into the current row,
+      //! so they stay valid until the next row is requested. For the same reason the rows are
+      //! not read ahead in batches
+      template<class Tuple>
+      class row_enumerator
+        : public enumerator<Tuple>
+      {
+      public:
+        typedef typename enumerator<Tuple>::value_type value_type;
+        typedef typename enumerator<Tuple>::result_type result_type;
+
+        explicit row_enumerator(statement& st) EASY_NOEXCEPT
+          : m_stmt(st) {
+        }
 
+        result_type get_next(error_code_ref ec = nullptr) EASY_OVERRIDE {
+          result_type row;
+          if (m_stmt.next(ec)) {
+            row = value_type();
+            m_stmt.get_tuple(row.get());
+          }
+          return row;
+        }
+      private:
+        row_enumerator& operator = (const row_enumerator&); // = delete
+      private:
+        statement& m_stmt;
+      };
 
+      template<class T>
+      struct column_reader<boost::optional<T>> {
+        static boost::optional<T> get(const statement& st, int col) {
+          if (st.is_null(col))
+            return boost::none;
+          return column_reader<T>::get(st, col);
+        }
+      };
+    }
 
   }
 }}
 
-#endif
\ No newline at end of file
+#endif
@@ -16,10 +16,15 @@
 #include <easy/safe_bool.h>
 #include <easy/safe_call.h>
 #include <easy/error_handling.h>
+#include <easy/result.h>
+#include <easy/error_telemetry.h>
 #include <easy/flags.h>
+#include <easy/memory.h>
 #include <easy/strings.h>
 #include <easy/scope.h>
 #include <easy/range.h>
+#include <easy/range_adaptors.h>
+#include <easy/parallel_range.h>
 #include <easy/object.h>
 #include <easy/lite_buffer.h>
 #include <easy/os.h>
@@ -31,6 +31,7 @@ namespace easy
     invalid_value ,  //!< invalid value
     unexpected    ,  //!< unexpected
     bad_cast      ,  //!< bad_cast
+    out_of_range  ,  //!< value out of the range of the type
   };
 
   //! Error category which describes generic errors
@@ -38,29 +39,72 @@ namespace easy
     : public error_category
   {
   public:
-    const char* name() const EASY_NOEXCEPT;
+    const char* name() const BOOST_SYSTEM_NOEXCEPT;
     std::string message(int ev) const EASY_FINAL;
   };
 
   //! Creates error_code object from generic_error value
   error_code make_error_code(generic_error e) EASY_NOEXCEPT;
 
+#ifdef EASY_NO_EXCEPTIONS
+  //! Receives the errors assigned to throwable error_code_ref objects when exceptions are
+  //! disabled. The default handler aborts. A handler which returns drops the error, except
+  //! for result<T>::value(), which has no value to return and aborts
+  typedef void (*unhandled_error_handler)(const error_code& ec);
+
+  //! Sets the handler and returns the previous one
+  unhandled_error_handler set_unhandled_error_handler(unhandled_error_handler handler) EASY_NOEXCEPT;
+#endif
+
   namespace detail
   {
+    //! Throws system_error, or calls the unhandled error handler when exceptions are disabled.
+    //! Kept out of line, so the inline success paths stay small
+    void raise_error(const error_code& ec);
+
+#ifdef EASY_ERROR_TELEMETRY
+    //! Counts the error for get_error_snapshot, see error_telemetry.h
+    void record_error(const error_code& ec);
+#endif
+
     class error_code_holder
     {
     public:
-      error_code_holder(error_code* ec) EASY_NOEXCEPT;
-      ~error_code_holder();
-      operator error_code& () EASY_NOEXCEPT;
-      operator error_code* () EASY_NOEXCEPT;
+      error_code_holder(error_code* ec) EASY_NOEXCEPT
+        : m_code(!ec ? m_own_code : *ec) {
+      }
+
+      ~error_code_holder() EASY_NOEXCEPT_FALSE {
+#ifdef EASY_ERROR_TELEMETRY
+        if (m_code)
+          record_error(m_code);
+#endif
+        if (m_own_code)
+          raise_held_error(m_own_code);
+      }
+
+      operator error_code& () EASY_NOEXCEPT {
+        return m_code;
+      }
+
+      operator error_code* () EASY_NOEXCEPT {
+        return &m_code;
+      }
+
+    private:
+      static void raise_held_error(const error_code& ec);
+
     private:
       error_code m_own_code;
       error_code& m_code;
     };
   }
 
-  //! Class is used to hold error codes
+  //! Class is used to hold error codes.
+  //!
+  //! The success path is inline: construction clears the target and an assignment of no error
+  //! only stores it, so passing error_code_ref through tight loops costs a few stores.
+  //! Errors for a throwable object are raised out of line
   class error_code_ref
     : public safe_bool<error_code_ref>
   {
@@ -70,22 +114,51 @@ namespace easy
   public:
 
     //! Initializes throwable
-    error_code_ref() EASY_NOEXCEPT;
+    error_code_ref() EASY_NOEXCEPT
+      : m_pcode(nullptr) {
+    }
 
     //! Initializes throwable
-    error_code_ref(nullptr_t) EASY_NOEXCEPT;
+    error_code_ref(nullptr_t) EASY_NOEXCEPT
+      : m_pcode(nullptr) {
+    }
 
     //! Creates wrapper over existing error_code
-    error_code_ref(error_code& ec) EASY_NOEXCEPT;
+    error_code_ref(error_code& ec) EASY_NOEXCEPT
+      : m_pcode(&ec) {
+      clear();
+    }
 
     //! Creates wrapper over existing error_code or create a throwable one
-    error_code_ref(error_code* ec) EASY_NOEXCEPT;
+    error_code_ref(error_code* ec) EASY_NOEXCEPT
+      : m_pcode(ec) {
+      clear();
+    }
 
     //! Copy constructor. Makes a copy and null the code
-    error_code_ref(const error_code_ref& ec) EASY_NOEXCEPT;
+    error_code_ref(const error_code_ref& ec) EASY_NOEXCEPT
+      : m_pcode(ec.m_pcode) {
+      clear();
+    }
 
     //! Assign operator
-    error_code_ref& operator = (const error_code& ec);
+    error_code_ref& operator = (const error_code& ec) {
+#ifdef EASY_ERROR_TELEMETRY
+      if (ec)
+        detail::record_error(ec);
+#endif
+      return forward(ec);
+    }
+
+    //! Passes on an error received from a call which has reported it through error_code_ref,
+    //! so the error is not counted again by EASY_ERROR_TELEMETRY
+    error_code_ref& forward(const error_code& ec) {
+      if (m_pcode)
+        *m_pcode = ec;
+      else if (ec)
+        detail::raise_error(ec);
+      return *this;
+    }
 
     //! Assign operator
     template<class CodeT>
@@ -103,22 +176,33 @@ namespace easy
     void set_system_error(int code);
 
     //! Create the internal code
-    void clear() EASY_NOEXCEPT;
+    void clear() EASY_NOEXCEPT {
+      if (m_pcode)
+        m_pcode->clear();
+    }
 
     //! Returns a special error_code holder which can be passed to function what use error_code.
     //!
     //! Obtaining an internal type that should be passed to boost functions 
     //! and to be implicitly converted to boost::system::error_code
-    detail::error_code_holder get() EASY_NOEXCEPT;
+    detail::error_code_holder get() EASY_NOEXCEPT {
+      return detail::error_code_holder(m_pcode);
+    }
 
     //! Returns true if error_code is throwable
-    bool is_throwable() const EASY_NOEXCEPT;
+    bool is_throwable() const EASY_NOEXCEPT {
+      return !m_pcode;
+    }
 
     //! Returns true is object contains an error code
-    bool is_error() const EASY_NOEXCEPT;
+    bool is_error() const EASY_NOEXCEPT {
+      return m_pcode && *m_pcode;
+    }
 
     //! Makes it possible to use operator explicit_bool
-    bool operator !() const EASY_NOEXCEPT;
+    bool operator !() const EASY_NOEXCEPT {
+      return !is_error();
+    }
 
   private:
     error_code* m_pcode;
@@ -0,0 +1,68 @@
+/*!
+ *  @file   easy/error_telemetry.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  Counters of the errors reported through error_code_ref and error_code_holder, for builds
+ *  with EASY_ERROR_TELEMETRY defined:
+ *
+ *    const easy::error_snapshot snapshot = easy::get_error_snapshot();
+ *    for (auto it = snapshot.counters.begin(); it != snapshot.counters.end(); ++it)
+ *      log << it->error().message() << ": " << it->count;
+ *
+ *  Every thread counts its errors in its own table without locks, so error storms cost no
+ *  contention. The tables are summed up by get_error_snapshot. The sampler gets every
+ *  n-th error of a thread on that thread, e.g. to capture the stack of the call site.
+ *  Without EASY_ERROR_TELEMETRY nothing is counted and the snapshot is empty.
+ *  The Telemetry configuration of build/msvc/11/easy_test.sln defines it for the library
+ *  and the tests.
+ */
+#ifndef EASY_ERROR_TELEMETRY_H_INCLUDED
+#define EASY_ERROR_TELEMETRY_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/types.h>
+#include <easy/error_handling.h>
+
+#include <vector>
+
+namespace easy
+{
+  //! Number of errors of one category and code
+  struct error_counter
+  {
+    const error_category* pcategory;
+    int code;
+    uint64 count;
+
+    error_code error() const {
+      return error_code(code, *pcategory);
+    }
+  };
+
+  //! Errors counted by all the threads since the start
+  struct error_snapshot
+  {
+    error_snapshot() EASY_NOEXCEPT
+      : untracked(0) {
+    }
+
+    //! Sorted by count, the most frequent first
+    std::vector<error_counter> counters;
+
+    //! Errors of a thread which has met too many different codes to count each of them
+    uint64 untracked;
+  };
+
+  //! Sums up the counters of the threads
+  error_snapshot get_error_snapshot();
+
+  //! Called with sampled errors on the thread reporting them
+  typedef void (*error_sampler)(const error_code& ec);
+
+  //! Makes the sampler get every interval-th error of each thread, nullptr stops sampling.
+  //! The sampler must not throw. Errors reported by the sampler itself are counted but not sampled
+  void set_error_sampler(error_sampler sampler, unsigned int interval = 1) EASY_NOEXCEPT;
+}
+
+#endif
@@ -104,7 +104,7 @@ namespace easy
   {
   public:
     template<class Unknown>
-    void set(Unknown) { EASY_STATIC_ASSERT(0, "Unknown enum group mememer"); }
+    void set(Unknown) { EASY_STATIC_ASSERT(sizeof(Unknown) == 0, "Unknown enum group mememer"); }
     void get() const;
     void contains() const;
   };
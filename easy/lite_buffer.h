@@ -46,6 +46,17 @@ namespace easy
       EASY_ASSERT(m_size > 0 || ptr);
     }
 
+    lite_buffer(lite_buffer && r) EASY_NOEXCEPT
+      : m_ptr(r.m_ptr)
+      , m_size(r.m_size) {
+    }
+
+    lite_buffer& operator = (lite_buffer && r) EASY_NOEXCEPT {
+      m_ptr = r.m_ptr;
+      m_size = r.m_size;
+      return *this;
+    }
+
     template<class U>
     lite_buffer(const U* ptr, size_type size, typename boost::enable_if<boost::is_integral<U>>::type* = nullptr) EASY_NOEXCEPT
       : m_ptr(reinterpret_cast<const value_type*>(ptr))
@@ -0,0 +1,14 @@
+/*!
+ *  @file   easy/memory.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_MEMORY_H_INCLUDED
+#define EASY_MEMORY_H_INCLUDED
+
+#include <easy/memory/memory_resource.h>
+#include <easy/memory/arena.h>
+#include <easy/memory/pool.h>
+#include <easy/memory/thread_cache.h>
+
+#endif
@@ -0,0 +1,78 @@
+/*!
+ *  @file   easy/memory/arena.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_MEMORY_ARENA_H_INCLUDED
+#define EASY_MEMORY_ARENA_H_INCLUDED
+
+#include <easy/memory/memory_resource.h>
+
+#include <boost/noncopyable.hpp>
+
+namespace easy {
+namespace memory
+{
+  //! Monotonic resource: allocations are carved from chunks one after another and are not
+  //! freed one by one, deallocate does nothing. All the memory is returned to the upstream
+  //! resource at once by release() or the destructor, which suits request scoped work.
+  //!
+  //! The chunk sizes double from the initial one up to the maximum one. Allocations bigger
+  //! than a quarter of a chunk get chunks of their own, so the free space of the current chunk
+  //! is not wasted. The arena is not thread safe.
+  class arena
+    : public memory_resource
+    , boost::noncopyable
+  {
+  public:
+    static const size_t default_chunk_size = 4 * 1024;
+    static const size_t default_max_chunk_size = 1024 * 1024;
+
+    explicit arena(size_t initial_chunk_size = default_chunk_size,
+      size_t max_chunk_size = default_max_chunk_size,
+      memory_resource* pupstream = new_delete_resource());
+
+    //! The buffer is used before any chunk is allocated, it must outlive the arena
+    arena(void* pbuffer, size_t buffer_size, memory_resource* pupstream = new_delete_resource());
+
+    ~arena() EASY_NOEXCEPT;
+
+    //! Frees all the allocations at once
+    void release() EASY_NOEXCEPT;
+
+    //! Bytes handed out since the last release
+    size_t used_bytes() const EASY_NOEXCEPT;
+
+    //! Bytes of the chunks allocated from the upstream resource
+    size_t reserved_bytes() const EASY_NOEXCEPT;
+
+    memory_resource* upstream_resource() const EASY_NOEXCEPT;
+
+  protected:
+    virtual void* do_allocate(size_t bytes, size_t alignment) EASY_OVERRIDE;
+    virtual void do_deallocate(void* p, size_t bytes, size_t alignment) EASY_OVERRIDE;
+
+  private:
+    struct chunk_header;
+
+    chunk_header* allocate_chunk(size_t size);
+
+  private:
+    memory_resource* m_pupstream;
+    chunk_header* m_pchunks;    // singly linked list of the chunks
+
+    char* m_pinitial_buffer;
+    size_t m_initial_buffer_size;
+    size_t m_initial_chunk_size;
+    size_t m_max_chunk_size;
+    size_t m_next_chunk_size;
+
+    char* m_pcurrent;           // free space of the current chunk
+    size_t m_remaining;
+
+    size_t m_used_bytes;
+    size_t m_reserved_bytes;
+  };
+}}
+
+#endif
@@ -0,0 +1,169 @@
+/*!
+ *  @file   easy/memory/memory_resource.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_MEMORY_MEMORY_RESOURCE_H_INCLUDED
+#define EASY_MEMORY_MEMORY_RESOURCE_H_INCLUDED
+
+#include <easy/config.h>
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace easy {
+namespace memory
+{
+  //! Alignment of allocations made without an explicit one
+  const size_t max_align = std::alignment_of<long double>::value > std::alignment_of<long long>::value
+    ? std::alignment_of<long double>::value
+    : std::alignment_of<long long>::value;
+
+  //! Source of memory, the interface of std::pmr::memory_resource, which the supported
+  //! compilers do not have. The resources in easy/memory implement it
+  class memory_resource
+  {
+  public:
+    virtual ~memory_resource() { }
+
+    //! Allocates at least bytes of memory. Throws std::bad_alloc on failure
+    void* allocate(size_t bytes, size_t alignment = max_align) {
+      return do_allocate(bytes, alignment);
+    }
+
+    //! Returns the memory to the resource. Arguments must be the same as for allocate
+    void deallocate(void* p, size_t bytes, size_t alignment = max_align) {
+      do_deallocate(p, bytes, alignment);
+    }
+
+    //! Returns true if memory allocated from one resource can be deallocated by the other
+    bool is_equal(const memory_resource& other) const EASY_NOEXCEPT {
+      return do_is_equal(other);
+    }
+
+  protected:
+    virtual void* do_allocate(size_t bytes, size_t alignment) EASY_PURE_VIRTUAL;
+    virtual void do_deallocate(void* p, size_t bytes, size_t alignment) EASY_PURE_VIRTUAL;
+    virtual bool do_is_equal(const memory_resource& other) const EASY_NOEXCEPT {
+      return this == &other;
+    }
+  };
+
+  inline bool operator == (const memory_resource& a, const memory_resource& b) EASY_NOEXCEPT {
+    return &a == &b || a.is_equal(b);
+  }
+
+  inline bool operator != (const memory_resource& a, const memory_resource& b) EASY_NOEXCEPT {
+    return !(a == b);
+  }
+
+  //! Resource allocating with the global operator new
+  memory_resource* new_delete_resource() EASY_NOEXCEPT;
+
+  //! Standard allocator over a memory_resource, so standard containers can use the resources
+  template<class T>
+  class polymorphic_allocator
+  {
+  public:
+    typedef T              value_type;
+    typedef T*             pointer;
+    typedef const T*       const_pointer;
+    typedef T&             reference;
+    typedef const T&       const_reference;
+    typedef size_t         size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<class U>
+    struct rebind {
+      typedef polymorphic_allocator<U> other;
+    };
+
+    polymorphic_allocator() EASY_NOEXCEPT
+      : m_presource(new_delete_resource()) {
+    }
+
+    polymorphic_allocator(memory_resource* presource) EASY_NOEXCEPT
+      : m_presource(presource) {
+      EASY_ASSERT(presource);
+    }
+
+    template<class U>
+    polymorphic_allocator(const polymorphic_allocator<U>& r) EASY_NOEXCEPT
+      : m_presource(r.resource()) {
+    }
+
+    T* allocate(size_t n) {
+      if (n > max_size())
+        throw std::bad_alloc();
+      return static_cast<T*>(m_presource->allocate(n * sizeof(T), std::alignment_of<T>::value));
+    }
+
+    void deallocate(T* p, size_t n) {
+      m_presource->deallocate(p, n * sizeof(T), std::alignment_of<T>::value);
+    }
+
+    size_t max_size() const EASY_NOEXCEPT {
+      return (std::numeric_limits<size_t>::max)() / sizeof(T);
+    }
+
+    template<class U>
+    void construct(U* p) {
+      ::new (static_cast<void*>(p)) U();
+    }
+
+    template<class U, class A1>
+    void construct(U* p, A1 && a1) {
+      ::new (static_cast<void*>(p)) U(std::forward<A1>(a1));
+    }
+
+    template<class U, class A1, class A2>
+    void construct(U* p, A1 && a1, A2 && a2) {
+      ::new (static_cast<void*>(p)) U(std::forward<A1>(a1), std::forward<A2>(a2));
+    }
+
+    template<class U, class A1, class A2, class A3>
+    void construct(U* p, A1 && a1, A2 && a2, A3 && a3) {
+      ::new (static_cast<void*>(p)) U(std::forward<A1>(a1), std::forward<A2>(a2), std::forward<A3>(a3));
+    }
+
+    template<class U>
+    void destroy(U* p) {
+      p->~U();
+    }
+
+    //! Containers copied with the allocator keep using the same resource
+    polymorphic_allocator select_on_container_copy_construction() const EASY_NOEXCEPT {
+      return *this;
+    }
+
+    memory_resource* resource() const EASY_NOEXCEPT {
+      return m_presource;
+    }
+
+  private:
+    memory_resource* m_presource;
+  };
+
+  template<class T, class U>
+  bool operator == (const polymorphic_allocator<T>& a, const polymorphic_allocator<U>& b) EASY_NOEXCEPT {
+    return *a.resource() == *b.resource();
+  }
+
+  template<class T, class U>
+  bool operator != (const polymorphic_allocator<T>& a, const polymorphic_allocator<U>& b) EASY_NOEXCEPT {
+    return !(a == b);
+  }
+
+  namespace detail
+  {
+    inline size_t align_up(size_t n, size_t alignment) EASY_NOEXCEPT {
+      EASY_ASSERT(alignment && (alignment & (alignment - 1)) == 0);
+      return (n + alignment - 1) & ~(alignment - 1);
+    }
+  }
+}}
+
+#endif
@@ -0,0 +1,74 @@
+/*!
+ *  @file   easy/memory/pool.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_MEMORY_POOL_H_INCLUDED
+#define EASY_MEMORY_POOL_H_INCLUDED
+
+#include <easy/memory/memory_resource.h>
+
+#include <boost/noncopyable.hpp>
+
+namespace easy {
+namespace memory
+{
+  //! Resource of fixed size blocks, suits node based containers and objects of one type.
+  //! Freed blocks are kept in a free list and reused, the chunks are returned to the upstream
+  //! resource by release() or the destructor. Allocations bigger than the block size or
+  //! aligned stricter than max_align go to the upstream resource. The pool is not thread safe.
+  class fixed_pool
+    : public memory_resource
+    , boost::noncopyable
+  {
+  public:
+    static const size_t default_blocks_per_chunk = 256;
+
+    //! The block size is rounded up to a multiple of max_align
+    explicit fixed_pool(size_t block_size,
+      size_t blocks_per_chunk = default_blocks_per_chunk,
+      memory_resource* pupstream = new_delete_resource());
+
+    ~fixed_pool() EASY_NOEXCEPT;
+
+    //! Frees all the blocks at once
+    void release() EASY_NOEXCEPT;
+
+    size_t block_size() const EASY_NOEXCEPT;
+
+    //! Number of blocks allocated and not deallocated yet
+    size_t used_blocks() const EASY_NOEXCEPT;
+
+    //! Bytes of the chunks allocated from the upstream resource
+    size_t reserved_bytes() const EASY_NOEXCEPT;
+
+    memory_resource* upstream_resource() const EASY_NOEXCEPT;
+
+  protected:
+    virtual void* do_allocate(size_t bytes, size_t alignment) EASY_OVERRIDE;
+    virtual void do_deallocate(void* p, size_t bytes, size_t alignment) EASY_OVERRIDE;
+
+  private:
+    struct free_block {
+      free_block* pnext;
+    };
+
+    struct chunk_header;
+
+    bool is_pooled(size_t bytes, size_t alignment) const EASY_NOEXCEPT;
+    void add_chunk();
+
+  private:
+    memory_resource* m_pupstream;
+    size_t m_block_size;
+    size_t m_blocks_per_chunk;
+
+    chunk_header* m_pchunks;
+    free_block* m_pfree;
+
+    size_t m_used_blocks;
+    size_t m_reserved_bytes;
+  };
+}}
+
+#endif
@@ -0,0 +1,102 @@
+/*!
+ *  @file   easy/memory/thread_cache.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_MEMORY_THREAD_CACHE_H_INCLUDED
+#define EASY_MEMORY_THREAD_CACHE_H_INCLUDED
+
+#include <easy/memory/memory_resource.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace easy {
+namespace memory
+{
+  //! Thread safe resource of small blocks with a cache of free blocks per thread.
+  //!
+  //! Allocations up to max_cached_size bytes are rounded up to a power of two size class
+  //! and served from the cache of the calling thread without locking. Empty caches are
+  //! refilled and overfilled ones are drained in batches through a shared list under a lock.
+  //! A block may be deallocated by any thread. Bigger allocations go to the upstream
+  //! resource under the lock.
+  //!
+  //! The memory of the small blocks and the caches of finished threads are returned
+  //! to the upstream resource only by the destructor.
+  class thread_cache_resource
+    : public memory_resource
+    , boost::noncopyable
+  {
+  public:
+    static const size_t min_cached_size = 16;
+    static const size_t max_cached_size = 1024;
+
+    explicit thread_cache_resource(memory_resource* pupstream = new_delete_resource());
+    ~thread_cache_resource() EASY_NOEXCEPT;
+
+    memory_resource* upstream_resource() const EASY_NOEXCEPT;
+
+  protected:
+    virtual void* do_allocate(size_t bytes, size_t alignment) EASY_OVERRIDE;
+    virtual void do_deallocate(void* p, size_t bytes, size_t alignment) EASY_OVERRIDE;
+
+  private:
+    static const size_t class_count = 7; // 16, 32, ... 1024
+
+    struct free_block {
+      free_block* pnext;
+    };
+
+    struct free_list
+    {
+      free_list() EASY_NOEXCEPT
+        : phead(nullptr), count(0) {
+      }
+
+      void push(void* p) EASY_NOEXCEPT {
+        free_block* pblock = static_cast<free_block*>(p);
+        pblock->pnext = phead;
+        phead = pblock;
+        ++count;
+      }
+
+      void* pop() EASY_NOEXCEPT {
+        free_block* pblock = phead;
+        phead = pblock->pnext;
+        --count;
+        return pblock;
+      }
+
+      free_block* phead;
+      size_t count;
+    };
+
+    struct thread_cache {
+      free_list lists[class_count];
+    };
+
+    static size_t get_class(size_t bytes) EASY_NOEXCEPT;
+    static size_t get_class_size(size_t size_class) EASY_NOEXCEPT;
+    static size_t get_batch_size(size_t size_class) EASY_NOEXCEPT;
+
+    thread_cache& get_cache();
+    void refill(free_list& list, size_t size_class);
+    void drain(free_list& list, size_t size_class) EASY_NOEXCEPT;
+
+  private:
+    memory_resource* m_pupstream;
+    unsigned long long m_id; // never reused, so stale thread local pointers do not match
+
+    std::mutex m_mutex;
+    free_list m_shared[class_count];
+    std::vector<void*> m_chunks;
+    std::map<std::thread::id, thread_cache*> m_caches;
+  };
+}}
+
+#endif
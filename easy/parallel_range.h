@@ -0,0 +1,320 @@
+/*!
+ *  @file   easy/parallel_range.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  Enumeration overlapped with processing. prefetch runs a slow enumerator on a background
+ *  thread which fills a bounded ring ahead of the consumer:
+ *
+ *    for (const auto& key : easy::make_range(easy::prefetch(key.enum_sub_keys())))
+ *      process(key);
+ *
+ *  parallel_for_each also spreads the values across worker threads:
+ *
+ *    easy::parallel_for_each(easy::prefetch(std::move(files)), [](file_info& f) { hash(f); });
+ *
+ *  The source is called from the background thread only, so it must not be bound to the
+ *  thread which created it, and its values must not refer to its state, which rules out
+ *  e.g. sqlite rows with text and blob views.
+ */
+#ifndef EASY_PARALLEL_RANGE_H_INCLUDED
+#define EASY_PARALLEL_RANGE_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/range.h>
+#include <easy/scope.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace easy
+{
+  //! Enumerates the values of the source read ahead by a background thread.
+  //!
+  //! The thread and the consumer exchange values through a single producer single consumer
+  //! ring without locks. A side takes the mutex only to sleep when the ring is full or empty.
+  //! The source error is reported after the values read before it
+  template<class Value>
+  class prefetching_enumerator
+    : public enumerator<Value>
+    , boost::noncopyable
+  {
+  public:
+    typedef typename enumerator<Value>::result_type result_type;
+    typedef std::unique_ptr<enumerator<Value>> source_ptr;
+
+    //! Default number of values read ahead
+    static const size_t default_capacity = 256;
+
+    //! Starts the thread reading the source
+    explicit prefetching_enumerator(source_ptr && source, size_t capacity = default_capacity)
+      : m_source(std::move(source))
+      , m_capacity(std::max<size_t>(capacity, 1))
+      , m_ring(new result_type[m_capacity])
+      , m_head(0)
+      , m_tail(0)
+      , m_finished(false)
+      , m_stopped(false)
+      , m_producer_sleeping(false)
+      , m_consumer_sleeping(false)
+    {
+      m_thread = std::thread(&prefetching_enumerator::run, this);
+    }
+
+    //! Stops the thread. A call to the source in progress is waited for
+    ~prefetching_enumerator() EASY_NOEXCEPT {
+      m_stopped = true;
+      wake(m_producer_sleeping);
+      if (m_thread.joinable())
+        m_thread.join();
+    }
+
+    virtual result_type get_next(error_code_ref ec = nullptr) EASY_OVERRIDE {
+      if (!wait_values(ec))
+        return result_type();
+      result_type value = std::move(m_ring[m_head % m_capacity]);
+      m_ring[m_head % m_capacity] = boost::none;
+      release(1);
+      return value;
+    }
+
+    virtual size_t get_next_batch(result_type* pvalues, size_t count, error_code_ref ec = nullptr) EASY_OVERRIDE {
+      const size_t available = wait_values(ec);
+      const size_t size = std::min(available, count);
+      const size_t head = m_head;
+      for (size_t i = 0; i < size; ++i) {
+        result_type& slot = m_ring[(head + i) % m_capacity];
+        pvalues[i] = boost::none;
+        pvalues[i] = std::move(slot);
+        slot = boost::none;
+      }
+      if (size)
+        release(size);
+      return size;
+    }
+
+  private:
+    //! Returns the number of ready values, 0 at the end of the source
+    size_t wait_values(error_code_ref ec) {
+      size_t available = m_tail - m_head;
+      if (!available) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_consumer_sleeping = true;
+        // the producer sets m_tail before it checks the flag, so the wakeup cannot be lost
+        while (!(available = m_tail - m_head) && !m_finished)
+          m_cond.wait(lock);
+        m_consumer_sleeping = false;
+        // the values pushed before m_finished are counted in the last load of m_tail
+        if (!available)
+          available = m_tail - m_head;
+      }
+      if (!available && m_error)
+        ec.forward(m_error);
+      return available;
+    }
+
+    void release(size_t count) {
+      m_head += count;
+      wake(m_producer_sleeping);
+    }
+
+    void wake(const std::atomic<bool>& sleeping) {
+      if (sleeping) {
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_cond.notify_all();
+      }
+    }
+
+    //! Returns the number of free slots, 0 when stopped
+    size_t wait_space() {
+      size_t space = m_capacity - (m_tail - m_head);
+      if (!space) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_producer_sleeping = true;
+        while (!(space = m_capacity - (m_tail - m_head)) && !m_stopped)
+          m_cond.wait(lock);
+        m_producer_sleeping = false;
+      }
+      return m_stopped ? 0 : space;
+    }
+
+    void run() EASY_NOEXCEPT {
+      error_code error;
+      try {
+        for (size_t space; (space = wait_space()) != 0; ) {
+          // the source fills the free slots up to the end of the ring in place
+          const size_t tail = m_tail;
+          const size_t count = std::min(space, m_capacity - tail % m_capacity);
+          const size_t size = m_source->get_next_batch(&m_ring[tail % m_capacity], count, error);
+          if (!size)
+            break;
+          m_tail = tail + size;
+          wake(m_consumer_sleeping);
+        }
+      }
+      catch (const system_error& e) {
+        error = e.code();
+      }
+      catch (...) {
+        error = make_error_code(generic_error::unexpected);
+      }
+      m_error = error;
+      m_finished = true;
+      wake(m_consumer_sleeping);
+    }
+
+  private:
+    source_ptr m_source;
+    const size_t m_capacity;
+    std::unique_ptr<result_type[]> m_ring;
+
+    std::atomic<size_t> m_head;   // consumed values, written by the consumer only
+    std::atomic<size_t> m_tail;   // produced values, written by the producer only
+    std::atomic<bool> m_finished; // m_error is set before
+    std::atomic<bool> m_stopped;
+    std::atomic<bool> m_producer_sleeping;
+    std::atomic<bool> m_consumer_sleeping;
+    error_code m_error;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+  };
+
+  template<class Value>
+  const size_t prefetching_enumerator<Value>::default_capacity;
+
+  //! Reads the source ahead on a background thread
+  template<class Value>
+  std::unique_ptr<enumerator<Value>> prefetch(std::unique_ptr<enumerator<Value>> && source,
+    size_t capacity = prefetching_enumerator<Value>::default_capacity)
+  {
+    return std::unique_ptr<enumerator<Value>>(new prefetching_enumerator<Value>(std::move(source), capacity));
+  }
+
+  namespace detail
+  {
+    //! Values shared by the workers of parallel_for_each
+    template<class Value, class Func>
+    class parallel_loop
+      : boost::noncopyable
+    {
+    public:
+      typedef typename enumerator<Value>::result_type result_type;
+
+      //! Values taken at once by a worker
+      static const size_t batch_size = 8;
+
+      parallel_loop(enumerator<Value>& source, Func& func)
+        : m_source(source), m_func(func), m_stopped(false), m_failed(false) {
+      }
+
+      void run() EASY_NOEXCEPT {
+        result_type values[batch_size];
+        try {
+          for (;;) {
+            const size_t size = take(values);
+            if (!size)
+              break;
+            for (size_t i = 0; i < size && !m_failed; ++i)
+              m_func(*values[i]);
+          }
+        }
+        catch (...) {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          if (!m_exception)
+            m_exception = std::current_exception();
+          m_stopped = true;
+          m_failed = true;
+        }
+      }
+
+      //! Makes the workers take no more values
+      void stop() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+      }
+
+      //! Reports the source error or rethrows the first exception of the function
+      void finish(error_code_ref ec) {
+        if (m_exception)
+          std::rethrow_exception(m_exception);
+        if (m_error)
+          ec.forward(m_error);
+      }
+
+    private:
+      size_t take(result_type* pvalues) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopped)
+          return 0;
+        const size_t size = m_source.get_next_batch(pvalues, batch_size, m_error);
+        if (!size)
+          m_stopped = true;
+        return size;
+      }
+
+    private:
+      enumerator<Value>& m_source;
+      Func& m_func;
+      std::mutex m_mutex;     // guards the source and the results
+      bool m_stopped;         // no more values are taken
+      std::atomic<bool> m_failed;
+      error_code m_error;
+      std::exception_ptr m_exception;
+    };
+
+    template<class Value, class Func>
+    const size_t parallel_loop<Value, Func>::batch_size;
+  }
+
+  //! Calls the function for each value of the source on several threads, the calling one among
+  //! them, and returns when all the calls are completed. The function gets values by reference
+  //! and may move them out; it is called concurrently, in no particular order.
+  //!
+  //! Idle workers take the next few values from the source, so slow values do not hold
+  //! the others up. After an exception of the function no more values are taken and the
+  //! first exception is rethrown. The source error is reported through ec
+  template<class Value, class Func>
+  void parallel_for_each(std::unique_ptr<enumerator<Value>> && source, Func func,
+    size_t threads = std::thread::hardware_concurrency(), error_code_ref ec = nullptr)
+  {
+    if (!source)
+      return;
+
+    detail::parallel_loop<Value, Func> loop(*source, func);
+    // reserved, so adding a started worker does not throw
+    std::vector<std::thread> workers;
+    workers.reserve(threads > 1 ? threads - 1 : 0);
+    {
+      // the workers started before a thread fails to start must be joined before they are destroyed
+      bool started = false;
+      scope_exit join_started([&]() {
+        if (started)
+          return;
+        loop.stop();
+        for (size_t i = 0; i < workers.size(); ++i)
+          workers[i].join();
+      });
+      for (size_t i = 1; i < threads; ++i)
+        workers.push_back(std::thread(&detail::parallel_loop<Value, Func>::run, &loop));
+      started = true;
+    }
+    loop.run();
+    for (size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+    loop.finish(ec);
+  }
+}
+
+#endif
@@ -9,11 +9,13 @@
 #include <easy/config.h>
 
 #include <easy/error_handling.h>
+#include <easy/memory/memory_resource.h>
 
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/optional.hpp>
+#include <boost/noncopyable.hpp>
 
-
+#include <memory>
 #include <type_traits>
 
 
@@ -70,6 +72,61 @@ namespace easy
 
     //! Main enumeration function. Must be implemented in derived class.
     virtual result_type get_next(error_code_ref ec = nullptr) = 0;
+
+    //! Fills up to count values at once, so ranges pay one virtual call per batch rather than
+    //! per value. Returns the number of filled values, 0 at the end or on error.
+    //!
+    //! The default implementation returns a single value, because values of some enumerators
+    //! refer to the enumerator state and are invalidated by the next call. Enumerators of
+    //! independent values opt in to reading ahead by deriving from batch_enumerator
+    virtual size_t get_next_batch(result_type* pvalues, size_t count, error_code_ref ec = nullptr) {
+      EASY_ASSERT(count > 0);
+      (void)count;
+      // the slot is emptied first, so the value is move constructed rather than assigned
+      pvalues[0] = boost::none;
+      pvalues[0] = get_next(ec);
+      return pvalues[0] ? 1 : 0;
+    }
+  };
+
+  //! Base of enumerators whose values stay valid after the next call. Fills whole batches by
+  //! calling Derived::get_next, which is bound statically, so the values are moved into the
+  //! batch without any virtual call per value. An error met after some values is reported by
+  //! the next call, so the values read before it are not lost
+  template<class Derived, class Value>
+  struct batch_enumerator
+    : enumerator<Value>
+  {
+    typedef typename enumerator<Value>::result_type result_type;
+
+    virtual size_t get_next_batch(result_type* pvalues, size_t count, error_code_ref ec = nullptr) EASY_OVERRIDE {
+      if (m_error) {
+        ec.forward(m_error);
+        m_error.clear();
+        return 0;
+      }
+
+      // a local code, so a throwing ec does not throw away the filled values
+      Derived* pderived = static_cast<Derived*>(this);
+      error_code next_ec;
+      size_t filled = 0;
+      for (; filled < count; ++filled) {
+        pvalues[filled] = boost::none;
+        pvalues[filled] = pderived->Derived::get_next(next_ec);
+        if (!pvalues[filled] || next_ec)
+          break;
+      }
+      if (next_ec) {
+        if (filled)
+          m_error = next_ec;
+        else
+          ec.forward(next_ec);
+      }
+      return filled;
+    }
+
+  private:
+    error_code m_error;
   };
 
   namespace detail
@@ -89,59 +146,106 @@ namespace easy
 
       forward_iterator_base() EASY_NOEXCEPT { }
 
+      forward_iterator_base(const forward_iterator_base& r) EASY_NOEXCEPT
+        : m_cursor_ptr(r.m_cursor_ptr)
+      {
+      }
+
       forward_iterator_base(forward_iterator_base && r) EASY_NOEXCEPT
-        : m_pimpl(std::move(r.m_pimpl)) 
-        , m_op_value(std::move(r.m_op_value))
+        : m_cursor_ptr(std::move(r.m_cursor_ptr)) 
       {
       }
 
+      forward_iterator_base& operator = (const forward_iterator_base& r) EASY_NOEXCEPT {
+        m_cursor_ptr = r.m_cursor_ptr;
+        return *this;
+      }
+
       forward_iterator_base& operator = (forward_iterator_base && r) EASY_NOEXCEPT {
-        if (&r != this) {
-          m_pimpl = std::move(r.m_pimpl);
-          m_op_value = std::move(r.m_op_value);
-        }
+        if (&r != this)
+          m_cursor_ptr = std::move(r.m_cursor_ptr);
         return *this;
       }
 
       forward_iterator_base(enum_ptr && r, error_code_ref ec)
-        : m_pimpl(std::forward<enum_ptr>(r)) 
       {
-        if (m_pimpl)
-          m_op_value = m_pimpl->get_next(ec);
-        if (!m_op_value)
-          m_pimpl.reset();
+        if (r) {
+          m_cursor_ptr = std::make_shared<cursor>(std::forward<enum_ptr>(r));
+          start(ec);
+        }
+      }
+
+      //! The cursor is allocated from the resource
+      forward_iterator_base(enum_ptr && r, memory::memory_resource* presource, error_code_ref ec)
+      {
+        if (r) {
+          m_cursor_ptr = std::allocate_shared<cursor>(memory::polymorphic_allocator<cursor>(presource), std::forward<enum_ptr>(r));
+          start(ec);
+        }
       }
 
     private:
       friend class boost::iterator_core_access;
 
+      typedef typename forward_iterator_base::iterator_facade_::reference reference;
+
+      void start(error_code_ref ec) {
+        fetch(ec);
+      }
+
       void increment() {
-        EASY_ASSERT(m_pimpl && m_op_value);
-        error_code ec;
-        m_op_value = m_pimpl->get_next(ec);
-        EASY_ASSERT(!ec);
-        if (!m_op_value)
-          m_pimpl.reset();
+        EASY_ASSERT(!is_end());
+        if (++m_cursor_ptr->index == m_cursor_ptr->count) {
+          error_code ec;
+          fetch(ec);
+          EASY_ASSERT(!ec);
+        }
+      }
+
+      void fetch(error_code_ref ec) {
+        cursor& c = *m_cursor_ptr;
+        c.index = 0;
+        c.count = c.source->get_next_batch(c.values, cursor::batch_size, ec);
+        if (!c.count)
+          m_cursor_ptr.reset();
       }
 
       bool equal(const forward_iterator_base& other) const EASY_NOEXCEPT {
-        if (m_pimpl == other.m_pimpl)
-          return true;
-        if ((!m_op_value || !m_pimpl) && (!other.m_op_value || !other.m_pimpl))
+        if (m_cursor_ptr == other.m_cursor_ptr)
           return true;
-        return false;
+        return is_end() && other.is_end();
+      }
+
+      bool is_end() const EASY_NOEXCEPT {
+        return !m_cursor_ptr || m_cursor_ptr->index >= m_cursor_ptr->count;
       }
 
       reference dereference() const {
-        EASY_TEST_BOOL(m_pimpl && m_op_value);
-        return m_op_value.get();
+        EASY_TEST_BOOL(!is_end());
+        return m_cursor_ptr->values[m_cursor_ptr->index].get();
       }
 
     private:
       typedef typename enum_type::result_type result_type;
+
+      //! Enumeration position shared between copies of the iterator, so values
+      //! are neither copied nor required to be copyable. The batch is reused for every fetch
+      struct cursor
+        : boost::noncopyable
+      {
+        static const size_t batch_size = 16;
+
+        explicit cursor(enum_ptr && p)
+          : source(std::forward<enum_ptr>(p)), index(0), count(0) {
+        }
+
+        enum_ptr source;
+        result_type values[batch_size];
+        size_t index;
+        size_t count;
+      };
     private:
-      enum_ptr m_pimpl;
-      result_type m_op_value;
+      std::shared_ptr<cursor> m_cursor_ptr;
     };
 
     template<class Value>
@@ -152,7 +256,11 @@ namespace easy
       typedef forward_iterator_base<Value> iterator_type;
 
       range(typename iterator_type::enum_ptr && v, error_code_ref ec)
-        : m_begin(std::forward<iterator_type::enum_ptr>(v), ec) {
+        : m_begin(std::forward<typename iterator_type::enum_ptr>(v), ec) {
+      }
+
+      range(typename iterator_type::enum_ptr && v, memory::memory_resource* presource, error_code_ref ec)
+        : m_begin(std::forward<typename iterator_type::enum_ptr>(v), presource, ec) {
       }
 
       range(range && r)
@@ -180,6 +288,23 @@ namespace easy
     return detail::range<Value>(std::forward<std::unique_ptr<enumerator<Value>>>(enum_ptr), ec);
   }
 
+  //! Creates iterator range from any class derived from enumerator<T>. The bookkeeping of the range
+  //! is allocated from the resource, which must outlive the range and its iterators
+  template<class Value>
+  detail::range<Value> make_range(std::unique_ptr<enumerator<Value>> && enum_ptr, memory::memory_resource& resource, error_code_ref ec = nullptr)
+  {
+    typedef enumerator<Value> enum_type;
+    typedef typename detail::range<Value>::iterator_type::enum_ptr enum_ptr_type;
+
+    enum_ptr_type shared_ptr;
+    if (enum_ptr) {
+      // the shared control block comes from the resource as well
+      shared_ptr = enum_ptr_type(enum_ptr.get(), std::default_delete<enum_type>(), memory::polymorphic_allocator<enum_type>(&resource));
+      enum_ptr.release();
+    }
+    return detail::range<Value>(std::move(shared_ptr), &resource, ec);
+  }
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,358 @@
+/*!
+ *  @file   easy/range_adaptors.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  Lazy adaptors over enumerators. Each one takes enumerators and returns a new one, so they
+ *  nest into a pipeline which make_range walks in a single loop:
+ *
+ *    auto names = easy::transform(
+ *      easy::take(easy::filter(std::move(enum_ptr), is_visible), 100),
+ *      [](const item& i) { return i.name; });
+ *    for (const auto& name : easy::make_range(std::move(names)))
+ *      ...
+ *
+ *  Values are pulled from the sources on demand and moved through the pipeline,
+ *  nothing is collected except by chunk. Errors of the sources are passed through.
+ *  Filter, take, skip, transform and concat forward batches, so they read ahead
+ *  exactly when their sources do.
+ */
+#ifndef EASY_RANGE_ADAPTORS_H_INCLUDED
+#define EASY_RANGE_ADAPTORS_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/range.h>
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace easy
+{
+  namespace detail
+  {
+    template<class Value, class Pred>
+    class filter_enumerator
+      : public enumerator<Value>
+    {
+    public:
+      typedef typename enumerator<Value>::result_type result_type;
+      typedef std::unique_ptr<enumerator<Value>> source_ptr;
+
+      filter_enumerator(source_ptr && source, Pred pred)
+        : m_source(std::move(source)), m_pred(pred) {
+      }
+
+      virtual result_type get_next(error_code_ref ec = nullptr) EASY_OVERRIDE {
+        for (;;) {
+          result_type value = m_source->get_next(ec);
+          if (!value || m_pred(*value))
+            return value;
+        }
+      }
+
+      virtual size_t get_next_batch(result_type* pvalues, size_t count, error_code_ref ec = nullptr) EASY_OVERRIDE {
+        for (;;) {
+          const size_t size = m_source->get_next_batch(pvalues, count, ec);
+          if (!size)
+            return 0;
+          // the accepted values are packed to the front of the batch
+          size_t accepted = 0;
+          for (size_t i = 0; i < size; ++i) {
+            if (!m_pred(*pvalues[i]))
+              continue;
+            if (accepted != i) {
+              pvalues[accepted] = boost::none;
+              pvalues[accepted] = std::move(pvalues[i]);
+            }
+            ++accepted;
+          }
+          if (accepted)
+            return accepted;
+        }
+      }
+
+    private:
+      source_ptr m_source;
+      Pred m_pred;
+    };
+
+    template<class Value, class Func>
+    struct transform_result
+    {
+      typedef typename std::decay<typename std::result_of<Func(Value&&)>::type>::type type;
+    };
+
+    template<class Value, class Func>
+    class transform_enumerator
+      : public enumerator<typename transform_result<Value, Func>::type>
+    {
+    public:
+      typedef typename enumerator<typename transform_result<Value, Func>::type>::result_type result_type;
+      typedef std::unique_ptr<enumerator<Value>> source_ptr;
+
+      transform_enumerator(source_ptr && source, Func func)
+        : m_source(std::move(source)), m_func(func) {
+      }
+
+      virtual result_type get_next(error_code_ref ec = nullptr) EASY_OVERRIDE {
+        m_batch[0] = m_source->get_next(ec);
+        if (!m_batch[0])
+          return result_type();
+        return result_type(m_func(std::move(*m_batch[0])));
+      }
+
+      virtual size_t get_next_batch(result_type* pvalues, size_t count, error_code_ref ec = nullptr) EASY_OVERRIDE {
+        const size_t size = m_source->get_next_batch(m_batch, std::min(count, batch_size), ec);
+        for (size_t i = 0; i < size; ++i) {
+          pvalues[i] = boost::none;
+          pvalues[i] = m_func(std::move(*m_batch[i]));
+        }
+        return size;
+      }
+
+    private:
+      static const size_t batch_size = 16;
+
+      source_ptr m_source;
+      Func m_func;
+      // the source values live until the next call, as results may refer to them
+      typename enumerator<Value>::result_type m_batch[batch_size];
+    };
+
+    template<class Value, class Func>
+    const size_t transform_enumerator<Value, Func>::batch_size;
+
+    template<class Value>
+    class take_enumerator
+      : public enumerator<Value>
+    {
+    public:
+      typedef typename enumerator<Value>::result_type result_type;
+      typedef std::unique_ptr<enumerator<Value>> source_ptr;
+
+      take_enumerator(source_ptr && source, size_t count)
+        : m_source(std::move(source)), m_remaining(count) {
+      }
+
+      virtual result_type get_next(error_code_ref ec = nullptr) EASY_OVERRIDE {
+        if (!m_remaining)
+          return result_type();
+        result_type value = m_source->get_next(ec);
+        if (value)
+          --m_remaining;
+        return value;
+      }
+
+      virtual size_t get_next_batch(result_type* pvalues, size_t count, error_code_ref ec = nullptr) EASY_OVERRIDE {
+        if (!m_remaining)
+          return 0;
+        const size_t size = m_source->get_next_batch(pvalues, std::min(count, m_remaining), ec);
+        m_remaining -= size;
+        return size;
+      }
+
+    private:
+      source_ptr m_source;
+      size_t m_remaining;
+    };
+
+    template<class Value>
+    class skip_enumerator
+      : public enumerator<Value>
+    {
+    public:
+      typedef typename enumerator<Value>::result_type result_type;
+      typedef std::unique_ptr<enumerator<Value>> source_ptr;
+
+      skip_enumerator(source_ptr && source, size_t count)
+        : m_source(std::move(source)), m_count(count) {
+      }
+
+      virtual result_type get_next(error_code_ref ec = nullptr) EASY_OVERRIDE {
+        if (!skip(ec))
+          return result_type();
+        return m_source->get_next(ec);
+      }
+
+      virtual size_t get_next_batch(result_type* pvalues, size_t count, error_code_ref ec = nullptr) EASY_OVERRIDE {
+        if (!skip(ec))
+          return 0;
+        return m_source->get_next_batch(pvalues, count, ec);
+      }
+
+    private:
+      bool skip(error_code_ref ec) {
+        while (m_count) {
+          if (!m_source->get_next(ec))
+            return false;
+          --m_count;
+        }
+        return true;
+      }
+
+    private:
+      source_ptr m_source;
+      size_t m_count;
+    };
+
+    //! The chunks own their values, so they are read ahead
+    template<class Value>
+    class chunk_enumerator
+      : public batch_enumerator<chunk_enumerator<Value>, std::vector<Value>>
+    {
+    public:
+      typedef typename enumerator<std::vector<Value>>::result_type result_type;
+      typedef std::unique_ptr<enumerator<Value>> source_ptr;
+
+      chunk_enumerator(source_ptr && source, size_t size)
+        : m_source(std::move(source)), m_size(size) {
+        EASY_ASSERT(size > 0);
+      }
+
+      virtual result_type get_next(error_code_ref ec = nullptr) EASY_OVERRIDE {
+        std::vector<Value> chunk;
+        while (chunk.size() < m_size) {
+          typename enumerator<Value>::result_type value = m_source->get_next(ec);
+          if (!value) {
+            if (ec)
+              return result_type();
+            break;
+          }
+          if (chunk.empty())
+            chunk.reserve(m_size);
+          chunk.push_back(std::move(*value));
+        }
+        if (chunk.empty())
+          return result_type();
+        return result_type(std::move(chunk));
+      }
+
+    private:
+      source_ptr m_source;
+      size_t m_size;
+    };
+
+    template<class Value>
+    class concat_enumerator
+      : public enumerator<Value>
+    {
+    public:
+      typedef typename enumerator<Value>::result_type result_type;
+      typedef std::unique_ptr<enumerator<Value>> source_ptr;
+
+      concat_enumerator(source_ptr && first, source_ptr && second)
+        : m_first(std::move(first)), m_second(std::move(second)) {
+      }
+
+      virtual result_type get_next(error_code_ref ec = nullptr) EASY_OVERRIDE {
+        if (m_first) {
+          result_type value = m_first->get_next(ec);
+          if (value || ec)
+            return value;
+          m_first.reset();
+        }
+        return m_second->get_next(ec);
+      }
+
+      virtual size_t get_next_batch(result_type* pvalues, size_t count, error_code_ref ec = nullptr) EASY_OVERRIDE {
+        if (m_first) {
+          const size_t size = m_first->get_next_batch(pvalues, count, ec);
+          if (size || ec)
+            return size;
+          m_first.reset();
+        }
+        return m_second->get_next_batch(pvalues, count, ec);
+      }
+
+    private:
+      source_ptr m_first;   // released when exhausted
+      source_ptr m_second;
+    };
+
+    template<class Value1, class Value2>
+    class zip_enumerator
+      : public enumerator<std::pair<Value1, Value2>>
+    {
+    public:
+      typedef std::pair<Value1, Value2> value_type;
+      typedef typename enumerator<value_type>::result_type result_type;
+
+      zip_enumerator(std::unique_ptr<enumerator<Value1>> && first, std::unique_ptr<enumerator<Value2>> && second)
+        : m_first(std::move(first)), m_second(std::move(second)) {
+      }
+
+      virtual result_type get_next(error_code_ref ec = nullptr) EASY_OVERRIDE {
+        typename enumerator<Value1>::result_type value1 = m_first->get_next(ec);
+        if (!value1)
+          return result_type();
+        typename enumerator<Value2>::result_type value2 = m_second->get_next(ec);
+        if (!value2)
+          return result_type();
+        return result_type(value_type(std::move(*value1), std::move(*value2)));
+      }
+
+    private:
+      std::unique_ptr<enumerator<Value1>> m_first;
+      std::unique_ptr<enumerator<Value2>> m_second;
+    };
+  }
+
+  //! Enumerates the values satisfying the predicate
+  template<class Value, class Pred>
+  std::unique_ptr<enumerator<Value>> filter(std::unique_ptr<enumerator<Value>> && source, Pred pred)
+  {
+    return std::unique_ptr<enumerator<Value>>(new detail::filter_enumerator<Value, Pred>(std::move(source), pred));
+  }
+
+  //! Enumerates the results of the function. The source values are passed as rvalues, so the
+  //! function may move them out. A result may refer to its source value until the next value
+  template<class Value, class Func>
+  std::unique_ptr<enumerator<typename detail::transform_result<Value, Func>::type>>
+    transform(std::unique_ptr<enumerator<Value>> && source, Func func)
+  {
+    typedef typename detail::transform_result<Value, Func>::type result_type;
+    return std::unique_ptr<enumerator<result_type>>(new detail::transform_enumerator<Value, Func>(std::move(source), func));
+  }
+
+  //! Enumerates the first count values. The source is not called after the last of them
+  template<class Value>
+  std::unique_ptr<enumerator<Value>> take(std::unique_ptr<enumerator<Value>> && source, size_t count)
+  {
+    return std::unique_ptr<enumerator<Value>>(new detail::take_enumerator<Value>(std::move(source), count));
+  }
+
+  //! Enumerates the values after the first count ones
+  template<class Value>
+  std::unique_ptr<enumerator<Value>> skip(std::unique_ptr<enumerator<Value>> && source, size_t count)
+  {
+    return std::unique_ptr<enumerator<Value>>(new detail::skip_enumerator<Value>(std::move(source), count));
+  }
+
+  //! Enumerates vectors of size values, the last one may be shorter.
+  //! The values are moved into the vectors, so they must not refer to the source state
+  template<class Value>
+  std::unique_ptr<enumerator<std::vector<Value>>> chunk(std::unique_ptr<enumerator<Value>> && source, size_t size)
+  {
+    return std::unique_ptr<enumerator<std::vector<Value>>>(new detail::chunk_enumerator<Value>(std::move(source), size));
+  }
+
+  //! Enumerates the values of the first source, then of the second
+  template<class Value>
+  std::unique_ptr<enumerator<Value>> concat(std::unique_ptr<enumerator<Value>> && first, std::unique_ptr<enumerator<Value>> && second)
+  {
+    return std::unique_ptr<enumerator<Value>>(new detail::concat_enumerator<Value>(std::move(first), std::move(second)));
+  }
+
+  //! Enumerates pairs of values of both sources, up to the end of the shorter one
+  template<class Value1, class Value2>
+  std::unique_ptr<enumerator<std::pair<Value1, Value2>>> zip(std::unique_ptr<enumerator<Value1>> && first, std::unique_ptr<enumerator<Value2>> && second)
+  {
+    typedef std::pair<Value1, Value2> value_type;
+    return std::unique_ptr<enumerator<value_type>>(new detail::zip_enumerator<Value1, Value2>(std::move(first), std::move(second)));
+  }
+}
+
+#endif
@@ -0,0 +1,294 @@
+/*!
+ *  @file   easy/result.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  Value or error returned together:
+ *
+ *    easy::result<int> parse_port(const easy::lite_string& s)
+ *    {
+ *      easy::error_code ec;
+ *      const int port = easy::parse<int>(s, ec);
+ *      if (ec)
+ *        return ec;
+ *      if (port <= 0 || port > 65535)
+ *        return easy::generic_error::out_of_range;
+ *      return port;
+ *    }
+ *
+ *    auto port = parse_port(value);
+ *    if (!port)
+ *      log(port.error());
+ *
+ *  The value and the error share the storage, so a result is as big as the larger of them and
+ *  a flag. Nothing is thrown unless value() is called for an error.
+ */
+#ifndef EASY_RESULT_H_INCLUDED
+#define EASY_RESULT_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/error_handling.h>
+#include <easy/safe_bool.h>
+
+#include <boost/utility/enable_if.hpp>
+
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace easy
+{
+  //! Holds either a value or the error which prevented it
+  template<class T>
+  class result
+    : public safe_bool<result<T>>
+  {
+  public:
+    typedef T value_type;
+
+    result(const value_type& value)
+      : m_has_value(true) {
+      new (&m_storage) value_type(value);
+    }
+
+    result(value_type&& value)
+      : m_has_value(true) {
+      new (&m_storage) value_type(std::move(value));
+    }
+
+    //! The code must be an error. It is taken as already reported through error_code_ref,
+    //! so EASY_ERROR_TELEMETRY does not count it here
+    result(const error_code& ec) EASY_NOEXCEPT
+      : m_has_value(false) {
+      EASY_ASSERT(ec);
+      new (&m_storage) error_code(ec);
+    }
+
+    //! Takes an error code enumeration, e.g. generic_error. The error is new, so EASY_ERROR_TELEMETRY counts it
+    template<class ErrorEnum>
+    result(ErrorEnum e, typename boost::enable_if<boost::system::is_error_code_enum<ErrorEnum>>::type* = nullptr) EASY_NOEXCEPT
+      : m_has_value(false) {
+      new (&m_storage) error_code(make_error_code(e));
+      EASY_ASSERT(error_ref());
+#ifdef EASY_ERROR_TELEMETRY
+      detail::record_error(error_ref());
+#endif
+    }
+
+    result(const result& r)
+      : m_has_value(r.m_has_value) {
+      if (m_has_value)
+        new (&m_storage) value_type(r.value_ref());
+      else
+        new (&m_storage) error_code(r.error_ref());
+    }
+
+    result(result&& r)
+      : m_has_value(r.m_has_value) {
+      if (m_has_value)
+        new (&m_storage) value_type(std::move(r.value_ref()));
+      else
+        new (&m_storage) error_code(r.error_ref());
+    }
+
+    ~result() EASY_NOEXCEPT {
+      destroy();
+    }
+
+    result& operator = (const result& r) {
+      if (this != &r) {
+        if (m_has_value && r.m_has_value)
+          value_ref() = r.value_ref();
+        else if (r.m_has_value) {
+          // the copy is made first, so a throwing copy leaves the result as it was
+          value_type value(r.value_ref());
+          destroy();
+          new (&m_storage) value_type(std::move(value));
+          m_has_value = true;
+        }
+        else
+          set_error(r.error_ref());
+      }
+      return *this;
+    }
+
+    result& operator = (result&& r) {
+      if (this != &r) {
+        if (m_has_value && r.m_has_value)
+          value_ref() = std::move(r.value_ref());
+        else if (r.m_has_value) {
+          destroy();
+          new (&m_storage) value_type(std::move(r.value_ref()));
+          m_has_value = true;
+        }
+        else
+          set_error(r.error_ref());
+      }
+      return *this;
+    }
+
+    bool has_value() const EASY_NOEXCEPT {
+      return m_has_value;
+    }
+
+    //! Makes it possible to use operator explicit_bool
+    bool operator !() const EASY_NOEXCEPT {
+      return !m_has_value;
+    }
+
+    //! The error, or no error if there is the value
+    error_code error() const EASY_NOEXCEPT {
+      return m_has_value ? error_code() : error_ref();
+    }
+
+    //! @{
+    //! Returns the value. Raises the error if there is no value. Without exceptions there is
+    //! nothing to return when the unhandled error handler returns, so the program is aborted
+    value_type& value() {
+      if (!m_has_value) {
+        detail::raise_error(error_ref());
+        std::abort();
+      }
+      return value_ref();
+    }
+
+    const value_type& value() const {
+      if (!m_has_value) {
+        detail::raise_error(error_ref());
+        std::abort();
+      }
+      return value_ref();
+    }
+    //! @}
+
+    //! @{
+    //! Access to the value, which must be there
+    value_type& operator * () EASY_NOEXCEPT {
+      EASY_ASSERT(m_has_value);
+      return value_ref();
+    }
+
+    const value_type& operator * () const EASY_NOEXCEPT {
+      EASY_ASSERT(m_has_value);
+      return value_ref();
+    }
+
+    value_type* operator -> () EASY_NOEXCEPT {
+      EASY_ASSERT(m_has_value);
+      return &value_ref();
+    }
+
+    const value_type* operator -> () const EASY_NOEXCEPT {
+      EASY_ASSERT(m_has_value);
+      return &value_ref();
+    }
+    //! @}
+
+    value_type value_or(const value_type& default_value) const {
+      return m_has_value ? value_ref() : default_value;
+    }
+
+    //! Moves the value out, or passes the error to ec and returns value_type().
+    //! Connects results with functions reporting errors through error_code_ref
+    value_type get(error_code_ref ec = nullptr) {
+      if (!m_has_value) {
+        ec.forward(error_ref());
+        return value_type();
+      }
+      return std::move(value_ref());
+    }
+
+  private:
+    value_type& value_ref() EASY_NOEXCEPT {
+      return *reinterpret_cast<value_type*>(&m_storage);
+    }
+
+    const value_type& value_ref() const EASY_NOEXCEPT {
+      return *reinterpret_cast<const value_type*>(&m_storage);
+    }
+
+    const error_code& error_ref() const EASY_NOEXCEPT {
+      return *reinterpret_cast<const error_code*>(&m_storage);
+    }
+
+    void set_error(const error_code& ec) EASY_NOEXCEPT {
+      destroy();
+      new (&m_storage) error_code(ec);
+      m_has_value = false;
+    }
+
+    void destroy() EASY_NOEXCEPT {
+      if (m_has_value)
+        value_ref().~value_type();
+      else
+        reinterpret_cast<error_code*>(&m_storage)->~error_code();
+    }
+
+  private:
+    typename std::aligned_storage<
+      (sizeof(value_type) > sizeof(error_code) ? sizeof(value_type) : sizeof(error_code)),
+      (std::alignment_of<value_type>::value > std::alignment_of<error_code>::value
+        ? std::alignment_of<value_type>::value : std::alignment_of<error_code>::value)
+    >::type m_storage;
+    bool m_has_value;
+  };
+
+  //! Result of an operation without a value, which is just the error
+  template<>
+  class result<void>
+    : public safe_bool<result<void>>
+  {
+  public:
+    typedef void value_type;
+
+    //! Success
+    result() EASY_NOEXCEPT {
+    }
+
+    //! Taken as already reported through error_code_ref, like in result<T>
+    result(const error_code& ec) EASY_NOEXCEPT
+      : m_error(ec) {
+    }
+
+    //! The error is new, so EASY_ERROR_TELEMETRY counts it
+    template<class ErrorEnum>
+    result(ErrorEnum e, typename boost::enable_if<boost::system::is_error_code_enum<ErrorEnum>>::type* = nullptr) EASY_NOEXCEPT
+      : m_error(make_error_code(e)) {
+#ifdef EASY_ERROR_TELEMETRY
+      if (m_error)
+        detail::record_error(m_error);
+#endif
+    }
+
+    bool has_value() const EASY_NOEXCEPT {
+      return !m_error;
+    }
+
+    //! Makes it possible to use operator explicit_bool
+    bool operator !() const EASY_NOEXCEPT {
+      return !!m_error;
+    }
+
+    error_code error() const EASY_NOEXCEPT {
+      return m_error;
+    }
+
+    //! Raises the error if there is one
+    void value() const {
+      if (m_error)
+        detail::raise_error(m_error);
+    }
+
+    //! Passes the error to ec
+    void get(error_code_ref ec = nullptr) const {
+      if (m_error)
+        ec.forward(m_error);
+    }
+
+  private:
+    error_code m_error;
+  };
+}
+
+#endif
@@ -37,7 +37,7 @@ namespace easy
     ~safe_bool() {}
     
     static explicit_bool explicit_true() {
-      return &true_type;
+      return &safe_bool::true_type;
     }
 
     static explicit_bool explicit_false() {
@@ -94,7 +94,7 @@ namespace easy
   template <class T, class U> 
   bool operator == (const safe_bool<T>& lhs, const safe_bool<U>& rhs) 
   {
-    EASY_STATIC_ASSERT(0, "safe_bool is not comparable to other safe_bool");
+    EASY_STATIC_ASSERT(sizeof(T) == 0, "safe_bool is not comparable to other safe_bool");
     return false;
   }
 
@@ -109,7 +109,7 @@ namespace easy
   template<class Stream, class T>
   Stream& operator << (Stream& s, const safe_bool<T>& b)
   {
-    EASY_STATIC_ASSERT(0, "safe_bool cannot be written to any stream");
+    EASY_STATIC_ASSERT(sizeof(T) == 0, "safe_bool cannot be written to any stream");
     return s;
   }
 }
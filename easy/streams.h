@@ -6,4 +6,49 @@
 #ifndef EASY_STREAMS_H_INCLUDED
 #define EASY_STREAMS_H_INCLUDED
 
-#endif
\ No newline at end of file
+#include <easy/config.h>
+#include <easy/types.h>
+#include <easy/error_handling.h>
+
+namespace easy
+{
+  //! Sequential source of bytes read into caller supplied buffers
+  class istream
+  {
+  public:
+    virtual ~istream() EASY_NOEXCEPT {
+    }
+
+    //! Reads up to size bytes. Returns the number of bytes read, zero at the end of the stream
+    virtual size_t read(byte* buffer, size_t size, error_code_ref ec = nullptr) = 0;
+  };
+
+  //! Sequential sink of bytes
+  class ostream
+  {
+  public:
+    virtual ~ostream() EASY_NOEXCEPT {
+    }
+
+    //! Writes all the size bytes or fails
+    virtual bool write(const byte* data, size_t size, error_code_ref ec = nullptr) = 0;
+  };
+
+  //! Copies the rest of the source to the destination through the buffer.
+  //! Returns the number of bytes copied
+  inline uint64 copy_stream(istream& src, ostream& dst, byte* buffer, size_t size, error_code_ref ec = nullptr)
+  {
+    uint64 copied = 0;
+    error_code local_ec;
+    for (;;) {
+      const size_t read = src.read(buffer, size, local_ec);
+      if (local_ec || !read || !dst.write(buffer, read, local_ec))
+        break;
+      copied += read;
+    }
+    ec.forward(local_ec);
+    return copied;
+  }
+}
+
+#endif
@@ -8,7 +8,13 @@
 
 
 #include <easy/strings/lite_string.h>
+#include <easy/strings/hash.h>
+#include <easy/strings/static_string.h>
+#include <easy/strings/string_pool.h>
+#include <easy/strings/string_builder.h>
+#include <easy/strings/numbers.h>
 #include <easy/strings/conv.h>
+#include <easy/strings/utf.h>
 
 namespace easy
 {
@@ -0,0 +1,107 @@
+/*!
+ *  @file   easy/strings/detail/search.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_STRINGS_DETAIL_SEARCH_H_INCLUDED
+#define EASY_STRINGS_DETAIL_SEARCH_H_INCLUDED
+
+#include <easy/config.h>
+
+#include <string>
+
+namespace easy {
+namespace detail
+{
+  //! @{
+  //! Byte search kernels. SSE2 and, when the compiler targets it, AVX2 versions are used
+  //! with a scalar fallback. Return nullptr if nothing is found
+  const char* find_char(const char* pstr, size_t size, char c) EASY_NOEXCEPT;
+  const char* rfind_char(const char* pstr, size_t size, char c) EASY_NOEXCEPT;
+  const char* find_any_of(const char* pstr, size_t size, const char* pset, size_t set_size) EASY_NOEXCEPT;
+  const char* find_substr(const char* pstr, size_t size, const char* psub, size_t sub_size) EASY_NOEXCEPT;
+  const char* rfind_substr(const char* pstr, size_t size, const char* psub, size_t sub_size) EASY_NOEXCEPT;
+  //! @}
+
+  //! Character search over any character type, scalar
+  template<class TChar>
+  struct char_search
+  {
+    typedef std::char_traits<TChar> traits_type;
+
+    static const TChar* find(const TChar* pstr, size_t size, TChar c) EASY_NOEXCEPT {
+      return traits_type::find(pstr, size, c);
+    }
+
+    static const TChar* rfind(const TChar* pstr, size_t size, TChar c) EASY_NOEXCEPT {
+      for (const TChar* p = pstr + size; p != pstr; ) {
+        if (traits_type::eq(*--p, c))
+          return p;
+      }
+      return nullptr;
+    }
+
+    static const TChar* find_any_of(const TChar* pstr, size_t size, const TChar* pset, size_t set_size) EASY_NOEXCEPT {
+      for (const TChar* p = pstr; p != pstr + size; ++p) {
+        if (traits_type::find(pset, set_size, *p))
+          return p;
+      }
+      return nullptr;
+    }
+
+    static const TChar* find_substr(const TChar* pstr, size_t size, const TChar* psub, size_t sub_size) EASY_NOEXCEPT {
+      if (sub_size == 0)
+        return pstr;
+      for (const TChar* p = pstr; sub_size <= size - (p - pstr); ++p) {
+        p = find(p, size - sub_size + 1 - (p - pstr), psub[0]);
+        if (!p)
+          return nullptr;
+        if (traits_type::compare(p, psub, sub_size) == 0)
+          return p;
+      }
+      return nullptr;
+    }
+
+    static const TChar* rfind_substr(const TChar* pstr, size_t size, const TChar* psub, size_t sub_size) EASY_NOEXCEPT {
+      if (sub_size > size)
+        return nullptr;
+      if (sub_size == 0)
+        return pstr + size;
+      for (size_t limit = size - sub_size + 1; limit > 0; ) {
+        const TChar* p = rfind(pstr, limit, psub[0]);
+        if (!p)
+          return nullptr;
+        if (traits_type::compare(p, psub, sub_size) == 0)
+          return p;
+        limit = p - pstr;
+      }
+      return nullptr;
+    }
+  };
+
+  template<>
+  struct char_search<char>
+  {
+    static const char* find(const char* pstr, size_t size, char c) EASY_NOEXCEPT {
+      return find_char(pstr, size, c);
+    }
+
+    static const char* rfind(const char* pstr, size_t size, char c) EASY_NOEXCEPT {
+      return rfind_char(pstr, size, c);
+    }
+
+    static const char* find_any_of(const char* pstr, size_t size, const char* pset, size_t set_size) EASY_NOEXCEPT {
+      return detail::find_any_of(pstr, size, pset, set_size);
+    }
+
+    static const char* find_substr(const char* pstr, size_t size, const char* psub, size_t sub_size) EASY_NOEXCEPT {
+      return detail::find_substr(pstr, size, psub, sub_size);
+    }
+
+    static const char* rfind_substr(const char* pstr, size_t size, const char* psub, size_t sub_size) EASY_NOEXCEPT {
+      return detail::rfind_substr(pstr, size, psub, sub_size);
+    }
+  };
+}}
+
+#endif
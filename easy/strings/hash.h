@@ -0,0 +1,134 @@
+/*!
+ *  @file   easy/strings/hash.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  Hashing of basic_lite_string and transparent functors, which let containers keyed by
+ *  std::basic_string be probed by a view without building a temporary string:
+ *
+ *    typedef boost::unordered_map<std::string, int, easy::lite_string_hash, easy::lite_string_equal> map_type;
+ *    map_type::iterator it = map.find(name, easy::lite_string_hash(), easy::lite_string_equal());
+ */
+#ifndef EASY_STRINGS_HASH_H_INCLUDED
+#define EASY_STRINGS_HASH_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/types.h>
+#include <easy/strings/lite_string.h>
+
+#include <functional>
+#include <string>
+
+namespace easy
+{
+  template<class TChar> class basic_static_string;
+
+  namespace detail
+  {
+    //! Fast non-cryptographic hash of a byte sequence, a variant of wyhash
+    uint64 hash_bytes(const void* pdata, size_t size, uint64 seed = 0) EASY_NOEXCEPT;
+
+    template<class TChar>
+    inline size_t hash_chars(const TChar* pstr, size_t size) EASY_NOEXCEPT {
+      return static_cast<size_t>(hash_bytes(pstr, size * sizeof(TChar)));
+    }
+  }
+
+  //! Hash of the characters, equal for every string type with the same characters.
+  //! Found by boost::hash through ADL
+  template<class TChar>
+  size_t hash_value(const basic_lite_string<TChar>& s) EASY_NOEXCEPT
+  {
+    return detail::hash_chars(s.data(), s.size());
+  }
+
+  //! Transparent hash of basic_lite_string, std::basic_string, C strings and
+  //! basic_static_string, whose hash is taken without touching the characters
+  template<class TChar>
+  struct basic_lite_string_hash
+  {
+    typedef void   is_transparent;
+    typedef size_t result_type;
+
+    size_t operator () (const basic_lite_string<TChar>& s) const EASY_NOEXCEPT {
+      return detail::hash_chars(s.data(), s.size());
+    }
+
+    size_t operator () (const std::basic_string<TChar>& s) const EASY_NOEXCEPT {
+      return detail::hash_chars(s.data(), s.size());
+    }
+
+    size_t operator () (const TChar* pstr) const EASY_NOEXCEPT {
+      return detail::hash_chars(pstr, std::char_traits<TChar>::length(pstr));
+    }
+
+    size_t operator () (const basic_static_string<TChar>& s) const EASY_NOEXCEPT {
+      return s.hash();
+    }
+  };
+
+  //! Transparent equality of basic_lite_string, std::basic_string, C strings and basic_static_string
+  template<class TChar>
+  struct basic_lite_string_equal
+  {
+    typedef void is_transparent;
+    typedef bool result_type;
+
+    template<class TLeft, class TRight>
+    bool operator () (const TLeft& l, const TRight& r) const EASY_NOEXCEPT {
+      return equal(view(l), view(r));
+    }
+
+  private:
+    struct sized_view
+    {
+      const TChar* pstr;
+      size_t size;
+    };
+
+    static sized_view view(const basic_lite_string<TChar>& s) EASY_NOEXCEPT {
+      sized_view v = { s.data(), s.size() };
+      return v;
+    }
+
+    static sized_view view(const std::basic_string<TChar>& s) EASY_NOEXCEPT {
+      sized_view v = { s.data(), s.size() };
+      return v;
+    }
+
+    static sized_view view(const basic_static_string<TChar>& s) EASY_NOEXCEPT {
+      sized_view v = { s.data(), s.size() };
+      return v;
+    }
+
+    static sized_view view(const TChar* pstr) EASY_NOEXCEPT {
+      sized_view v = { pstr, std::char_traits<TChar>::length(pstr) };
+      return v;
+    }
+
+    static bool equal(const sized_view& l, const sized_view& r) EASY_NOEXCEPT {
+      return l.size == r.size
+        && (l.size == 0 || std::char_traits<TChar>::compare(l.pstr, r.pstr, l.size) == 0);
+    }
+  };
+
+  typedef basic_lite_string_hash<char>  lite_string_hash;
+  typedef basic_lite_string_equal<char> lite_string_equal;
+
+#ifdef EASY_HAS_WCAHR
+  typedef basic_lite_string_hash<wchar_t>  lite_wstring_hash;
+  typedef basic_lite_string_equal<wchar_t> lite_wstring_equal;
+#endif
+}
+
+namespace std
+{
+  template<class TChar>
+  struct hash<easy::basic_lite_string<TChar>>
+    : easy::basic_lite_string_hash<TChar>
+  {
+    typedef easy::basic_lite_string<TChar> argument_type;
+  };
+}
+
+#endif
@@ -12,6 +12,10 @@
 #include <easy/stlex/nullptr_t.h>
 #include <easy/safe_bool.h>
 #include <easy/type_traits.h>
+#include <easy/strings/detail/search.h>
+#include <easy/memory/memory_resource.h>
+
+#include <boost/iterator/iterator_facade.hpp>
 
 #include <boost/utility/enable_if.hpp>
 #include <boost/type_traits/is_same.hpp>
@@ -20,11 +24,14 @@
 #include <boost/noncopyable.hpp>
 
 #include <memory>
+#include <new>
 #include <string>
+#include <type_traits>
 
 namespace easy
 {
   template<class TChar> class basic_lite_string;
+  template<class TChar> class basic_split_range;
 }
 
 template<class TChar>
@@ -42,6 +49,9 @@ namespace std
 
 namespace easy
 {
+  //! Non-owning view over a character sequence. A string taken over by rvalue becomes owned:
+  //! up to small_capacity characters are copied into the inline buffer without any allocation,
+  //! longer strings are moved into the inline storage, so their own buffer is the only allocation.
   template<class TChar>
   class basic_lite_string
     : public safe_bool<basic_lite_string<TChar>>
@@ -57,27 +67,57 @@ namespace easy
     typedef const char_type* const_iterator;
 
     typedef std::basic_string<char_type> string_type;
+
+    //! Maximum number of owned characters kept in the inline buffer
+    static const size_t small_capacity = sizeof(string_type) / sizeof(char_type) - 1;
+
+    //! Position returned when nothing is found
+    static const size_t npos = static_cast<size_t>(-1);
   public:
     
-    basic_lite_string() EASY_NOEXCEPT { }
+    basic_lite_string() EASY_NOEXCEPT
+      : m_storage_kind(storage_kind::view) {
+    }
 
-    basic_lite_string(nullptr_t) EASY_NOEXCEPT { }
+    basic_lite_string(nullptr_t) EASY_NOEXCEPT
+      : m_storage_kind(storage_kind::view) {
+    }
 
-    basic_lite_string(basic_lite_string && r) EASY_NOEXCEPT {
+    basic_lite_string(basic_lite_string && r) EASY_NOEXCEPT
+      : m_storage_kind(storage_kind::view)
+    {
       *this = std::move(r);
     }
 
     basic_lite_string(string_type && str)
-      : m_holder_ptr(new string_type(std::move(str)))
-      , m_str(m_holder_ptr->c_str(), m_holder_ptr->size()) {
+      : m_storage_kind(storage_kind::view)
+    {
+      take(std::move(str));
     }
 
     basic_lite_string(const char_type* pstr, size_t size) EASY_NOEXCEPT
-      : m_str(size > 0 ? pstr : nullptr, size) {
+      : m_storage_kind(storage_kind::view)
+      , m_str(size > 0 ? pstr : nullptr, size) {
     }
 
     basic_lite_string(const_iterator begin, const_iterator end) EASY_NOEXCEPT
-      : m_str(begin, end) {
+      : m_storage_kind(storage_kind::view)
+      , m_str(begin, end) {
+    }
+
+    //! Copies the characters to memory of the resource and becomes a view of the copy.
+    //! The copy is freed with the resource memory, so monotonic resources such as
+    //! memory::arena suit best: request scoped strings are released all at once
+    basic_lite_string(const this_type& s, memory::memory_resource& resource)
+      : m_storage_kind(storage_kind::view)
+    {
+      if (!s.empty()) {
+        char_type* pcopy = static_cast<char_type*>(
+          resource.allocate((s.size() + 1) * sizeof(char_type), std::alignment_of<char_type>::value));
+        std::char_traits<char_type>::copy(pcopy, s.data(), s.size());
+        pcopy[s.size()] = char_type();
+        m_str = sized_str(pcopy, s.size());
+      }
     }
 
     template<class TStr>
@@ -90,10 +130,15 @@ namespace easy
           char_type
         >        
       >::type* = nullptr) 
+      : m_storage_kind(storage_kind::view)
     {
       *this = this_type(make_c_string(str));
     }
 
+    ~basic_lite_string() EASY_NOEXCEPT {
+      release();
+    }
+
     const_iterator begin() const EASY_NOEXCEPT {
       return c_str();
     }
@@ -141,12 +186,17 @@ namespace easy
     operator string_type() const {
       if (empty())
         return string_type();
-      else if (m_holder_ptr)
-        return *m_holder_ptr;
+      else if (m_storage_kind == storage_kind::owned)
+        return get_owned();
       else
         return string_type(c_str(), length());
     }
 
+    //! Returns true if the characters are owned by the string rather than viewed
+    bool is_owner() const EASY_NOEXCEPT {
+      return m_storage_kind != storage_kind::view;
+    }
+
     bool operator !() const {
       return empty();
     }
@@ -159,17 +209,159 @@ namespace easy
       if (length() != r.length())
         return length() > r.length() ? 1 : -1;
 
-      return std::char_traits<char_type>::compare(cbegin(), r.cend(), length());
+      return std::char_traits<char_type>::compare(cbegin(), r.cbegin(), length());
     }
 
-  private:
+    //! @{
+    //! Search functions working like the std::basic_string ones. Return npos if nothing is found
+    size_t find(char_type c, size_t pos = 0) const EASY_NOEXCEPT {
+      if (pos >= size())
+        return npos;
+      return to_pos(search_type::find(data() + pos, size() - pos, c));
+    }
+
+    size_t find(const this_type& s, size_t pos = 0) const EASY_NOEXCEPT {
+      if (pos > size())
+        return npos;
+      // an empty string is found at the position, even in an empty or null view
+      if (s.empty())
+        return pos;
+      return to_pos(search_type::find_substr(data() + pos, size() - pos, s.data(), s.size()));
+    }
+
+    size_t rfind(char_type c, size_t pos = npos) const EASY_NOEXCEPT {
+      if (empty())
+        return npos;
+      return to_pos(search_type::rfind(data(), pos < size() ? pos + 1 : size(), c));
+    }
+
+    size_t rfind(const this_type& s, size_t pos = npos) const EASY_NOEXCEPT {
+      if (s.empty())
+        return pos < size() ? pos : size();
+      if (s.size() > size())
+        return npos;
+      const size_t last = pos < size() - s.size() ? pos : size() - s.size();
+      return to_pos(search_type::rfind_substr(data(), last + s.size(), s.data(), s.size()));
+    }
+
+    size_t find_first_of(const this_type& set, size_t pos = 0) const EASY_NOEXCEPT {
+      if (pos >= size())
+        return npos;
+      return to_pos(search_type::find_any_of(data() + pos, size() - pos, set.data(), set.size()));
+    }
+    //! @}
+
+    bool contains(char_type c) const EASY_NOEXCEPT {
+      return find(c) != npos;
+    }
+
+    bool contains(const this_type& s) const EASY_NOEXCEPT {
+      return find(s) != npos;
+    }
+
+    bool starts_with(const this_type& s) const EASY_NOEXCEPT {
+      return s.size() <= size() 
+        && std::char_traits<char_type>::compare(data(), s.data(), s.size()) == 0;
+    }
+
+    bool ends_with(const this_type& s) const EASY_NOEXCEPT {
+      return s.size() <= size() 
+        && std::char_traits<char_type>::compare(data() + size() - s.size(), s.data(), s.size()) == 0;
+    }
+
+    //! Returns a view of the part of the string
+    this_type substr(size_t pos, size_t count = npos) const EASY_NOEXCEPT {
+      if (pos >= size())
+        return this_type();
+      return this_type(data() + pos, count < size() - pos ? count : size() - pos);
+    }
+
+    //! @{
+    //! Returns a lazy range of views between the delimiters. Adjacent delimiters produce
+    //! empty views, an empty string produces none. The range must not outlive the characters
+    basic_split_range<char_type> split(char_type delimiter) const EASY_NOEXCEPT {
+      return basic_split_range<char_type>(data(), size(), delimiter);
+    }
+
+    basic_split_range<char_type> split(const this_type& delimiter) const EASY_NOEXCEPT {
+      return basic_split_range<char_type>(data(), size(), delimiter.data(), delimiter.size());
+    }
+    //! @}
+
     basic_lite_string& operator = (basic_lite_string && r) EASY_NOEXCEPT {
-      m_str = r.m_str;
-      m_holder_ptr = std::move(r.m_holder_ptr);
+      if (this == &r)
+        return *this;
+
+      release();
+      switch (r.m_storage_kind)
+      {
+      case storage_kind::view:
+        m_str = r.m_str;
+        break;
+      case storage_kind::small:
+        assign_small(r.c_str(), r.size());
+        break;
+      case storage_kind::owned:
+        take(std::move(r.get_owned()));
+        break;
+      }
+      r.release();
       return *this;
     }
 
   private:
+    typedef detail::char_search<char_type> search_type;
+
+    size_t to_pos(const char_type* p) const EASY_NOEXCEPT {
+      return p ? p - data() : npos;
+    }
+
+    void take(string_type && str) {
+      if (str.size() <= small_capacity) {
+        assign_small(str.data(), str.size());
+      }
+      else {
+        // the string buffer stays where it is, so no allocation happens
+        string_type* powned = new (&m_storage) string_type(std::move(str));
+        m_storage_kind = storage_kind::owned;
+        m_str = sized_str(powned->c_str(), powned->size());
+      }
+    }
+
+    void assign_small(const char_type* pstr, size_t size) EASY_NOEXCEPT {
+      EASY_ASSERT(size <= small_capacity);
+      char_type* pbuffer = reinterpret_cast<char_type*>(&m_storage);
+      std::char_traits<char_type>::copy(pbuffer, pstr, size);
+      pbuffer[size] = char_type();
+      m_storage_kind = storage_kind::small;
+      m_str = sized_str(pbuffer, size);
+    }
+
+    string_type& get_owned() const EASY_NOEXCEPT {
+      EASY_ASSERT(m_storage_kind == storage_kind::owned);
+      return *reinterpret_cast<string_type*>(const_cast<storage_type*>(&m_storage));
+    }
+
+    void release() EASY_NOEXCEPT {
+      if (m_storage_kind == storage_kind::owned)
+        get_owned().~string_type();
+      m_storage_kind = storage_kind::view;
+      m_str = sized_str();
+    }
+
+  private:
+    enum class storage_kind : unsigned char
+    {
+      view,  //!< Characters are owned by somebody else
+      small, //!< Characters are in the inline buffer
+      owned  //!< A string_type is in the inline storage
+    };
+
+    typedef typename std::aligned_storage<
+      sizeof(string_type), 
+      std::alignment_of<string_type>::value
+    >::type storage_type;
+
     struct sized_str {
       sized_str(const char_type* pstr = nullptr, size_t size = 0) 
         : pstr(pstr), size(size) {
@@ -187,8 +379,105 @@ namespace easy
       size_type size;
     };
   private:
-    std::unique_ptr<string_type> m_holder_ptr; // Must be at the first position
+    storage_kind m_storage_kind;
     sized_str m_str;
+    storage_type m_storage; // either the inline buffer or the owned string
+  };
+
+  template<class TChar>
+  const size_t basic_lite_string<TChar>::small_capacity;
+
+  template<class TChar>
+  const size_t basic_lite_string<TChar>::npos;
+
+  //! Lazy range of views between delimiters returned by basic_lite_string::split
+  template<class TChar>
+  class basic_split_range
+  {
+  public:
+    typedef basic_lite_string<TChar> string_type;
+
+    class iterator
+      : public boost::iterator_facade<iterator, string_type, boost::forward_traversal_tag, string_type>
+    {
+    public:
+      iterator() EASY_NOEXCEPT
+        : m_prange(nullptr), m_begin(nullptr), m_end(nullptr) {
+      }
+
+    private:
+      friend class boost::iterator_core_access;
+      friend basic_split_range;
+
+      iterator(const basic_split_range* prange, const TChar* begin) EASY_NOEXCEPT
+        : m_prange(prange), m_begin(begin), m_end(prange->find_end(begin)) {
+      }
+
+      void increment() EASY_NOEXCEPT {
+        EASY_ASSERT(m_begin);
+        if (m_end == m_prange->m_end) {
+          m_begin = m_end = nullptr;
+        }
+        else {
+          m_begin = m_end + m_prange->m_delimiter_size;
+          m_end = m_prange->find_end(m_begin);
+        }
+      }
+
+      bool equal(const iterator& other) const EASY_NOEXCEPT {
+        return m_begin == other.m_begin && m_end == other.m_end;
+      }
+
+      string_type dereference() const EASY_NOEXCEPT {
+        return string_type(m_begin, m_end - m_begin);
+      }
+
+    private:
+      const basic_split_range* m_prange;
+      const TChar* m_begin;
+      const TChar* m_end;
+    };
+
+    basic_split_range(const TChar* pstr, size_t size, TChar delimiter) EASY_NOEXCEPT
+      : m_begin(pstr)
+      , m_end(pstr + size)
+      , m_delimiter(delimiter)
+      , m_pdelimiter(nullptr)
+      , m_delimiter_size(1) {
+    }
+
+    basic_split_range(const TChar* pstr, size_t size, const TChar* pdelimiter, size_t delimiter_size) EASY_NOEXCEPT
+      : m_begin(pstr)
+      , m_end(pstr + size)
+      , m_delimiter()
+      , m_pdelimiter(pdelimiter)
+      , m_delimiter_size(delimiter_size) {
+    }
+
+    iterator begin() const EASY_NOEXCEPT {
+      return m_begin != m_end ? iterator(this, m_begin) : iterator();
+    }
+
+    iterator end() const EASY_NOEXCEPT {
+      return iterator();
+    }
+
+  private:
+    const TChar* find_end(const TChar* p) const EASY_NOEXCEPT {
+      const TChar* pfound = nullptr;
+      if (!m_pdelimiter)
+        pfound = detail::char_search<TChar>::find(p, m_end - p, m_delimiter);
+      else if (m_delimiter_size > 0)
+        pfound = detail::char_search<TChar>::find_substr(p, m_end - p, m_pdelimiter, m_delimiter_size);
+      return pfound ? pfound : m_end;
+    }
+
+  private:
+    const TChar* m_begin;
+    const TChar* m_end;
+    TChar m_delimiter;
+    const TChar* m_pdelimiter; // null for a single character delimiter
+    size_t m_delimiter_size;
   };
 
 
@@ -213,7 +502,7 @@ namespace easy
   template<class Char>
   bool operator < (const basic_lite_string<Char>& s1, const basic_lite_string<Char>& s2)
   {
-    return s1.compare(s2) != 0;
+    return s1.compare(s2) < 0;
   }
 
   template<class Char>
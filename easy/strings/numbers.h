@@ -0,0 +1,87 @@
+/*!
+ *  @file   easy/strings/numbers.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  Parsing and formatting of numbers on character views, in the manner of std::from_chars and
+ *  std::to_chars:
+ *
+ *    const int port = easy::parse<int>(value, ec);
+ *
+ *    char buffer[easy::max_number_length];
+ *    const size_t size = easy::format(3.25, buffer, sizeof(buffer));
+ *
+ *  The syntax is the one of the C locale: an optional minus sign, decimal digits and for floating
+ *  point numbers a fraction, an exponent, "inf", "infinity" or "nan". Leading whitespace and
+ *  plus signs are not accepted. Malformed text gives generic_error::invalid_value, a number not
+ *  representable by the type gives generic_error::out_of_range. Eight digits are converted at once.
+ *
+ *  Floating point numbers with up to 8 decimals below 1e15 are formatted as plain decimals,
+ *  e.g. 0.1 or 100000000000000 for 1e14. The others get the smallest %g precision which parses
+ *  back to the same value, e.g. 1e+300.
+ *
+ *  Integers and short decimals are converted here. The other floating point numbers are left
+ *  to strtod, strtof and sprintf, so unlike std::from_chars:
+ *    - they follow LC_NUMERIC, so a program must keep the C decimal point, i.e. must not call
+ *      setlocale for LC_NUMERIC or LC_ALL with a locale which has another one;
+ *    - a number longer than 255 characters is copied to a string, which allocates.
+ */
+#ifndef EASY_STRINGS_NUMBERS_H_INCLUDED
+#define EASY_STRINGS_NUMBERS_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/types.h>
+#include <easy/error_handling.h>
+#include <easy/strings/lite_string.h>
+
+namespace easy
+{
+  //! Buffer size enough for any number format writes
+  const size_t max_number_length = 32;
+
+  //! @{
+  //! Parses the number at the start of the string. Returns the number of characters it takes,
+  //! 0 on error, when the value is left unchanged
+  size_t parse(const lite_string& s, int& value, error_code_ref ec = nullptr);
+  size_t parse(const lite_string& s, unsigned int& value, error_code_ref ec = nullptr);
+  size_t parse(const lite_string& s, long& value, error_code_ref ec = nullptr);
+  size_t parse(const lite_string& s, unsigned long& value, error_code_ref ec = nullptr);
+  size_t parse(const lite_string& s, int64& value, error_code_ref ec = nullptr);
+  size_t parse(const lite_string& s, uint64& value, error_code_ref ec = nullptr);
+  size_t parse(const lite_string& s, float& value, error_code_ref ec = nullptr);
+  size_t parse(const lite_string& s, double& value, error_code_ref ec = nullptr);
+  //! @}
+
+  //! Parses the whole string as a number of the type. Returns T() on error
+  template<class T>
+  T parse(const lite_string& s, error_code_ref ec = nullptr)
+  {
+    T value = T();
+    error_code parse_ec;
+    const size_t length = parse(s, value, parse_ec);
+    if (parse_ec) {
+      ec.forward(parse_ec);
+      return T();
+    }
+    if (length != s.size()) {
+      ec = generic_error::invalid_value;
+      return T();
+    }
+    return value;
+  }
+
+  //! @{
+  //! Writes the number to the buffer without a terminating zero. Returns the number of written
+  //! characters, 0 if the buffer is too small. A buffer of max_number_length always suffices
+  size_t format(int value, char* pdest, size_t size, error_code_ref ec = nullptr);
+  size_t format(unsigned int value, char* pdest, size_t size, error_code_ref ec = nullptr);
+  size_t format(long value, char* pdest, size_t size, error_code_ref ec = nullptr);
+  size_t format(unsigned long value, char* pdest, size_t size, error_code_ref ec = nullptr);
+  size_t format(int64 value, char* pdest, size_t size, error_code_ref ec = nullptr);
+  size_t format(uint64 value, char* pdest, size_t size, error_code_ref ec = nullptr);
+  size_t format(float value, char* pdest, size_t size, error_code_ref ec = nullptr);
+  size_t format(double value, char* pdest, size_t size, error_code_ref ec = nullptr);
+  //! @}
+}
+
+#endif
@@ -0,0 +1,132 @@
+/*!
+ *  @file   easy/strings/static_string.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  String literals with the length taken from the array type and the hash computed once:
+ *
+ *    static const easy::static_string content_type("content-type");
+ *    map.find(content_type, easy::lite_string_hash(), easy::lite_string_equal());
+ *
+ *  The hash is the one of hash.h, so a static_string probes containers keyed by any string
+ *  type. It is computed by the constructor, so keys declared static are hashed once per process.
+ */
+#ifndef EASY_STRINGS_STATIC_STRING_H_INCLUDED
+#define EASY_STRINGS_STATIC_STRING_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/strings/lite_string.h>
+#include <easy/strings/hash.h>
+
+#include <string>
+
+namespace easy
+{
+  //! View of a string literal keeping its length and hash.
+  //! Converts implicitly to basic_lite_string without measuring the characters.
+  //! Every character array is taken as a literal, so a buffer must not be passed
+  //! unless the string fills it up to the last element
+  template<class TChar>
+  class basic_static_string
+  {
+  public:
+    typedef basic_static_string this_type;
+    typedef TChar               char_type;
+    typedef const char_type*    const_iterator;
+
+    template<size_t TSize>
+    explicit basic_static_string(const char_type (&str)[TSize]) EASY_NOEXCEPT
+      : m_pstr(str)
+      , m_size(TSize - 1)
+      , m_hash(detail::hash_chars(str, TSize - 1)) {
+    }
+
+    const char_type* c_str() const EASY_NOEXCEPT {
+      return m_pstr;
+    }
+
+    const char_type* data() const EASY_NOEXCEPT {
+      return m_pstr;
+    }
+
+    size_t size() const EASY_NOEXCEPT {
+      return m_size;
+    }
+
+    size_t length() const EASY_NOEXCEPT {
+      return m_size;
+    }
+
+    bool empty() const EASY_NOEXCEPT {
+      return m_size == 0;
+    }
+
+    const_iterator begin() const EASY_NOEXCEPT {
+      return m_pstr;
+    }
+
+    const_iterator end() const EASY_NOEXCEPT {
+      return m_pstr + m_size;
+    }
+
+    //! The hash_value of the characters
+    size_t hash() const EASY_NOEXCEPT {
+      return m_hash;
+    }
+
+    operator basic_lite_string<char_type>() const EASY_NOEXCEPT {
+      return basic_lite_string<char_type>(m_pstr, m_size);
+    }
+
+    std::basic_string<char_type> str() const {
+      return std::basic_string<char_type>(m_pstr, m_size);
+    }
+
+  private:
+    const char_type* m_pstr;
+    size_t m_size;
+    size_t m_hash;
+  };
+
+  template<class TChar>
+  size_t hash_value(const basic_static_string<TChar>& s) EASY_NOEXCEPT
+  {
+    return s.hash();
+  }
+
+  //! Literals with different hashes are not compared character by character
+  template<class TChar>
+  bool operator == (const basic_static_string<TChar>& s1, const basic_static_string<TChar>& s2)
+  {
+    return s1.hash() == s2.hash() && s1.size() == s2.size()
+      && std::char_traits<TChar>::compare(s1.data(), s2.data(), s1.size()) == 0;
+  }
+
+  template<class TChar>
+  bool operator != (const basic_static_string<TChar>& s1, const basic_static_string<TChar>& s2)
+  {
+    return !(s1 == s2);
+  }
+
+  typedef basic_static_string<char>    static_string;
+
+#ifdef EASY_HAS_WCAHR
+  typedef basic_static_string<wchar_t> static_wstring;
+#endif
+}
+
+namespace std
+{
+  template<class TChar>
+  struct hash<easy::basic_static_string<TChar>>
+  {
+    typedef easy::basic_static_string<TChar> argument_type;
+    typedef size_t result_type;
+
+    size_t operator () (const argument_type& s) const EASY_NOEXCEPT {
+      return s.hash();
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*!
+ *  @file   easy/strings/string_builder.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  Concatenation of strings and numbers into chunked storage. Growing the text never moves
+ *  what is already written, so building large texts costs no reallocation and copying:
+ *
+ *    easy::string_builder sql;
+ *    sql << "SELECT * FROM orders WHERE id IN (";
+ *    for (size_t i = 0; i < ids.size(); ++i)
+ *      sql << (i ? ", " : "") << ids[i];
+ *    sql << ")";
+ *    db.execute(sql.flatten());
+ *
+ *  The text is either flattened into one zero terminated buffer or written out by fragments,
+ *  which map one to one to the iovec entries of writev or the WSABUF entries of WSASend.
+ */
+#ifndef EASY_STRINGS_STRING_BUILDER_H_INCLUDED
+#define EASY_STRINGS_STRING_BUILDER_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/types.h>
+#include <easy/strings/lite_string.h>
+#include <easy/memory/arena.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <string>
+#include <vector>
+
+namespace easy
+{
+  //! Contiguous piece of the text of a string_builder
+  struct string_fragment
+  {
+    const char* pdata;
+    size_t size;
+  };
+
+  //! Builds a text from fragments kept in memory::arena chunks. Consecutive appends are packed
+  //! into the same chunk and form one fragment. The builder is not thread safe.
+  class string_builder
+    : boost::noncopyable
+  {
+  public:
+    typedef std::vector<string_fragment, memory::polymorphic_allocator<string_fragment>> fragments_type;
+
+    //! Size of the first chunk. The next chunks double up to max_chunk_size
+    static const size_t default_chunk_size = 1024;
+    static const size_t max_chunk_size = 64 * 1024;
+
+    //! The chunks and the fragment list are allocated from the resource
+    explicit string_builder(size_t chunk_size = default_chunk_size,
+      memory::memory_resource* presource = memory::new_delete_resource());
+    ~string_builder() EASY_NOEXCEPT;
+
+    //! @{
+    //! Copies the characters to the end of the text
+    string_builder& append(const char* pstr, size_t size);
+    string_builder& append(const lite_string& s);
+    string_builder& append(char c);
+    string_builder& append(size_t count, char c);
+    //! @}
+
+    //! Adds the characters to the text without copying them, they must outlive the builder
+    //! or the next clear(). Suits long constant parts of a text which is written by fragments
+    string_builder& append_view(const lite_string& s);
+
+    //! @{
+    //! Appends the decimal representation of the number
+    string_builder& append(int value);
+    string_builder& append(unsigned int value);
+    string_builder& append(long value);
+    string_builder& append(unsigned long value);
+    string_builder& append(int64 value);
+    string_builder& append(uint64 value);
+    //! @}
+
+    //! Appends the shortest representation of the number which reads back to the same value
+    string_builder& append(double value);
+
+    template<class T>
+    string_builder& operator << (const T& value) {
+      return append(value);
+    }
+
+    //! Length of the text
+    size_t size() const EASY_NOEXCEPT;
+
+    bool empty() const EASY_NOEXCEPT;
+
+    //! The pieces of the text in order
+    const fragments_type& fragments() const EASY_NOEXCEPT;
+
+    //! Moves the text into one zero terminated buffer and returns a view of it,
+    //! valid until the next change of the builder
+    lite_string flatten();
+
+    //! Copies the text to the buffer, which must hold size() characters
+    void copy_to(char* pdest) const EASY_NOEXCEPT;
+
+    std::string str() const;
+
+    //! Empties the builder and frees its chunks
+    void clear() EASY_NOEXCEPT;
+
+  private:
+    char* reserve(size_t size);
+    void commit(char* pdata, size_t size);
+
+  private:
+    memory::arena m_arena;
+    fragments_type m_fragments;
+    size_t m_chunk_size;
+    size_t m_next_chunk_size;
+    char* m_pcurrent;   // free space of the current chunk
+    size_t m_remaining;
+    size_t m_size;
+  };
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*!
+ *  @file   easy/strings/string_pool.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ */
+#ifndef EASY_STRINGS_STRING_POOL_H_INCLUDED
+#define EASY_STRINGS_STRING_POOL_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/types.h>
+#include <easy/strings/lite_string.h>
+#include <easy/strings/static_string.h>
+#include <easy/memory/arena.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace easy
+{
+  class concurrent_string_pool;
+
+  //! Memory statistics of a string pool
+  struct string_pool_stats
+  {
+    string_pool_stats() EASY_NOEXCEPT
+      : strings(), lookups(), hits(), string_bytes(), saved_bytes()
+      , arena_bytes(), index_bytes() {
+    }
+
+    uint64 strings;      //!< Number of distinct interned strings
+    uint64 lookups;      //!< Number of intern calls
+    uint64 hits;         //!< Number of intern calls which found the string already interned
+    uint64 string_bytes; //!< Bytes of the interned characters including the terminating zeros
+    uint64 saved_bytes;  //!< Bytes of the characters which the hits did not have to store again
+    uint64 arena_bytes;  //!< Bytes of the arena chunks keeping the characters
+    uint64 index_bytes;  //!< Bytes allocated for the lookup table
+  };
+
+  //! Interns strings: every distinct character sequence is stored once in a memory::arena,
+  //! which releases the characters only by clear() or the destructor.
+  //!
+  //! The returned lite_string handles are zero terminated non-owning views. Handles of equal
+  //! strings from the same pool share the characters, so they can be compared by data().
+  //! The pool is not thread safe, see concurrent_string_pool.
+  class string_pool
+    : boost::noncopyable
+  {
+  public:
+    //! Default size of the arena chunks. Longer strings get chunks of their own
+    static const size_t default_chunk_size = 64 * 1024;
+
+    //! The arena chunks and the lookup table are allocated from the resource
+    explicit string_pool(size_t chunk_size = default_chunk_size,
+      memory::memory_resource* presource = memory::new_delete_resource());
+    ~string_pool() EASY_NOEXCEPT;
+
+    //! Returns the interned copy of the string, storing it on the first call
+    lite_string intern(const lite_string& s);
+
+    //! Interns a literal with its precomputed hash
+    lite_string intern(const static_string& s);
+
+    //! Returns the interned copy of the string or an empty string if it has not been interned
+    lite_string find(const lite_string& s) const EASY_NOEXCEPT;
+
+    //! Number of distinct interned strings
+    size_t size() const EASY_NOEXCEPT;
+
+    string_pool_stats get_stats() const EASY_NOEXCEPT;
+
+    //! Releases all strings. The handles returned before become dangling
+    void clear() EASY_NOEXCEPT;
+
+  private:
+    friend class concurrent_string_pool;
+
+    struct entry
+    {
+      const char* pstr; // null for a free slot
+      size_t size;
+      size_t hash;
+    };
+
+    lite_string intern(const lite_string& s, size_t hash);
+    const entry* lookup(const char* pstr, size_t size, size_t hash) const EASY_NOEXCEPT;
+    const char* store(const char* pstr, size_t size);
+    void grow_index();
+
+  private:
+    typedef std::vector<entry, memory::polymorphic_allocator<entry>> index_type;
+
+    memory::arena m_arena;
+    index_type m_index; // open addressing, the size is a power of two
+    string_pool_stats m_stats;
+  };
+
+  //! Thread safe string pool. The strings are distributed over independently locked
+  //! string_pool shards by their hashes, so threads interning different strings rarely wait
+  class concurrent_string_pool
+    : boost::noncopyable
+  {
+  public:
+    static const size_t default_shard_count = 16;
+
+    //! The shard count is rounded up to a power of two. The resource is used
+    //! by all the shards, so it must be thread safe
+    explicit concurrent_string_pool(size_t shard_count = default_shard_count,
+      size_t chunk_size = string_pool::default_chunk_size,
+      memory::memory_resource* presource = memory::new_delete_resource());
+    ~concurrent_string_pool() EASY_NOEXCEPT;
+
+    //! Returns the interned copy of the string, storing it on the first call
+    lite_string intern(const lite_string& s);
+
+    //! Interns a literal with its precomputed hash
+    lite_string intern(const static_string& s);
+
+    //! Returns the interned copy of the string or an empty string if it has not been interned
+    lite_string find(const lite_string& s) const;
+
+    //! Number of distinct interned strings
+    size_t size() const;
+
+    //! Statistics summed over the shards
+    string_pool_stats get_stats() const;
+
+    //! Releases all strings. The handles returned before become dangling
+    void clear();
+
+  private:
+    struct shard;
+    shard& get_shard(size_t hash) const EASY_NOEXCEPT;
+
+  private:
+    std::unique_ptr<shard[]> m_shards;
+    size_t m_shard_mask;
+  };
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*!
+ *  @file   easy/strings/utf.h
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  Portable UTF-8, UTF-16 and UTF-32 transcoding into caller buffers.
+ *
+ *  The *_length_from_* functions return the exact number of code units a conversion of valid
+ *  input writes, so the destination can be allocated once:
+ *
+ *    std::vector<uint16> buffer(utf::utf16_length_from_utf8(pstr, size));
+ *    size_t written = utf::convert_utf8_to_utf16(pstr, size, buffer.data(), ec);
+ *
+ *  The conversions validate the input. On invalid input they set
+ *  boost::system::errc::illegal_byte_sequence and return 0. They stop at the first invalid unit,
+ *  so they never write more than the length computed for the same input, even an invalid one.
+ *  ASCII runs, validation and length computation are vectorized with SSE2.
+ *
+ *  utf8_decoder handles input that arrives in chunks, which may split multibyte sequences:
+ *
+ *    utf::utf8_decoder decoder;
+ *    std::vector<uint16> buffer;
+ *    while (read_chunk(chunk)) {
+ *      buffer.clear();
+ *      decoder.decode(chunk.data(), chunk.size(), buffer, ec);
+ *      if (ec)
+ *        return report(decoder.error_offset());
+ *      write(buffer);
+ *    }
+ *    decoder.finish(ec);
+ */
+#ifndef EASY_STRINGS_UTF_H_INCLUDED
+#define EASY_STRINGS_UTF_H_INCLUDED
+
+#include <easy/config.h>
+#include <easy/types.h>
+#include <easy/error_handling.h>
+
+#include <vector>
+
+namespace easy {
+namespace utf
+{
+  //! Returns the error_code the conversions set on invalid input
+  error_code make_invalid_sequence_error() EASY_NOEXCEPT;
+
+  //! @{
+  //! Returns true if the input is well formed: no overlong forms, unpaired surrogates
+  //! or code points above U+10FFFF
+  bool validate_utf8(const char* pstr, size_t size) EASY_NOEXCEPT;
+  bool validate_utf16(const uint16* pstr, size_t size) EASY_NOEXCEPT;
+  bool validate_utf32(const uint32* pstr, size_t size) EASY_NOEXCEPT;
+  //! @}
+
+  //! @{
+  //! Returns the number of code units the conversion of valid input produces
+  size_t utf16_length_from_utf8(const char* pstr, size_t size) EASY_NOEXCEPT;
+  size_t utf32_length_from_utf8(const char* pstr, size_t size) EASY_NOEXCEPT;
+  size_t utf8_length_from_utf16(const uint16* pstr, size_t size) EASY_NOEXCEPT;
+  size_t utf32_length_from_utf16(const uint16* pstr, size_t size) EASY_NOEXCEPT;
+  size_t utf8_length_from_utf32(const uint32* pstr, size_t size) EASY_NOEXCEPT;
+  size_t utf16_length_from_utf32(const uint32* pstr, size_t size) EASY_NOEXCEPT;
+  //! @}
+
+  //! @{
+  //! Converts the input into the destination buffer, which must hold the number of code units
+  //! returned by the corresponding *_length_from_* function. Returns the number of written units
+  size_t convert_utf8_to_utf16(const char* pstr, size_t size, uint16* pdest, error_code_ref ec = nullptr);
+  size_t convert_utf8_to_utf32(const char* pstr, size_t size, uint32* pdest, error_code_ref ec = nullptr);
+  size_t convert_utf16_to_utf8(const uint16* pstr, size_t size, char* pdest, error_code_ref ec = nullptr);
+  size_t convert_utf16_to_utf32(const uint16* pstr, size_t size, uint32* pdest, error_code_ref ec = nullptr);
+  size_t convert_utf32_to_utf8(const uint32* pstr, size_t size, char* pdest, error_code_ref ec = nullptr);
+  size_t convert_utf32_to_utf16(const uint32* pstr, size_t size, uint16* pdest, error_code_ref ec = nullptr);
+  //! @}
+
+  //! Incremental UTF-8 validator and decoder.
+  //! A sequence cut by the end of a chunk is carried over to the next call, so the input may be
+  //! split at any byte. After an error every call fails until reset() is called.
+  class utf8_decoder
+  {
+  public:
+    utf8_decoder() EASY_NOEXCEPT;
+
+    //! Validates the chunk
+    void validate(const char* pstr, size_t size, error_code_ref ec = nullptr);
+
+    //! @{
+    //! Decodes the chunk and appends the complete code points to the output.
+    //! On invalid input the output holds the code points before the invalid sequence
+    void decode(const char* pstr, size_t size, std::vector<uint16>& out, error_code_ref ec = nullptr);
+    void decode(const char* pstr, size_t size, std::vector<uint32>& out, error_code_ref ec = nullptr);
+    //! @}
+
+    //! Ends the input. A sequence left incomplete by the last chunk is an error
+    void finish(error_code_ref ec = nullptr);
+
+    //! Starts a new input
+    void reset() EASY_NOEXCEPT;
+
+    //! Returns the number of bytes passed to the decoder
+    uint64 offset() const EASY_NOEXCEPT;
+
+    //! Returns the offset of the invalid sequence in the input after an error, otherwise offset()
+    uint64 error_offset() const EASY_NOEXCEPT;
+
+    //! Returns true after an error
+    bool failed() const EASY_NOEXCEPT;
+
+    //! Returns the number of bytes of an incomplete sequence waiting for the next chunk
+    size_t pending() const EASY_NOEXCEPT;
+
+  private:
+    template<class TUnit>
+    void decode_chunk(const char* pstr, size_t size, std::vector<TUnit>* pout, error_code_ref ec);
+    void set_failed(uint64 offset) EASY_NOEXCEPT;
+
+  private:
+    uint64 m_offset;
+    uint64 m_error_offset;
+    char m_pending[4];
+    size_t m_pending_size;
+    bool m_failed;
+  };
+}}
+
+#endif
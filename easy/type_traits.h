@@ -10,6 +10,8 @@
 
 #include <type_traits>
 #include <boost/type_traits.hpp>
+#include <boost/mpl/and.hpp>
+#include <boost/mpl/not.hpp>
 
 #include <string>
 
@@ -24,10 +24,15 @@ namespace easy
   typedef int              int32;
   typedef uint             uint32;
 
+#ifdef EASY_MSVC_VERSION
   typedef __int64          int64;
   typedef unsigned __int64 uint64;
+#else
+  typedef long long          int64;
+  typedef unsigned long long uint64;
+#endif
 
-#ifdef EASY_WIN64
+#if defined(EASY_WIN64) || defined(__LP64__)
   typedef int64            int_ptr;
   typedef uint64           uint_ptr;
 #else
@@ -0,0 +1,277 @@
+#include <easy/db/sqlite/async_executor.h>
+
+#include <easy/stlex/make_unique.h>
+
+#include <algorithm>
+
+namespace easy { namespace db { namespace sqlite
+{
+  namespace detail
+  {
+    struct async_task
+      : boost::noncopyable
+    {
+      async_task(job_kind kind, async_executor::job_type && job, async_executor::completion_type && completion)
+        : next(nullptr)
+        , kind(kind)
+        , job(std::move(job))
+        , completion(std::move(completion)) {
+      }
+
+      async_task* next;
+      job_kind kind;
+      async_executor::job_type job;
+      async_executor::completion_type completion;
+      error_code result;
+    };
+
+    namespace
+    {
+      const char* const write_savepoint = "SAVEPOINT easy_async_write";
+      const char* const write_rollback  = "ROLLBACK TO easy_async_write";
+      const char* const write_release   = "RELEASE easy_async_write";
+
+      void run_job(database& _db, async_task* ptask) EASY_NOEXCEPT
+      {
+        try {
+          ptask->job(_db, ptask->result);
+        }
+        catch (const system_error& e) {
+          ptask->result = e.code();
+        }
+        catch (...) {
+          ptask->result = make_error_code(generic_error::unexpected);
+        }
+      }
+    }
+  }
+
+  using namespace detail;
+
+  const size_t async_executor::default_max_transaction_writes;
+
+  async_executor::async_executor(database && _db, size_t max_transaction_writes)
+    : m_db(std::move(_db))
+    , m_max_transaction_writes(std::max<size_t>(max_transaction_writes, 1))
+    , m_head(nullptr)
+    , m_stopped(false)
+    , m_sleeping(false)
+  {
+    m_thread = std::thread(&async_executor::run, this);
+  }
+
+  async_executor::~async_executor()
+  {
+    stop();
+  }
+
+  std::future<error_code> async_executor::submit(job_kind kind, job_type job)
+  {
+    std::shared_ptr<std::promise<error_code>> promise_ptr = std::make_shared<std::promise<error_code>>();
+    std::future<error_code> result = promise_ptr->get_future();
+    submit(kind, std::move(job), [promise_ptr](const error_code& ec) {
+      promise_ptr->set_value(ec);
+    });
+    return result;
+  }
+
+  void async_executor::submit(job_kind kind, job_type job, completion_type completion)
+  {
+    std::unique_ptr<async_task> task_ptr = std::make_unique<async_task>(kind, std::move(job), std::move(completion));
+    if (m_stopped) {
+      task_ptr->result = make_db_error_code(static_cast<int>(result_code::executor_stopped));
+      complete(task_ptr.release());
+      return;
+    }
+    push(task_ptr.release());
+
+    // stop may have completed between the check and the push, then nobody takes the job
+    if (m_stopped)
+      complete_stopped(take_all());
+  }
+
+  std::future<error_code> async_executor::execute(const lite_string& sql)
+  {
+    std::string query = sql;
+    return submit(job_kind::write, [query](database& _db, error_code_ref ec) {
+      _db.execute(query, ec);
+    });
+  }
+
+  void async_executor::execute(const lite_string& sql, completion_type completion)
+  {
+    std::string query = sql;
+    submit(job_kind::write, [query](database& _db, error_code_ref ec) {
+      _db.execute(query, ec);
+    }, std::move(completion));
+  }
+
+  void async_executor::stop()
+  {
+    if (m_stopped.exchange(true))
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_cond.notify_one();
+    if (m_thread.joinable())
+      m_thread.join();
+
+    // jobs which raced with stop
+    complete_stopped(take_all());
+  }
+
+  async_executor_stats async_executor::get_stats() const
+  {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    return m_stats;
+  }
+
+  void async_executor::push(async_task* ptask)
+  {
+    ptask->next = m_head.load(std::memory_order_relaxed);
+    while (!m_head.compare_exchange_weak(ptask->next, ptask))
+      ;
+
+    // the worker sets the flag before it checks the queue for the last time, so the wakeup cannot be lost
+    if (m_sleeping) {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+      }
+      m_cond.notify_one();
+    }
+  }
+
+  async_task* async_executor::take_all()
+  {
+    // the stack keeps the last queued job first, so it is reversed to restore the queue order
+    async_task* ptask = m_head.exchange(nullptr);
+    async_task* preversed = nullptr;
+    while (ptask) {
+      async_task* pnext = ptask->next;
+      ptask->next = preversed;
+      preversed = ptask;
+      ptask = pnext;
+    }
+    return preversed;
+  }
+
+  void async_executor::complete_stopped(async_task* ptask)
+  {
+    while (ptask) {
+      async_task* pnext = ptask->next;
+      ptask->result = make_db_error_code(static_cast<int>(result_code::executor_stopped));
+      complete(ptask);
+      ptask = pnext;
+    }
+  }
+
+  bool async_executor::wait()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_sleeping = true;
+    while (!m_head.load() && !m_stopped)
+      m_cond.wait(lock);
+    m_sleeping = false;
+    return m_head.load() != nullptr;
+  }
+
+  void async_executor::run()
+  {
+    for (;;)
+    {
+      async_task* ptask = take_all();
+      if (!ptask) {
+        if (wait())
+          continue;
+        break;
+      }
+
+      while (ptask)
+        ptask = ptask->kind == job_kind::write ? run_writes(ptask) : run_read(ptask);
+    }
+  }
+
+  async_task* async_executor::run_read(async_task* ptask)
+  {
+    async_task* pnext = ptask->next;
+    run_job(m_db, ptask);
+    {
+      std::lock_guard<std::mutex> lock(m_stats_mutex);
+      m_stats.reads++;
+    }
+    complete(ptask);
+    return pnext;
+  }
+
+  async_task* async_executor::run_writes(async_task* ptask)
+  {
+    // the writes up to the next read go into one transaction
+    async_task* pend = ptask;
+    size_t count = 0;
+    while (pend && pend->kind == job_kind::write && count < m_max_transaction_writes) {
+      pend = pend->next;
+      ++count;
+    }
+
+    error_code ec;
+    const bool in_transaction = m_db.execute("BEGIN", ec);
+    for (async_task* pwrite = ptask; pwrite != pend; pwrite = pwrite->next) {
+      if (in_transaction && !m_db.execute(write_savepoint, pwrite->result))
+        continue;
+
+      run_job(m_db, pwrite);
+
+      if (in_transaction) {
+        if (pwrite->result)
+          m_db.execute(write_rollback, ec);
+        m_db.execute(write_release, ec);
+      }
+    }
+
+    if (in_transaction && !m_db.execute("COMMIT", ec)) {
+      error_code rollback_ec;
+      m_db.execute("ROLLBACK", rollback_ec);
+      for (async_task* pwrite = ptask; pwrite != pend; pwrite = pwrite->next) {
+        if (!pwrite->result)
+          pwrite->result = ec;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_stats_mutex);
+      m_stats.writes += count;
+      if (in_transaction) {
+        m_stats.transactions++;
+        m_stats.max_transaction_writes = std::max(m_stats.max_transaction_writes, count);
+      }
+    }
+
+    while (ptask != pend) {
+      async_task* pnext = ptask->next;
+      complete(ptask);
+      ptask = pnext;
+    }
+    return pend;
+  }
+
+  void async_executor::complete(async_task* ptask)
+  {
+    std::unique_ptr<async_task> task_ptr(ptask);
+    if (task_ptr->result) {
+      std::lock_guard<std::mutex> lock(m_stats_mutex);
+      m_stats.failed++;
+    }
+
+    if (!task_ptr->completion)
+      return;
+    try {
+      task_ptr->completion(task_ptr->result);
+    }
+    catch (...) {
+      EASY_ASSERT(!"A completion of an async sqlite job must not throw");
+    }
+  }
+
+}}}
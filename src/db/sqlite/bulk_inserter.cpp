@@ -0,0 +1,95 @@
+#include <easy/db/sqlite/bulk_inserter.h>
+
+namespace easy { namespace db { namespace sqlite
+{
+  const size_t bulk_inserter::default_batch_size;
+
+  bulk_inserter::bulk_inserter(database& _db, const lite_string& query, error_code_ref ec)
+    : m_db(_db)
+    , m_stmt(_db.create_statement(query, ec))
+    , m_batch_size(default_batch_size)
+    , m_pending_rows()
+  {
+  }
+
+  bulk_inserter::bulk_inserter(database& _db, const lite_string& query, size_t batch_size, error_code_ref ec)
+    : m_db(_db)
+    , m_stmt(_db.create_statement(query, ec))
+    , m_batch_size(batch_size > 0 ? batch_size : 1)
+    , m_pending_rows()
+  {
+  }
+
+  bulk_inserter::~bulk_inserter()
+  {
+    error_code ec;
+    flush(ec);
+    EASY_ASSERT(!ec);
+  }
+
+  bool bulk_inserter::begin_row(error_code_ref ec)
+  {
+    if (m_pending_rows > 0)
+      return true;
+
+    if (!m_db.execute("BEGIN", ec))
+      return false;
+    m_batch_start = clock_type::now();
+    return true;
+  }
+
+  bool bulk_inserter::end_row(bool bound, error_code_ref ec)
+  {
+    if (bound) {
+      error_code step_ec, reset_ec;
+      m_stmt.next(step_ec);
+      m_stmt.reset(reset_ec); // sqlite3_reset repeats the step error
+      if (!step_ec) {
+        if (++m_pending_rows >= m_batch_size)
+          return flush(ec);
+        return true;
+      }
+      rollback();
+      ec.forward(step_ec);
+      return false;
+    }
+    rollback();
+    return false;
+  }
+
+  bool bulk_inserter::flush(error_code_ref ec)
+  {
+    if (m_pending_rows == 0)
+      return true;
+
+    if (!m_db.execute("COMMIT", ec)) {
+      rollback();
+      return false;
+    }
+
+    m_stats.rows += m_pending_rows;
+    m_stats.transactions++;
+    m_stats.seconds += std::chrono::duration<double>(clock_type::now() - m_batch_start).count();
+    m_pending_rows = 0;
+    return true;
+  }
+
+  void bulk_inserter::rollback()
+  {
+    error_code ec;
+    m_stmt.reset(ec);
+    m_db.execute("ROLLBACK", ec);
+    m_pending_rows = 0;
+  }
+
+  size_t bulk_inserter::get_batch_size() const
+  {
+    return m_batch_size;
+  }
+
+  bulk_insert_stats bulk_inserter::get_stats() const
+  {
+    return m_stats;
+  }
+
+}}}
@@ -0,0 +1,180 @@
+#include <easy/db/sqlite/checkpoint_scheduler.h>
+#include <easy/db/sqlite/statement.h>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+
+namespace easy { namespace db { namespace sqlite
+{
+  const uint64 checkpoint_scheduler::wal_frame_header_size;
+
+  checkpoint_scheduler::checkpoint_scheduler(const lite_string& db_file_path, error_code_ref ec)
+    : m_frame_size(0)
+    , m_unchecked_frames(0)
+    , m_checked_wal_size(0)
+    , m_data_version(-1)
+    , m_written(false)
+    , m_stopped(false)
+  {
+    start(db_file_path, ec);
+  }
+
+  checkpoint_scheduler::checkpoint_scheduler(const lite_string& db_file_path, const checkpoint_policy& policy, error_code_ref ec)
+    : m_policy(policy)
+    , m_frame_size(0)
+    , m_unchecked_frames(0)
+    , m_checked_wal_size(0)
+    , m_data_version(-1)
+    , m_written(false)
+    , m_stopped(false)
+  {
+    start(db_file_path, ec);
+  }
+
+  checkpoint_scheduler::~checkpoint_scheduler()
+  {
+    stop();
+  }
+
+  void checkpoint_scheduler::start(const lite_string& db_file_path, error_code_ref ec)
+  {
+    m_wal_path.assign(db_file_path.c_str(), db_file_path.length());
+    m_wal_path.append("-wal");
+
+    m_db = database(db_file_path, open_flag::read_write | open_flag::nomutex, ec);
+    if (ec)
+      return;
+
+    // a connection which has never read the database does not know it is in WAL mode
+    // and treats checkpoints as no-ops
+    if (!m_db.execute("PRAGMA schema_version", ec))
+      return;
+
+    const int64 page_size = get_pragma("PRAGMA page_size");
+    m_frame_size = (page_size > 0 ? static_cast<uint64>(page_size) : 4096) + wal_frame_header_size;
+    m_data_version = get_pragma("PRAGMA data_version");
+
+    m_last_checkpoint = clock_type::now();
+    m_thread = std::thread(&checkpoint_scheduler::run, this);
+  }
+
+  void checkpoint_scheduler::stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+    }
+    m_stop_cond.notify_all();
+    if (m_thread.joinable())
+      m_thread.join();
+  }
+
+  bool checkpoint_scheduler::checkpoint(checkpoint_mode mode, error_code_ref ec)
+  {
+    std::lock_guard<std::mutex> lock(m_db_mutex);
+    return run_checkpoint(mode, ec);
+  }
+
+  bool checkpoint_scheduler::run_checkpoint(checkpoint_mode mode, error_code_ref ec)
+  {
+    const clock_type::time_point start = clock_type::now();
+    error_code checkpoint_ec;
+    int log_frames = 0;
+    int checkpointed_frames = 0;
+    m_db.checkpoint(mode, log_frames, checkpointed_frames, checkpoint_ec);
+    const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    // the frames kept in the log by readers are still to be checkpointed
+    m_unchecked_frames = log_frames > checkpointed_frames ? static_cast<uint64>(log_frames - checkpointed_frames) : 0;
+    m_checked_wal_size = get_wal_size();
+    m_written = false;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stats.total_seconds += seconds;
+      m_stats.max_seconds = std::max(m_stats.max_seconds, seconds);
+      if (!checkpoint_ec) {
+        m_last_checkpoint = clock_type::now();
+        if (mode == checkpoint_mode::truncate)
+          m_stats.truncate_checkpoints++;
+        else
+          m_stats.passive_checkpoints++;
+      }
+      else if (checkpoint_ec.value() == SQLITE_BUSY || checkpoint_ec.value() == SQLITE_LOCKED) {
+        m_stats.busy_checkpoints++;
+      }
+      else {
+        m_stats.failed_checkpoints++;
+      }
+    }
+
+    ec.forward(checkpoint_ec);
+    return !checkpoint_ec;
+  }
+
+  int64 checkpoint_scheduler::get_pragma(const lite_string& sql)
+  {
+    error_code ec;
+    statement st(m_db, sql, ec);
+    return st.next(ec) ? st.get<int64>(0) : -1;
+  }
+
+  checkpoint_stats checkpoint_scheduler::get_stats() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+  }
+
+  uint64 checkpoint_scheduler::get_wal_size() const
+  {
+    boost::system::error_code ec;
+    boost::uintmax_t size = boost::filesystem::file_size(m_wal_path, ec);
+    return ec ? 0 : size;
+  }
+
+  void checkpoint_scheduler::run()
+  {
+    for (;;)
+    {
+      bool passive_due = false;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_stop_cond.wait_for(lock, m_policy.poll_interval, [this]() { return m_stopped; }))
+          break;
+        passive_due = clock_type::now() - m_last_checkpoint >= m_policy.passive_interval;
+      }
+
+      const uint64 wal_size = get_wal_size();
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.max_wal_size = std::max(m_stats.max_wal_size, wal_size);
+      }
+
+      std::lock_guard<std::mutex> lock(m_db_mutex);
+
+      // other connections have committed since the last poll
+      const int64 data_version = get_pragma("PRAGMA data_version");
+      if (data_version != m_data_version) {
+        m_data_version = data_version;
+        m_written = true;
+      }
+
+      // neither passive checkpoints nor restarts of the log shrink the file, so the frames to
+      // checkpoint are the ones left by the last checkpoint and the ones the file has grown by.
+      // Frames rewritten after a restart do not grow the file and wait for passive_interval
+      const uint64 grown = wal_size > m_checked_wal_size ? wal_size - m_checked_wal_size : 0;
+      const uint64 unchecked_size = m_unchecked_frames * m_frame_size + grown;
+
+      error_code ec;
+      if (wal_size >= m_policy.truncate_wal_size) {
+        // a busy truncate still moves the frames to the database as a passive one does
+        run_checkpoint(checkpoint_mode::truncate, ec);
+      }
+      else if (unchecked_size >= m_policy.passive_wal_size || (passive_due && (unchecked_size > 0 || m_written))) {
+        run_checkpoint(checkpoint_mode::passive, ec);
+      }
+    }
+  }
+
+}}}
@@ -0,0 +1,226 @@
+#include <easy/db/sqlite/connection_pool.h>
+
+#include <easy/stlex/make_unique.h>
+
+#include <algorithm>
+
+namespace easy { namespace db { namespace sqlite
+{
+  pooled_connection::pooled_connection()
+    : m_pool(nullptr)
+    , m_db(nullptr)
+    , m_writer(false)
+  {
+  }
+
+  pooled_connection::pooled_connection(connection_pool* pool, database* _db, bool writer)
+    : m_pool(pool)
+    , m_db(_db)
+    , m_writer(writer)
+  {
+  }
+
+  pooled_connection::pooled_connection(pooled_connection && r)
+    : m_pool(r.m_pool)
+    , m_db(r.m_db)
+    , m_writer(r.m_writer)
+  {
+    r.m_pool = nullptr;
+    r.m_db = nullptr;
+  }
+
+  pooled_connection& pooled_connection::operator = (pooled_connection && r)
+  {
+    if (&r != this) {
+      release();
+      std::swap(m_pool, r.m_pool);
+      std::swap(m_db, r.m_db);
+      std::swap(m_writer, r.m_writer);
+    }
+    return *this;
+  }
+
+  pooled_connection::~pooled_connection()
+  {
+    release();
+  }
+
+  void pooled_connection::release()
+  {
+    if (m_pool)
+      m_pool->release(m_db, m_writer);
+    m_pool = nullptr;
+    m_db = nullptr;
+  }
+
+  database& pooled_connection::operator * () const
+  {
+    EASY_ASSERT(m_db);
+    return *m_db;
+  }
+
+  database* pooled_connection::operator -> () const
+  {
+    EASY_ASSERT(m_db);
+    return m_db;
+  }
+
+  database* pooled_connection::get() const
+  {
+    return m_db;
+  }
+
+  bool pooled_connection::is_writer() const
+  {
+    return m_db && m_writer;
+  }
+
+  bool pooled_connection::operator ! () const
+  {
+    return !m_db;
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+
+  connection_pool::connection_pool(const lite_string& db_file_path, size_t readers, error_code_ref ec)
+    : m_writer_busy(false)
+  {
+    open(db_file_path, readers, open_flag::nomutex | open_flag::wal, ec);
+  }
+
+  connection_pool::connection_pool(const lite_string& db_file_path, size_t readers, open_flag flags, error_code_ref ec)
+    : m_writer_busy(false)
+  {
+    open(db_file_path, readers, flags, ec);
+  }
+
+  void connection_pool::open(const lite_string& db_file_path, size_t readers, open_flag flags, error_code_ref ec)
+  {
+    const open_flag access_flags = open_flag::read_only | open_flag::read_write | open_flag::create | open_flag::wal;
+    const open_flag common_flags = flags & ~access_flags;
+
+    // opened with a local code, so a throwing ec finds the pool closed
+    error_code open_ec;
+
+    // the writer goes first since it may create the database
+    m_writer = std::make_unique<database>(db_file_path, common_flags | open_flag::read_write | open_flag::create, open_ec);
+    if (!open_ec && (flags & open_flag::wal) == open_flag::wal)
+      m_writer->execute("PRAGMA journal_mode=WAL", open_ec);
+
+    m_readers.reserve(readers);
+    for (size_t i = 0; i < readers && !open_ec; ++i) {
+      database_ptr reader = std::make_unique<database>(db_file_path, common_flags | open_flag::read_only, open_ec);
+      if (open_ec)
+        break;
+      m_idle_readers.push_back(reader.get());
+      m_readers.push_back(std::move(reader));
+    }
+
+    // a pool opened partially would hand out dead connections
+    if (open_ec) {
+      m_idle_readers.clear();
+      m_readers.clear();
+      m_writer.reset();
+      ec.forward(open_ec);
+      return;
+    }
+    m_stats.readers = m_readers.size();
+  }
+
+  connection_pool::~connection_pool()
+  {
+    EASY_ASSERT(m_idle_readers.size() == m_readers.size() && !m_writer_busy);
+  }
+
+  pooled_connection connection_pool::acquire_reader(error_code_ref ec)
+  {
+    return acquire(false, nullptr, ec);
+  }
+
+  pooled_connection connection_pool::acquire_reader(duration_type timeout, error_code_ref ec)
+  {
+    return acquire(false, &timeout, ec);
+  }
+
+  pooled_connection connection_pool::acquire_writer(error_code_ref ec)
+  {
+    return acquire(true, nullptr, ec);
+  }
+
+  pooled_connection connection_pool::acquire_writer(duration_type timeout, error_code_ref ec)
+  {
+    return acquire(true, &timeout, ec);
+  }
+
+  pooled_connection connection_pool::acquire(bool writer, const duration_type* ptimeout, error_code_ref ec)
+  {
+    if (writer ? !m_writer : m_readers.empty()) {
+      ec = detail::make_db_error_code(static_cast<int>(result_code::null_database));
+      return pooled_connection();
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::condition_variable& cond = writer ? m_writer_cond : m_reader_cond;
+    auto is_available = [&]() -> bool {
+      return writer ? !m_writer_busy : !m_idle_readers.empty();
+    };
+
+    if (!is_available()) {
+      const clock_type::time_point start = clock_type::now();
+      bool available = true;
+      if (ptimeout)
+        available = cond.wait_for(lock, *ptimeout, is_available);
+      else
+        cond.wait(lock, is_available);
+
+      const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+      m_stats.waits++;
+      m_stats.total_wait_seconds += seconds;
+      m_stats.max_wait_seconds = std::max(m_stats.max_wait_seconds, seconds);
+
+      if (!available) {
+        m_stats.timeouts++;
+        lock.unlock();
+        ec = detail::make_db_error_code(static_cast<int>(result_code::pool_timeout));
+        return pooled_connection();
+      }
+    }
+
+    database* _db = nullptr;
+    if (writer) {
+      m_writer_busy = true;
+      m_stats.writer_checkouts++;
+      _db = m_writer.get();
+    }
+    else {
+      _db = m_idle_readers.back();
+      m_idle_readers.pop_back();
+      m_stats.reader_checkouts++;
+    }
+    return pooled_connection(this, _db, writer);
+  }
+
+  void connection_pool::release(database* _db, bool writer)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (writer)
+        m_writer_busy = false;
+      else
+        m_idle_readers.push_back(_db);
+    }
+    if (writer)
+      m_writer_cond.notify_one();
+    else
+      m_reader_cond.notify_one();
+  }
+
+  connection_pool_stats connection_pool::get_stats() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    connection_pool_stats stats = m_stats;
+    stats.idle_readers = m_idle_readers.size();
+    return stats;
+  }
+
+}}}
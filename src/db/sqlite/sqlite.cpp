@@ -2,12 +2,19 @@
 
 #include <easy/stlex/make_unique.h>
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 namespace easy { namespace db { namespace sqlite 
 {
 
   static error_category g_db_error_cat;
 
-  const char* error_category::name() const
+  const char* error_category::name() const BOOST_SYSTEM_NOEXCEPT
   {
     return "SQLite error";
   }
@@ -19,10 +26,16 @@ namespace easy { namespace db { namespace sqlite
 
     switch (ev)
     {
-    case result_code::null_database:
+    case static_cast<int>(result_code::null_database):
       return "null database";
-    case result_code::null_statement:
+    case static_cast<int>(result_code::null_statement):
       return "null statement";
+    case static_cast<int>(result_code::pool_timeout):
+      return "no pooled connection became available within the timeout";
+    case static_cast<int>(result_code::executor_stopped):
+      return "the executor has been stopped";
+    case static_cast<int>(result_code::null_blob):
+      return "null blob";
     default:
       break;
     }
@@ -43,26 +56,225 @@ namespace easy { namespace db { namespace sqlite
 
     //////////////////////////////////////////////////////////////////////////
 
+    //! LRU cache of idle prepared statements keyed by their SQL text
+    class statement_cache
+      : boost::noncopyable
+    {
+    public:
+      explicit statement_cache(size_t capacity) EASY_NOEXCEPT {
+        m_stats.capacity = capacity;
+      }
+
+      ~statement_cache() EASY_NOEXCEPT {
+        clear();
+      }
+
+      //! Takes an idle statement out of the cache. Returns nullptr if the query has not been cached
+      ::sqlite3_stmt* take(const std::string& sql) EASY_NOEXCEPT {
+        if (m_stats.capacity == 0)
+          return nullptr;
+
+        index_type::iterator it = m_index.find(sql);
+        if (it == m_index.end()) {
+          ++m_stats.misses;
+          return nullptr;
+        }
+
+        ++m_stats.hits;
+        ::sqlite3_stmt* stmt = it->second->second;
+        m_entries.erase(it->second);
+        m_index.erase(it);
+        return stmt;
+      }
+
+      //! Returns a statement to the cache. The statement is reset and its bindings are cleared
+      void put(std::string&& sql, ::sqlite3_stmt* stmt) EASY_NOEXCEPT {
+        EASY_ASSERT(stmt);
+        if (m_stats.capacity == 0 || m_index.count(sql) != 0) {
+          ::sqlite3_finalize(stmt);
+          return;
+        }
+
+        ::sqlite3_reset(stmt);
+        ::sqlite3_clear_bindings(stmt);
+
+        m_entries.push_front(entry_type(std::move(sql), stmt));
+        m_index[m_entries.front().first] = m_entries.begin();
+        shrink(m_stats.capacity);
+      }
+
+      void set_capacity(size_t capacity) EASY_NOEXCEPT {
+        m_stats.capacity = capacity;
+        shrink(capacity);
+      }
+
+      void clear() EASY_NOEXCEPT {
+        shrink(0);
+      }
+
+      statement_cache_stats get_stats() const EASY_NOEXCEPT {
+        statement_cache_stats stats = m_stats;
+        stats.size = m_entries.size();
+        return stats;
+      }
+
+    private:
+      void shrink(size_t size) EASY_NOEXCEPT {
+        while (m_entries.size() > size) {
+          ::sqlite3_finalize(m_entries.back().second);
+          m_index.erase(m_entries.back().first);
+          m_entries.pop_back();
+          ++m_stats.evictions;
+        }
+      }
+
+    private:
+      typedef std::pair<std::string, ::sqlite3_stmt*> entry_type;
+      typedef std::list<entry_type> entry_list;
+      typedef std::unordered_map<std::string, entry_list::iterator> index_type;
+    private:
+      entry_list m_entries; // the most recently used statements go first
+      index_type m_index;
+      statement_cache_stats m_stats;
+    };
+
+    typedef std::shared_ptr<statement_cache> statement_cache_ptr;
+    typedef std::weak_ptr<statement_cache> statement_cache_weak_ptr;
+
+    //////////////////////////////////////////////////////////////////////////
+
+    //! Collects the statement runs reported by sqlite3_trace_v2.
+    //! Trace callbacks come from the thread using the connection, snapshots may be taken from any thread
+    class query_profiler
+      : boost::noncopyable
+    {
+    public:
+      typedef std::chrono::steady_clock clock_type;
+
+      explicit query_profiler(const profiling_options& options)
+        : m_options(options) {
+      }
+
+      static int trace_callback(unsigned type, void* context, void* p, void* x) {
+        query_profiler* profiler = static_cast<query_profiler*>(context);
+        sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(p);
+        if (type == SQLITE_TRACE_ROW)
+          profiler->on_row(stmt);
+        else if (type == SQLITE_TRACE_PROFILE)
+          profiler->on_profile(stmt, *static_cast<sqlite3_int64*>(x));
+        return 0;
+      }
+
+      void on_prepare(sqlite3_stmt* stmt, clock_type::duration elapsed) {
+        const uint64 us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        get_stats(stmt).prepare_us.add(us);
+      }
+
+      std::vector<query_stats> get_snapshot() const {
+        std::vector<query_stats> snapshot;
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          snapshot.reserve(m_queries.size());
+          for (auto it = m_queries.begin(); it != m_queries.end(); ++it)
+            snapshot.push_back(it->second);
+        }
+        // the most expensive go first
+        std::sort(snapshot.begin(), snapshot.end(), [](const query_stats& l, const query_stats& r) {
+          return l.step_us.sum > r.step_us.sum;
+        });
+        return snapshot;
+      }
+
+      void reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queries.clear();
+      }
+
+    private:
+      void on_row(sqlite3_stmt* stmt) {
+        m_rows[stmt]++;
+      }
+
+      void on_profile(sqlite3_stmt* stmt, sqlite3_int64 ns) {
+        slow_query run;
+        run.step_us = static_cast<uint64>(ns / 1000);
+        run.vm_steps = ::sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+        run.fullscan_steps = ::sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+        run.sorts = ::sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+
+        auto it = m_rows.find(stmt);
+        if (it != m_rows.end()) {
+          run.rows = it->second;
+          m_rows.erase(it);
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          query_stats& stats = get_stats(stmt);
+          stats.step_us.add(run.step_us);
+          stats.rows.add(run.rows);
+          stats.vm_steps.add(run.vm_steps);
+          stats.fullscan_steps.add(run.fullscan_steps);
+          stats.sorts.add(run.sorts);
+        }
+
+        if (m_options.slow_query_callback && run.step_us >= static_cast<uint64>(m_options.slow_query_threshold.count())) {
+          const char* sql = ::sqlite3_sql(stmt);
+          run.sql = sql ? sql : "";
+          try {
+            m_options.slow_query_callback(run);
+          }
+          catch (...) {
+            EASY_ASSERT(!"A slow query callback must not throw");
+          }
+        }
+      }
+
+      query_stats& get_stats(sqlite3_stmt* stmt) {
+        const char* sql = ::sqlite3_sql(stmt);
+        std::string key = sql ? sql : "";
+        query_stats& stats = m_queries[key];
+        if (stats.sql.empty())
+          stats.sql = std::move(key);
+        return stats;
+      }
+
+    private:
+      const profiling_options m_options;
+      std::unordered_map<sqlite3_stmt*, uint64> m_rows; // rows of the runs in progress
+      mutable std::mutex m_mutex;
+      std::unordered_map<std::string, query_stats> m_queries;
+    };
+
+    typedef std::shared_ptr<query_profiler> query_profiler_ptr;
+
+    //////////////////////////////////////////////////////////////////////////
+
     class database_impl 
       : boost::noncopyable
     {
     public:
       database_impl(const lite_string& file_path) EASY_NOEXCEPT
         : m_is_v2(false)
+        , m_cache_ptr(std::make_shared<statement_cache>(database::default_statement_cache_capacity))
       {
         m_code = ::sqlite3_open(file_path.c_str(), &m_db);
       }
 
       database_impl(const lite_string& file_path, int flags)  EASY_NOEXCEPT
         : m_is_v2(true)
+        , m_cache_ptr(std::make_shared<statement_cache>(database::default_statement_cache_capacity))
       {
         m_code = ::sqlite3_open_v2(file_path.c_str(), &m_db, flags, nullptr);
       }
 
       ~database_impl() EASY_NOEXCEPT {
+        m_cache_ptr.reset(); // cached statements must be finalized before the database is closed
         if (m_db) {
           int res = m_is_v2 ? ::sqlite3_close_v2(m_db) : ::sqlite3_close(m_db);
           EASY_ASSERT(res == SQLITE_OK);
+          (void)res;
         }
       }
 
@@ -70,10 +282,53 @@ namespace easy { namespace db { namespace sqlite
         return (m_code = ::sqlite3_exec(m_db, sql.c_str(), nullptr, nullptr, nullptr));
       }
 
+      int set_busy_timeout(int ms) EASY_NOEXCEPT {
+        return (m_code = ::sqlite3_busy_timeout(m_db, ms));
+      }
+
+      int checkpoint(int mode, int* plog_frames, int* pcheckpointed_frames) EASY_NOEXCEPT {
+        return (m_code = ::sqlite3_wal_checkpoint_v2(m_db, nullptr, mode, plog_frames, pcheckpointed_frames));
+      }
+
+      int enable_profiling(const profiling_options& options) {
+        query_profiler_ptr profiler_ptr = std::make_shared<query_profiler>(options);
+        m_code = ::sqlite3_trace_v2(m_db, SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, &query_profiler::trace_callback, profiler_ptr.get());
+        if (m_code == SQLITE_OK) {
+          std::lock_guard<std::mutex> lock(m_profiler_mutex);
+          m_profiler_ptr = std::move(profiler_ptr);
+        }
+        return m_code;
+      }
+
+      void disable_profiling() EASY_NOEXCEPT {
+        ::sqlite3_trace_v2(m_db, 0, nullptr, nullptr);
+        std::lock_guard<std::mutex> lock(m_profiler_mutex);
+        m_profiler_ptr.reset();
+      }
+
+      //! For the thread using the connection, the only one which replaces the profiler
+      query_profiler* get_profiler() const EASY_NOEXCEPT {
+        return m_profiler_ptr.get();
+      }
+
+      //! For any thread, the profiler stays alive while it is used even if profiling is disabled
+      query_profiler_ptr share_profiler() const {
+        std::lock_guard<std::mutex> lock(m_profiler_mutex);
+        return m_profiler_ptr;
+      }
+
       ::sqlite3* get_handle() const EASY_NOEXCEPT {
         return m_db;
       }
 
+      statement_cache& get_cache() const EASY_NOEXCEPT {
+        return *m_cache_ptr;
+      }
+
+      const statement_cache_ptr& get_cache_ptr() const EASY_NOEXCEPT {
+        return m_cache_ptr;
+      }
+
       error_code get_last_ec() const EASY_NOEXCEPT {
         return make_db_error_code(m_code);
       }
@@ -82,6 +337,9 @@ namespace easy { namespace db { namespace sqlite
       const bool m_is_v2;
       int m_code;
       ::sqlite3* m_db;
+      mutable std::mutex m_profiler_mutex; // guards m_profiler_ptr against other threads taking snapshots
+      query_profiler_ptr m_profiler_ptr; // outlives the cache, finalized statements still report their runs
+      statement_cache_ptr m_cache_ptr;
     };
 
     //////////////////////////////////////////////////////////////////////////
@@ -90,19 +348,52 @@ namespace easy { namespace db { namespace sqlite
       : boost::noncopyable
     {
     public:
-      statement_impl(database_impl& _db, const lite_string& query) EASY_NOEXCEPT
+      statement_impl(database_impl& _db, const lite_string& query)
         : m_stmt(nullptr)
+        , m_code(SQLITE_OK)
       {
-        m_code = ::sqlite3_prepare_v2(_db.get_handle(), query.c_str(), query.length(), &m_stmt, nullptr);
+        if (_db.get_cache().get_stats().capacity > 0) {
+          m_sql.assign(query.c_str(), query.length());
+          m_cache_ptr = _db.get_cache_ptr();
+          m_stmt = _db.get_cache().take(m_sql);
+        }
+        if (!m_stmt) {
+          query_profiler* profiler = _db.get_profiler();
+          const query_profiler::clock_type::time_point start = profiler ? query_profiler::clock_type::now() : query_profiler::clock_type::time_point();
+          m_code = ::sqlite3_prepare_v2(_db.get_handle(), query.c_str(), query.length(), &m_stmt, nullptr);
+          if (profiler && m_stmt)
+            profiler->on_prepare(m_stmt, query_profiler::clock_type::now() - start);
+        }
       }
 
       ~statement_impl() EASY_NOEXCEPT {
-        if (m_stmt)
+        if (!m_stmt)
+          return;
+        statement_cache_ptr cache_ptr = m_cache_ptr.lock();
+        if (cache_ptr)
+          cache_ptr->put(std::move(m_sql), m_stmt);
+        else
           ::sqlite3_finalize(m_stmt);
       }
 
-      void step() EASY_NOEXCEPT {
-        m_code = ::sqlite3_step(m_stmt);
+      int step() EASY_NOEXCEPT {
+        return (m_code = ::sqlite3_step(m_stmt));
+      }
+
+      int reset() EASY_NOEXCEPT {
+        return (m_code = ::sqlite3_reset(m_stmt));
+      }
+
+      int clear_bindings() EASY_NOEXCEPT {
+        return (m_code = ::sqlite3_clear_bindings(m_stmt));
+      }
+
+      int set_code(int code) EASY_NOEXCEPT {
+        return (m_code = code);
+      }
+
+      ::sqlite3_stmt* get_handle() const EASY_NOEXCEPT {
+        return m_stmt;
       }
 
       error_code get_last_ec() const EASY_NOEXCEPT {
@@ -111,6 +402,53 @@ namespace easy { namespace db { namespace sqlite
     private:
       ::sqlite3_stmt* m_stmt;
       int m_code;
+      std::string m_sql;
+      statement_cache_weak_ptr m_cache_ptr; // the statement goes back to the cache on destruction
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+
+    class blob_impl
+      : boost::noncopyable
+    {
+    public:
+      blob_impl(database_impl& _db, const lite_string& table, const lite_string& column, int64 rowid, bool writable) EASY_NOEXCEPT
+        : m_blob(nullptr)
+      {
+        m_code = ::sqlite3_blob_open(_db.get_handle(), "main", table.c_str(), column.c_str(), rowid, writable ? 1 : 0, &m_blob);
+      }
+
+      ~blob_impl() EASY_NOEXCEPT {
+        if (m_blob)
+          ::sqlite3_blob_close(m_blob);
+      }
+
+      int reopen(int64 rowid) EASY_NOEXCEPT {
+        return (m_code = ::sqlite3_blob_reopen(m_blob, rowid));
+      }
+
+      int read(byte* buffer, size_t size, size_t offset) EASY_NOEXCEPT {
+        if (size > INT_MAX || offset > INT_MAX)
+          return (m_code = SQLITE_TOOBIG);
+        return (m_code = ::sqlite3_blob_read(m_blob, buffer, static_cast<int>(size), static_cast<int>(offset)));
+      }
+
+      int write(const byte* data, size_t size, size_t offset) EASY_NOEXCEPT {
+        if (size > INT_MAX || offset > INT_MAX)
+          return (m_code = SQLITE_TOOBIG);
+        return (m_code = ::sqlite3_blob_write(m_blob, data, static_cast<int>(size), static_cast<int>(offset)));
+      }
+
+      size_t size() const EASY_NOEXCEPT {
+        return static_cast<size_t>(::sqlite3_blob_bytes(m_blob));
+      }
+
+      error_code get_last_ec() const EASY_NOEXCEPT {
+        return make_db_error_code(m_code);
+      }
+    private:
+      ::sqlite3_blob* m_blob;
+      int m_code;
     };
 
   }
@@ -119,6 +457,36 @@ namespace easy { namespace db { namespace sqlite
 
   //////////////////////////////////////////////////////////////////////////
 
+  const size_t database::default_statement_cache_capacity;
+
+  //////////////////////////////////////////////////////////////////////////
+
+  const size_t query_histogram::bucket_count;
+
+  void query_histogram::add(uint64 value)
+  {
+    size_t index = 0;
+    for (uint64 v = value; v && index + 1 < bucket_count; v >>= 1)
+      ++index;
+
+    count++;
+    sum += value;
+    largest = std::max(largest, value);
+    buckets[index]++;
+  }
+
+  uint64 query_histogram::get_percentile(double p) const
+  {
+    const uint64 target = std::max<uint64>(1, static_cast<uint64>(p * count + 0.5));
+    uint64 seen = 0;
+    for (size_t index = 0; index + 1 < bucket_count; ++index) {
+      seen += buckets[index];
+      if (seen >= target)
+        return index ? std::min((uint64(1) << index) - 1, largest) : 0;
+    }
+    return largest;
+  }
+
   database::database()
   {
   }
@@ -145,6 +513,16 @@ namespace easy { namespace db { namespace sqlite
       m_impl_ptr.reset();
   }
 
+  database::database(const lite_string& db_file_path, open_flag flags, const database_options& options, error_code_ref ec)
+    : m_impl_ptr(std::make_unique<database_impl>(db_file_path.c_str(), static_cast<int>(flags)))
+  {
+    ec = m_impl_ptr->get_last_ec();
+    if (!ec)
+      apply_options(options, ec);
+    if (ec)
+      m_impl_ptr.reset();
+  }
+
   database::~database()
   {
 
@@ -152,7 +530,7 @@ namespace easy { namespace db { namespace sqlite
 
   database& database::operator=(database && r)
   {
-    m_impl_ptr.swap(std::move(r.m_impl_ptr));
+    m_impl_ptr.swap(r.m_impl_ptr);
     return *this;
   }
 
@@ -168,6 +546,98 @@ namespace easy { namespace db { namespace sqlite
     return !ec;
   }
 
+  namespace
+  {
+    const char* get_journal_mode_name(journal_mode mode)
+    {
+      switch (mode)
+      {
+      case journal_mode::delete_:  return "DELETE";
+      case journal_mode::truncate: return "TRUNCATE";
+      case journal_mode::persist:  return "PERSIST";
+      case journal_mode::memory:   return "MEMORY";
+      case journal_mode::wal:      return "WAL";
+      case journal_mode::off:      return "OFF";
+      default:
+        break;
+      }
+      return nullptr;
+    }
+
+    const char* get_synchronous_mode_name(synchronous_mode mode)
+    {
+      switch (mode)
+      {
+      case synchronous_mode::off:    return "OFF";
+      case synchronous_mode::normal: return "NORMAL";
+      case synchronous_mode::full:   return "FULL";
+      case synchronous_mode::extra:  return "EXTRA";
+      default:
+        break;
+      }
+      return nullptr;
+    }
+  }
+
+  database_options database_options::wal_profile()
+  {
+    database_options options;
+    options.journal = journal_mode::wal;
+    options.synchronous = synchronous_mode::normal;
+    options.mmap_size = 256 * 1024 * 1024;
+    options.cache_size = -64 * 1024;
+    return options;
+  }
+
+  bool database::apply_options(const database_options& options, error_code_ref ec)
+  {
+    if (!m_impl_ptr) {
+      ec = make_db_error_code(result_code::null_database);
+      return false;
+    }
+
+    std::string sql;
+    if (const char* mode = get_journal_mode_name(options.journal))
+      sql.append("PRAGMA journal_mode=").append(mode).append(";");
+    if (const char* mode = get_synchronous_mode_name(options.synchronous))
+      sql.append("PRAGMA synchronous=").append(mode).append(";");
+    if (options.mmap_size)
+      sql.append("PRAGMA mmap_size=").append(std::to_string(options.mmap_size.get())).append(";");
+    if (options.cache_size)
+      sql.append("PRAGMA cache_size=").append(std::to_string(options.cache_size.get())).append(";");
+    if (options.wal_autocheckpoint)
+      sql.append("PRAGMA wal_autocheckpoint=").append(std::to_string(options.wal_autocheckpoint.get())).append(";");
+
+    if (options.busy_timeout) {
+      m_impl_ptr->set_busy_timeout(options.busy_timeout.get());
+      ec = m_impl_ptr->get_last_ec();
+      if (ec)
+        return false;
+    }
+    return sql.empty() || execute(sql, ec);
+  }
+
+  bool database::checkpoint(checkpoint_mode mode, error_code_ref ec)
+  {
+    int log_frames = 0;
+    int checkpointed_frames = 0;
+    return checkpoint(mode, log_frames, checkpointed_frames, ec);
+  }
+
+  bool database::checkpoint(checkpoint_mode mode, int& log_frames, int& checkpointed_frames, error_code_ref ec)
+  {
+    log_frames = -1;
+    checkpointed_frames = -1;
+    if (m_impl_ptr) {
+      m_impl_ptr->checkpoint(static_cast<int>(mode), &log_frames, &checkpointed_frames);
+      ec = m_impl_ptr->get_last_ec();
+    }
+    else {
+      ec = make_db_error_code(result_code::null_database);
+    }
+    return !ec;
+  }
+
   statement database::create_statement(const lite_string& query, error_code_ref ec)
   {
     if (m_impl_ptr) {
@@ -182,6 +652,70 @@ namespace easy { namespace db { namespace sqlite
     return statement();
   }
 
+  blob_stream database::open_blob(const lite_string& table, const lite_string& column, int64 rowid, blob_access access, error_code_ref ec)
+  {
+    if (m_impl_ptr) {
+      blob_stream::impl_ptr pb(std::make_unique<blob_impl>(*m_impl_ptr, table, column, rowid, access == blob_access::read_write));
+      ec = pb->get_last_ec();
+      if (!ec)
+        return blob_stream(std::move(pb));
+    }
+    else {
+      ec = make_db_error_code(result_code::null_database);
+    }
+    return blob_stream();
+  }
+
+  bool database::enable_profiling(const profiling_options& options, error_code_ref ec)
+  {
+    if (m_impl_ptr) {
+      m_impl_ptr->enable_profiling(options);
+      ec = m_impl_ptr->get_last_ec();
+    }
+    else {
+      ec = make_db_error_code(result_code::null_database);
+    }
+    return !ec;
+  }
+
+  void database::disable_profiling()
+  {
+    if (m_impl_ptr)
+      m_impl_ptr->disable_profiling();
+  }
+
+  std::vector<query_stats> database::get_profile_snapshot() const
+  {
+    const query_profiler_ptr profiler_ptr = m_impl_ptr ? m_impl_ptr->share_profiler() : query_profiler_ptr();
+    return profiler_ptr ? profiler_ptr->get_snapshot() : std::vector<query_stats>();
+  }
+
+  void database::reset_profile()
+  {
+    const query_profiler_ptr profiler_ptr = m_impl_ptr ? m_impl_ptr->share_profiler() : query_profiler_ptr();
+    if (profiler_ptr)
+      profiler_ptr->reset();
+  }
+
+  void database::set_statement_cache_capacity(size_t capacity)
+  {
+    if (m_impl_ptr)
+      m_impl_ptr->get_cache().set_capacity(capacity);
+  }
+
+  void database::clear_statement_cache()
+  {
+    if (m_impl_ptr)
+      m_impl_ptr->get_cache().clear();
+  }
+
+  statement_cache_stats database::get_statement_cache_stats() const
+  {
+    if (m_impl_ptr)
+      return m_impl_ptr->get_cache().get_stats();
+    return statement_cache_stats();
+  }
+
   //////////////////////////////////////////////////////////////////////////
 
   statement::statement()
@@ -208,7 +742,7 @@ namespace easy { namespace db { namespace sqlite
   
   statement& statement::operator=(statement && r)
   {
-    m_impl_ptr.swap(std::move(r.m_impl_ptr));
+    m_impl_ptr.swap(r.m_impl_ptr);
     return *this;
   }
 
@@ -219,10 +753,10 @@ namespace easy { namespace db { namespace sqlite
 
   bool statement::next(error_code_ref ec)
   {
-    int res = SQLITE_ERROR;
+    int res = static_cast<int>(result_code::null_statement);
     EASY_ASSERT(!!m_impl_ptr);
     if (m_impl_ptr) {
-      m_impl_ptr->step();
+      res = m_impl_ptr->step();
 
       if (res == SQLITE_ROW)
         return true;
@@ -231,16 +765,273 @@ namespace easy { namespace db { namespace sqlite
     }
     ec = make_db_error_code(res);
     return false;
+  }
+
+  bool statement::reset(error_code_ref ec)
+  {
+    if (m_impl_ptr) {
+      m_impl_ptr->reset();
+      ec = m_impl_ptr->get_last_ec();
+    }
+    else {
+      ec = make_db_error_code(result_code::null_statement);
+    }
+    return !ec;
+  }
+
+  bool statement::clear_bindings(error_code_ref ec)
+  {
+    if (m_impl_ptr) {
+      m_impl_ptr->clear_bindings();
+      ec = m_impl_ptr->get_last_ec();
+    }
+    else {
+      ec = make_db_error_code(result_code::null_statement);
+    }
+    return !ec;
+  }
+
+  namespace 
+  {
+    template<class Binder>
+    bool bind_impl(const statement::impl_ptr& impl_ptr, error_code_ref ec, Binder binder)
+    {
+      if (impl_ptr) {
+        impl_ptr->set_code(binder(impl_ptr->get_handle()));
+        ec = impl_ptr->get_last_ec();
+      }
+      else {
+        ec = make_db_error_code(result_code::null_statement);
+      }
+      return !ec;
+    }
+  }
+
+  bool statement::bind_at(int index, nullptr_t, error_code_ref ec)
+  {
+    return bind_impl(m_impl_ptr, ec, [&](::sqlite3_stmt* stmt) {
+      return ::sqlite3_bind_null(stmt, index);
+    });
+  }
+
+  bool statement::bind_at(int index, int value, error_code_ref ec)
+  {
+    return bind_impl(m_impl_ptr, ec, [&](::sqlite3_stmt* stmt) {
+      return ::sqlite3_bind_int(stmt, index, value);
+    });
+  }
+
+  bool statement::bind_at(int index, uint32 value, error_code_ref ec)
+  {
+    return bind_at(index, static_cast<int64>(value), ec);
+  }
+
+  bool statement::bind_at(int index, int64 value, error_code_ref ec)
+  {
+    return bind_impl(m_impl_ptr, ec, [&](::sqlite3_stmt* stmt) {
+      return ::sqlite3_bind_int64(stmt, index, value);
+    });
+  }
+
+  bool statement::bind_at(int index, double value, error_code_ref ec)
+  {
+    return bind_impl(m_impl_ptr, ec, [&](::sqlite3_stmt* stmt) {
+      return ::sqlite3_bind_double(stmt, index, value);
+    });
+  }
+
+  bool statement::bind_at(int index, const lite_string& value, error_code_ref ec)
+  {
+    return bind_impl(m_impl_ptr, ec, [&](::sqlite3_stmt* stmt) {
+      // an empty but not null string must be bound as text
+      return ::sqlite3_bind_text(stmt, index, value.empty() ? "" : value.c_str(), static_cast<int>(value.length()), SQLITE_TRANSIENT);
+    });
+  }
+
+  bool statement::bind_at(int index, const lite_buffer<byte>& value, error_code_ref ec)
+  {
+    return bind_impl(m_impl_ptr, ec, [&](::sqlite3_stmt* stmt) {
+      return value.empty()
+        ? ::sqlite3_bind_zeroblob(stmt, index, 0)
+        : ::sqlite3_bind_blob(stmt, index, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+    });
+  }
+
+  int statement::get_column_count() const
+  {
+    return m_impl_ptr ? ::sqlite3_column_count(m_impl_ptr->get_handle()) : 0;
+  }
+
+  column_kind statement::get_column_kind(int col) const
+  {
+    EASY_ASSERT(!!m_impl_ptr);
+    return static_cast<column_kind>(::sqlite3_column_type(m_impl_ptr->get_handle(), col));
+  }
 
-    
-    
-    
+  bool statement::is_null(int col) const
+  {
+    return get_column_kind(col) == column_kind::null;
   }
 
+  int statement::get_int(int col) const
+  {
+    EASY_ASSERT(!!m_impl_ptr);
+    return ::sqlite3_column_int(m_impl_ptr->get_handle(), col);
+  }
 
+  int64 statement::get_int64(int col) const
+  {
+    EASY_ASSERT(!!m_impl_ptr);
+    return ::sqlite3_column_int64(m_impl_ptr->get_handle(), col);
+  }
 
+  double statement::get_double(int col) const
+  {
+    EASY_ASSERT(!!m_impl_ptr);
+    return ::sqlite3_column_double(m_impl_ptr->get_handle(), col);
+  }
 
+  lite_string statement::get_text(int col) const
+  {
+    EASY_ASSERT(!!m_impl_ptr);
+    ::sqlite3_stmt* stmt = m_impl_ptr->get_handle();
+    // sqlite3_column_bytes must be called after the text is obtained
+    const char* ptext = reinterpret_cast<const char*>(::sqlite3_column_text(stmt, col));
+    return lite_string(ptext, ::sqlite3_column_bytes(stmt, col));
+  }
+
+  lite_buffer<byte> statement::get_blob(int col) const
+  {
+    EASY_ASSERT(!!m_impl_ptr);
+    ::sqlite3_stmt* stmt = m_impl_ptr->get_handle();
+    const byte* pdata = static_cast<const byte*>(::sqlite3_column_blob(stmt, col));
+    if (!pdata)
+      return lite_buffer<byte>();
+    return lite_buffer<byte>(pdata, ::sqlite3_column_bytes(stmt, col));
+  }
 
+  //////////////////////////////////////////////////////////////////////////
+
+  blob_stream::blob_stream()
+    : m_position()
+  {
+
+  }
 
+  blob_stream::~blob_stream()
+  {
+
+  }
+
+  blob_stream::blob_stream(blob_stream && r)
+    : m_impl_ptr(std::move(r.m_impl_ptr))
+    , m_position(r.m_position)
+  {
+
+  }
+
+  blob_stream::blob_stream(impl_ptr && r)
+    : m_impl_ptr(std::move(r))
+    , m_position()
+  {
+
+  }
+
+  blob_stream& blob_stream::operator=(blob_stream && r)
+  {
+    m_impl_ptr.swap(r.m_impl_ptr);
+    std::swap(m_position, r.m_position);
+    return *this;
+  }
+
+  blob_stream::blob_stream(database& _db, const lite_string& table, const lite_string& column, int64 rowid, blob_access access, error_code_ref ec)
+    : m_position()
+  {
+    *this = _db.open_blob(table, column, rowid, access, ec);
+  }
+
+  bool blob_stream::reopen(int64 rowid, error_code_ref ec)
+  {
+    if (m_impl_ptr) {
+      m_impl_ptr->reopen(rowid);
+      ec = m_impl_ptr->get_last_ec();
+      m_position = 0;
+    }
+    else {
+      ec = make_db_error_code(result_code::null_blob);
+    }
+    return !ec;
+  }
+
+  size_t blob_stream::read(byte* buffer, size_t size, error_code_ref ec)
+  {
+    const size_t read = read_at(m_position, buffer, size, ec);
+    m_position += read;
+    return read;
+  }
+
+  bool blob_stream::write(const byte* data, size_t size, error_code_ref ec)
+  {
+    if (!write_at(m_position, data, size, ec))
+      return false;
+    m_position += size;
+    return true;
+  }
+
+  size_t blob_stream::read_at(size_t offset, byte* buffer, size_t size, error_code_ref ec)
+  {
+    if (!m_impl_ptr) {
+      ec = make_db_error_code(result_code::null_blob);
+      return 0;
+    }
+
+    // sqlite fails reads crossing the end, so the tail is read partially
+    const size_t total = m_impl_ptr->size();
+    if (offset >= total)
+      return 0;
+    size = std::min(size, total - offset);
+
+    m_impl_ptr->read(buffer, size, offset);
+    ec = m_impl_ptr->get_last_ec();
+    return ec ? 0 : size;
+  }
+
+  bool blob_stream::write_at(size_t offset, const byte* data, size_t size, error_code_ref ec)
+  {
+    if (m_impl_ptr) {
+      m_impl_ptr->write(data, size, offset);
+      ec = m_impl_ptr->get_last_ec();
+    }
+    else {
+      ec = make_db_error_code(result_code::null_blob);
+    }
+    return !ec;
+  }
+
+  void blob_stream::seek(size_t position)
+  {
+    m_position = std::min(position, size());
+  }
+
+  size_t blob_stream::tell() const
+  {
+    return m_position;
+  }
+
+  size_t blob_stream::size() const
+  {
+    return m_impl_ptr ? m_impl_ptr->size() : 0;
+  }
+
+  void blob_stream::close()
+  {
+    m_impl_ptr.reset();
+    m_position = 0;
+  }
+
+  bool blob_stream::is_open() const
+  {
+    return !!m_impl_ptr;
+  }
 
-}}}
\ No newline at end of file
+}}}
@@ -1,5 +1,10 @@
 #include <easy/error_handling.h>
 
+#ifdef EASY_NO_EXCEPTIONS
+#  include <atomic>
+#  include <cstdlib>
+#endif
+
 namespace easy
 {
   namespace 
@@ -13,7 +18,7 @@ namespace easy
   }
 
 
-  const char* generic_error_category::name() const
+  const char* generic_error_category::name() const BOOST_SYSTEM_NOEXCEPT
   {
     return "easy generic error";
   }
@@ -22,10 +27,16 @@ namespace easy
   {
     switch (ev)
     {
-      case generic_error::null_ptr
+      case static_cast<int>(generic_error::null_ptr)
         : return "null pointer";
-        case generic_error::invalid_value
+        case static_cast<int>(generic_error::invalid_value)
           : return "invalid value";
+        case static_cast<int>(generic_error::unexpected)
+          : return "unexpected error";
+        case static_cast<int>(generic_error::bad_cast)
+          : return "bad cast";
+        case static_cast<int>(generic_error::out_of_range)
+          : return "value out of range";
     }
     EASY_ASSERT(!"Unknown error code");
     return std::string();
@@ -33,47 +44,6 @@ namespace easy
 
   //////////////////////////////////////////////////////////////////////////
 
-  error_code_ref::error_code_ref()
-    : m_pcode(nullptr)
-  {
-
-  }
-
-  error_code_ref::error_code_ref(nullptr_t)
-    : m_pcode(nullptr)
-  {
-
-  }
-
-  error_code_ref::error_code_ref(error_code& ec)
-    : m_pcode(&ec) 
-  {
-    clear();
-  }
-
-  error_code_ref::error_code_ref(error_code* ec)
-    : m_pcode(ec) 
-  {
-    clear();
-  }
-
-  error_code_ref::error_code_ref(const error_code_ref& ec)
-    : m_pcode(ec.m_pcode) 
-  {
-    clear();
-  }
-
-  error_code_ref& error_code_ref::operator = (const error_code& ec)
-  {
-    if (!m_pcode) {
-      if (ec)
-        throw system_error(ec);
-    } else {
-      *m_pcode = ec;
-    }      
-    return *this;
-  }
-
   void error_code_ref::assign(int code, const error_category& cat)
   {
     *this = error_code(code, cat);
@@ -89,60 +59,47 @@ namespace easy
     set(code, boost::system::system_category());
   }
 
-  void error_code_ref::clear()
-  {
-    if (m_pcode)
-      m_pcode->clear();
-  }
-
-  detail::error_code_holder error_code_ref::get()
-  {
-    return detail::error_code_holder(m_pcode);
-  }
+  //////////////////////////////////////////////////////////////////////////
 
-  bool error_code_ref::is_throwable() const
+#ifdef EASY_NO_EXCEPTIONS
+  namespace
   {
-    return !m_pcode;
-  }
+    void abort_on_error(const error_code&)
+    {
+      EASY_ASSERT(!"An error is assigned to a throwable error_code_ref while exceptions are disabled.");
+      std::abort();
+    }
 
-  bool error_code_ref::is_error() const
-  {
-    return m_pcode && *m_pcode;
+    std::atomic<unhandled_error_handler> g_unhandled_error_handler(&abort_on_error);
   }
 
-  bool error_code_ref::operator ! () const
+  unhandled_error_handler set_unhandled_error_handler(unhandled_error_handler handler)
   {
-    return !is_error();
+    return g_unhandled_error_handler.exchange(handler ? handler : &abort_on_error);
   }
-
-  //////////////////////////////////////////////////////////////////////////
+#endif
 
   namespace detail
   {
-    error_code_holder::error_code_holder(error_code* ec)
-      : m_code(!ec ? m_own_code : *ec)
+    void raise_error(const error_code& ec)
     {
-
+#ifdef EASY_NO_EXCEPTIONS
+      g_unhandled_error_handler.load()(ec);
+#else
+      throw system_error(ec);
+#endif
     }
 
-    error_code_holder::~error_code_holder()
+    void error_code_holder::raise_held_error(const error_code& ec)
     {
-      if (m_own_code) {
-        if (!std::uncaught_exception())
-          throw system_error(m_own_code);
+#ifndef EASY_NO_EXCEPTIONS
+      if (std::uncaught_exception()) {
         EASY_ASSERT(!"The stack is unwinding now. An exception cannot be thrown.");
+        return;
       }
-    }
-
-    error_code_holder::operator error_code& ()
-    {
-      return m_code;
-    }
-
-    error_code_holder::operator error_code* ()
-    {
-      return &m_code;
+#endif
+      raise_error(ec);
     }
   }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,148 @@
+#include <easy/error_telemetry.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace easy
+{
+  namespace
+  {
+    //! Errors of one thread. Only the owner thread adds entries and counts, other threads read
+    struct thread_counters
+    {
+      //! Different errors counted by a thread, the others are untracked
+      static const size_t capacity = 64;
+
+      struct entry
+      {
+        const error_category* pcategory;
+        int code;
+        std::atomic<uint64> count;
+      };
+
+      thread_counters() EASY_NOEXCEPT
+        : size(0), untracked(0), since_sample(0), sampling(false) {
+      }
+
+      void add(const error_code& ec) EASY_NOEXCEPT {
+        const size_t n = size.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < n; ++i) {
+          entry& e = entries[i];
+          if (e.code == ec.value() && *e.pcategory == ec.category()) {
+            e.count.store(e.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+          }
+        }
+        if (n == capacity) {
+          untracked.store(untracked.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+          return;
+        }
+        // the entry is filled before it is published by the size
+        entry& e = entries[n];
+        e.pcategory = &ec.category();
+        e.code = ec.value();
+        e.count.store(1, std::memory_order_relaxed);
+        size.store(n + 1, std::memory_order_release);
+      }
+
+      entry entries[capacity];
+      std::atomic<size_t> size;
+      std::atomic<uint64> untracked;
+
+      // used by the owner only
+      unsigned int since_sample;
+      bool sampling;
+    };
+
+    const size_t thread_counters::capacity;
+
+    //! Counters of the threads. The counters of finished threads are kept for the totals
+    //! and taken over by new threads with the same id
+    typedef std::map<std::thread::id, thread_counters*> counters_registry;
+
+    std::mutex g_mutex;
+    // never destroyed, since threads still running at exit count errors in their tables
+    counters_registry* g_pcounters = nullptr;
+
+    std::atomic<error_sampler> g_sampler(nullptr);
+    std::atomic<unsigned int> g_sample_interval(1);
+
+    EASY_THREAD_LOCAL thread_counters* t_pcounters = nullptr;
+
+    thread_counters& get_counters()
+    {
+      if (t_pcounters)
+        return *t_pcounters;
+
+      std::lock_guard<std::mutex> lock(g_mutex);
+      if (!g_pcounters)
+        g_pcounters = new counters_registry();
+      thread_counters*& pcounters = (*g_pcounters)[std::this_thread::get_id()];
+      if (!pcounters)
+        pcounters = new thread_counters();
+      t_pcounters = pcounters;
+      return *pcounters;
+    }
+
+    bool more_frequent(const error_counter& c1, const error_counter& c2)
+    {
+      return c1.count > c2.count;
+    }
+  }
+
+  error_snapshot get_error_snapshot()
+  {
+    error_snapshot snapshot;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_pcounters)
+      return snapshot;
+    for (auto it = g_pcounters->begin(); it != g_pcounters->end(); ++it) {
+      const thread_counters& counters = *it->second;
+      const size_t size = counters.size.load(std::memory_order_acquire);
+      for (size_t i = 0; i < size; ++i) {
+        const thread_counters::entry& e = counters.entries[i];
+        const uint64 count = e.count.load(std::memory_order_relaxed);
+        auto pos = snapshot.counters.begin();
+        while (pos != snapshot.counters.end() && !(pos->code == e.code && *pos->pcategory == *e.pcategory))
+          ++pos;
+        if (pos != snapshot.counters.end())
+          pos->count += count;
+        else {
+          const error_counter counter = { e.pcategory, e.code, count };
+          snapshot.counters.push_back(counter);
+        }
+      }
+      snapshot.untracked += counters.untracked.load(std::memory_order_relaxed);
+    }
+    std::stable_sort(snapshot.counters.begin(), snapshot.counters.end(), &more_frequent);
+    return snapshot;
+  }
+
+  void set_error_sampler(error_sampler sampler, unsigned int interval)
+  {
+    g_sample_interval = std::max(interval, 1u);
+    g_sampler = sampler;
+  }
+
+  namespace detail
+  {
+    void record_error(const error_code& ec)
+    {
+      thread_counters& counters = get_counters();
+      counters.add(ec);
+
+      const error_sampler sampler = g_sampler.load(std::memory_order_relaxed);
+      if (!sampler || counters.sampling)
+        return;
+      if (++counters.since_sample < g_sample_interval.load(std::memory_order_relaxed))
+        return;
+      counters.since_sample = 0;
+      counters.sampling = true;
+      sampler(ec);
+      counters.sampling = false;
+    }
+  }
+}
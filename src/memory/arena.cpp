@@ -0,0 +1,137 @@
+#include <easy/memory/arena.h>
+
+namespace easy { namespace memory
+{
+  struct arena::chunk_header
+  {
+    chunk_header* pnext;
+    size_t size; // including the header
+  };
+
+  namespace
+  {
+    const size_t header_size = detail::align_up(sizeof(void*) + sizeof(size_t), max_align);
+  }
+
+  const size_t arena::default_chunk_size;
+  const size_t arena::default_max_chunk_size;
+
+  arena::arena(size_t initial_chunk_size, size_t max_chunk_size, memory_resource* pupstream)
+    : m_pupstream(pupstream)
+    , m_pchunks(nullptr)
+    , m_pinitial_buffer(nullptr)
+    , m_initial_buffer_size(0)
+    , m_initial_chunk_size(initial_chunk_size > header_size ? initial_chunk_size : 2 * header_size)
+    , m_max_chunk_size(max_chunk_size > m_initial_chunk_size ? max_chunk_size : m_initial_chunk_size)
+    , m_next_chunk_size(m_initial_chunk_size)
+    , m_pcurrent(nullptr)
+    , m_remaining(0)
+    , m_used_bytes(0)
+    , m_reserved_bytes(0)
+  {
+    EASY_ASSERT(pupstream);
+  }
+
+  arena::arena(void* pbuffer, size_t buffer_size, memory_resource* pupstream)
+    : m_pupstream(pupstream)
+    , m_pchunks(nullptr)
+    , m_pinitial_buffer(static_cast<char*>(pbuffer))
+    , m_initial_buffer_size(buffer_size)
+    , m_initial_chunk_size(default_chunk_size)
+    , m_max_chunk_size(default_max_chunk_size)
+    , m_next_chunk_size(default_chunk_size)
+    , m_pcurrent(static_cast<char*>(pbuffer))
+    , m_remaining(buffer_size)
+    , m_used_bytes(0)
+    , m_reserved_bytes(0)
+  {
+    EASY_ASSERT(pupstream);
+  }
+
+  arena::~arena()
+  {
+    release();
+  }
+
+  void arena::release()
+  {
+    while (m_pchunks) {
+      chunk_header* pchunk = m_pchunks;
+      m_pchunks = pchunk->pnext;
+      m_pupstream->deallocate(pchunk, pchunk->size, max_align);
+    }
+
+    m_pcurrent = m_pinitial_buffer;
+    m_remaining = m_initial_buffer_size;
+    m_next_chunk_size = m_initial_chunk_size;
+    m_used_bytes = 0;
+    m_reserved_bytes = 0;
+  }
+
+  size_t arena::used_bytes() const
+  {
+    return m_used_bytes;
+  }
+
+  size_t arena::reserved_bytes() const
+  {
+    return m_reserved_bytes;
+  }
+
+  memory_resource* arena::upstream_resource() const
+  {
+    return m_pupstream;
+  }
+
+  void* arena::do_allocate(size_t bytes, size_t alignment)
+  {
+    if (bytes == 0)
+      bytes = 1;
+
+    // the common case: the allocation fits the current chunk
+    const size_t padding = m_pcurrent
+      ? detail::align_up(reinterpret_cast<size_t>(m_pcurrent), alignment) - reinterpret_cast<size_t>(m_pcurrent)
+      : 0;
+    if (m_pcurrent && padding + bytes <= m_remaining) {
+      char* p = m_pcurrent + padding;
+      m_pcurrent = p + bytes;
+      m_remaining -= padding + bytes;
+      m_used_bytes += bytes;
+      return p;
+    }
+
+    const size_t required = header_size + bytes + (alignment > max_align ? alignment : 0);
+    if (bytes > m_next_chunk_size / 4) {
+      // a big allocation gets a chunk of its own and the current chunk stays current
+      chunk_header* pchunk = allocate_chunk(required);
+      m_used_bytes += bytes;
+      return reinterpret_cast<char*>(detail::align_up(reinterpret_cast<size_t>(pchunk) + header_size, alignment));
+    }
+
+    chunk_header* pchunk = allocate_chunk(required > m_next_chunk_size ? required : m_next_chunk_size);
+    if (m_next_chunk_size < m_max_chunk_size)
+      m_next_chunk_size = m_next_chunk_size * 2 < m_max_chunk_size ? m_next_chunk_size * 2 : m_max_chunk_size;
+
+    char* pbegin = reinterpret_cast<char*>(pchunk) + header_size;
+    char* p = reinterpret_cast<char*>(detail::align_up(reinterpret_cast<size_t>(pbegin), alignment));
+    m_pcurrent = p + bytes;
+    m_remaining = pchunk->size - (m_pcurrent - reinterpret_cast<char*>(pchunk));
+    m_used_bytes += bytes;
+    return p;
+  }
+
+  void arena::do_deallocate(void* /*p*/, size_t /*bytes*/, size_t /*alignment*/)
+  {
+  }
+
+  arena::chunk_header* arena::allocate_chunk(size_t size)
+  {
+    chunk_header* pchunk = static_cast<chunk_header*>(m_pupstream->allocate(size, max_align));
+    pchunk->pnext = m_pchunks;
+    pchunk->size = size;
+    m_pchunks = pchunk;
+    m_reserved_bytes += size;
+    return pchunk;
+  }
+
+}}
@@ -0,0 +1,46 @@
+#include <easy/memory/memory_resource.h>
+
+namespace easy { namespace memory
+{
+  namespace
+  {
+    class new_delete_resource_impl
+      : public memory_resource
+    {
+    protected:
+      virtual void* do_allocate(size_t bytes, size_t alignment) EASY_OVERRIDE
+      {
+        if (alignment <= max_align)
+          return ::operator new(bytes);
+
+        // operator new knows nothing about alignment, so the block is aligned by hand
+        // and the pointer to free is kept right before it
+        char* praw = static_cast<char*>(::operator new(bytes + alignment + sizeof(void*)));
+        const size_t offset = detail::align_up(reinterpret_cast<size_t>(praw) + sizeof(void*), alignment) - reinterpret_cast<size_t>(praw);
+        char* p = praw + offset;
+        reinterpret_cast<void**>(p)[-1] = praw;
+        return p;
+      }
+
+      virtual void do_deallocate(void* p, size_t /*bytes*/, size_t alignment) EASY_OVERRIDE
+      {
+        if (alignment <= max_align)
+          ::operator delete(p);
+        else
+          ::operator delete(static_cast<void**>(p)[-1]);
+      }
+
+      virtual bool do_is_equal(const memory_resource& other) const EASY_OVERRIDE_NOEXCEPT
+      {
+        return dynamic_cast<const new_delete_resource_impl*>(&other) != nullptr;
+      }
+    };
+  }
+
+  memory_resource* new_delete_resource()
+  {
+    static new_delete_resource_impl resource;
+    return &resource;
+  }
+
+}}
@@ -0,0 +1,117 @@
+#include <easy/memory/pool.h>
+
+namespace easy { namespace memory
+{
+  struct fixed_pool::chunk_header
+  {
+    chunk_header* pnext;
+  };
+
+  namespace
+  {
+    const size_t header_size = detail::align_up(sizeof(void*), max_align);
+  }
+
+  const size_t fixed_pool::default_blocks_per_chunk;
+
+  fixed_pool::fixed_pool(size_t block_size, size_t blocks_per_chunk, memory_resource* pupstream)
+    : m_pupstream(pupstream)
+    , m_block_size(detail::align_up(block_size ? block_size : 1, max_align))
+    , m_blocks_per_chunk(blocks_per_chunk ? blocks_per_chunk : 1)
+    , m_pchunks(nullptr)
+    , m_pfree(nullptr)
+    , m_used_blocks(0)
+    , m_reserved_bytes(0)
+  {
+    EASY_ASSERT(pupstream);
+  }
+
+  fixed_pool::~fixed_pool()
+  {
+    release();
+  }
+
+  void fixed_pool::release()
+  {
+    const size_t chunk_size = header_size + m_block_size * m_blocks_per_chunk;
+    while (m_pchunks) {
+      chunk_header* pchunk = m_pchunks;
+      m_pchunks = pchunk->pnext;
+      m_pupstream->deallocate(pchunk, chunk_size, max_align);
+    }
+
+    m_pfree = nullptr;
+    m_used_blocks = 0;
+    m_reserved_bytes = 0;
+  }
+
+  size_t fixed_pool::block_size() const
+  {
+    return m_block_size;
+  }
+
+  size_t fixed_pool::used_blocks() const
+  {
+    return m_used_blocks;
+  }
+
+  size_t fixed_pool::reserved_bytes() const
+  {
+    return m_reserved_bytes;
+  }
+
+  memory_resource* fixed_pool::upstream_resource() const
+  {
+    return m_pupstream;
+  }
+
+  void* fixed_pool::do_allocate(size_t bytes, size_t alignment)
+  {
+    if (!is_pooled(bytes, alignment))
+      return m_pupstream->allocate(bytes, alignment);
+
+    if (!m_pfree)
+      add_chunk();
+
+    free_block* pblock = m_pfree;
+    m_pfree = pblock->pnext;
+    ++m_used_blocks;
+    return pblock;
+  }
+
+  void fixed_pool::do_deallocate(void* p, size_t bytes, size_t alignment)
+  {
+    if (!is_pooled(bytes, alignment)) {
+      m_pupstream->deallocate(p, bytes, alignment);
+      return;
+    }
+
+    free_block* pblock = static_cast<free_block*>(p);
+    pblock->pnext = m_pfree;
+    m_pfree = pblock;
+    --m_used_blocks;
+  }
+
+  bool fixed_pool::is_pooled(size_t bytes, size_t alignment) const
+  {
+    return bytes <= m_block_size && alignment <= max_align;
+  }
+
+  void fixed_pool::add_chunk()
+  {
+    const size_t chunk_size = header_size + m_block_size * m_blocks_per_chunk;
+    chunk_header* pchunk = static_cast<chunk_header*>(m_pupstream->allocate(chunk_size, max_align));
+    pchunk->pnext = m_pchunks;
+    m_pchunks = pchunk;
+    m_reserved_bytes += chunk_size;
+
+    // the blocks are linked in the address order, so they are handed out sequentially
+    char* pblocks = reinterpret_cast<char*>(pchunk) + header_size;
+    for (size_t i = m_blocks_per_chunk; i > 0; --i) {
+      free_block* pblock = reinterpret_cast<free_block*>(pblocks + (i - 1) * m_block_size);
+      pblock->pnext = m_pfree;
+      m_pfree = pblock;
+    }
+  }
+
+}}
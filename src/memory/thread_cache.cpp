@@ -0,0 +1,141 @@
+#include <easy/memory/thread_cache.h>
+
+#include <atomic>
+
+namespace easy { namespace memory
+{
+  namespace
+  {
+    //! Size of the chunks split into blocks when no free blocks are left
+    const size_t chunk_size = 16 * 1024;
+
+    //! Number of blocks moved between a thread cache and the shared lists at once
+    const size_t batch_bytes = 4 * 1024;
+
+    std::atomic<unsigned long long> g_last_resource_id(0);
+
+    // the cache of the resource used last by the thread, found without locking
+    EASY_THREAD_LOCAL unsigned long long t_resource_id = 0;
+    EASY_THREAD_LOCAL void* t_pcache = nullptr;
+  }
+
+  const size_t thread_cache_resource::min_cached_size;
+  const size_t thread_cache_resource::max_cached_size;
+  const size_t thread_cache_resource::class_count;
+
+  thread_cache_resource::thread_cache_resource(memory_resource* pupstream)
+    : m_pupstream(pupstream)
+    , m_id(++g_last_resource_id)
+  {
+    EASY_ASSERT(pupstream);
+  }
+
+  thread_cache_resource::~thread_cache_resource()
+  {
+    for (auto it = m_caches.begin(); it != m_caches.end(); ++it)
+      delete it->second;
+    for (auto it = m_chunks.begin(); it != m_chunks.end(); ++it)
+      m_pupstream->deallocate(*it, chunk_size, max_align);
+  }
+
+  memory_resource* thread_cache_resource::upstream_resource() const
+  {
+    return m_pupstream;
+  }
+
+  void* thread_cache_resource::do_allocate(size_t bytes, size_t alignment)
+  {
+    if (bytes > max_cached_size || alignment > max_align) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_pupstream->allocate(bytes, alignment);
+    }
+
+    const size_t size_class = get_class(bytes);
+    free_list& list = get_cache().lists[size_class];
+    if (!list.phead)
+      refill(list, size_class);
+    return list.pop();
+  }
+
+  void thread_cache_resource::do_deallocate(void* p, size_t bytes, size_t alignment)
+  {
+    if (bytes > max_cached_size || alignment > max_align) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_pupstream->deallocate(p, bytes, alignment);
+      return;
+    }
+
+    const size_t size_class = get_class(bytes);
+    free_list& list = get_cache().lists[size_class];
+    list.push(p);
+    if (list.count > 2 * get_batch_size(size_class))
+      drain(list, size_class);
+  }
+
+  size_t thread_cache_resource::get_class(size_t bytes)
+  {
+    size_t size_class = 0;
+    for (size_t size = min_cached_size; size < bytes; size <<= 1)
+      ++size_class;
+    return size_class;
+  }
+
+  size_t thread_cache_resource::get_class_size(size_t size_class)
+  {
+    return min_cached_size << size_class;
+  }
+
+  size_t thread_cache_resource::get_batch_size(size_t size_class)
+  {
+    return batch_bytes / get_class_size(size_class);
+  }
+
+  thread_cache_resource::thread_cache& thread_cache_resource::get_cache()
+  {
+    if (t_resource_id == m_id)
+      return *static_cast<thread_cache*>(t_pcache);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    thread_cache*& pcache = m_caches[std::this_thread::get_id()];
+    if (!pcache)
+      pcache = new thread_cache();
+    t_resource_id = m_id;
+    t_pcache = pcache;
+    return *pcache;
+  }
+
+  void thread_cache_resource::refill(free_list& list, size_t size_class)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    free_list& shared = m_shared[size_class];
+    for (size_t i = get_batch_size(size_class); i > 0 && shared.phead; --i)
+      list.push(shared.pop());
+    if (list.phead)
+      return;
+
+    m_chunks.reserve(m_chunks.size() + 1);
+    char* pchunk = static_cast<char*>(m_pupstream->allocate(chunk_size, max_align));
+    m_chunks.push_back(pchunk);
+
+    // a batch of the blocks goes to the thread and the rest to the shared list
+    const size_t size = get_class_size(size_class);
+    const size_t batch_size = get_batch_size(size_class);
+    for (size_t offset = chunk_size; offset >= size; offset -= size) {
+      if (offset / size > batch_size)
+        shared.push(pchunk + offset - size);
+      else
+        list.push(pchunk + offset - size);
+    }
+  }
+
+  void thread_cache_resource::drain(free_list& list, size_t size_class)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    free_list& shared = m_shared[size_class];
+    for (size_t i = get_batch_size(size_class); i > 0; --i)
+      shared.push(list.pop());
+  }
+
+}}
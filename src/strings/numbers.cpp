@@ -0,0 +1,545 @@
+#include <easy/strings/numbers.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+// the digits are converted eight at a time in a 64 bit word, which needs the first character
+// in the lowest byte
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+#  define EASY_NUMBERS_SWAR
+#endif
+
+namespace easy
+{
+  namespace
+  {
+    const char digit_pairs[] =
+      "00010203040506070809"
+      "10111213141516171819"
+      "20212223242526272829"
+      "30313233343536373839"
+      "40414243444546474849"
+      "50515253545556575859"
+      "60616263646566676869"
+      "70717273747576777879"
+      "80818283848586878889"
+      "90919293949596979899";
+
+    const double powers_of_10[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // integers up to 2^53 are exact doubles
+    const uint64 max_exact_integer = 9007199254740992ULL;
+
+    //! Limits of the exact arithmetic in the type: integers up to 2^digits and the powers of ten
+    //! up to 10^max_power, whose factor 5^n fits the digits as well
+    template<class T>
+    struct exact_limits;
+
+    template<>
+    struct exact_limits<float>
+    {
+      static const uint64 max_integer = 16777216ULL;
+      static const int max_power = 10;
+    };
+
+    template<>
+    struct exact_limits<double>
+    {
+      static const uint64 max_integer = max_exact_integer;
+      static const int max_power = 22;
+    };
+
+    inline bool is_digit(char c)
+    {
+      return static_cast<unsigned>(c - '0') < 10;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+#ifdef EASY_NUMBERS_SWAR
+    inline uint64 load_8(const char* p)
+    {
+      uint64 v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    //! Returns true if all eight characters are digits
+    inline bool are_8_digits(uint64 v)
+    {
+      // the high nibbles are 3 and adding 6 to the low nibbles does not carry into them
+      return ((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+        == 0x3333333333333333ULL;
+    }
+
+    //! Converts eight digits by combining pairs of neighbours: 1, 2 and then 4 digits wide
+    inline uint32 parse_8_digits(uint64 v)
+    {
+      v = ((v & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+      v = ((v & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+      return static_cast<uint32>(((v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+    }
+#endif
+
+    //! Returns the number of digits starting at p
+    size_t count_digits(const char* p, const char* end)
+    {
+      const char* q = p;
+#ifdef EASY_NUMBERS_SWAR
+      while (end - q >= 8 && are_8_digits(load_8(q)))
+        q += 8;
+#endif
+      while (q < end && is_digit(*q))
+        ++q;
+      return q - p;
+    }
+
+    //! Converts up to 19 digits, which always fit 64 bits
+    uint64 digits_value(const char* p, size_t count, uint64 value = 0)
+    {
+#ifdef EASY_NUMBERS_SWAR
+      for (; count >= 8; count -= 8, p += 8)
+        value = value * 100000000 + parse_8_digits(load_8(p));
+#endif
+      for (; count > 0; --count, ++p)
+        value = value * 10 + (*p - '0');
+      return value;
+    }
+
+    //! Parses the digits at p. Returns their number, 0 if there are none
+    size_t parse_digits(const char* p, const char* end, uint64& value, bool& overflow)
+    {
+      const size_t count = count_digits(p, end);
+      size_t significant = count;
+      while (significant > 1 && *p == '0') {
+        ++p;
+        --significant;
+      }
+
+      overflow = false;
+      if (significant < 20) {
+        value = digits_value(p, significant);
+      }
+      else if (significant == 20) {
+        const uint64 head = digits_value(p, 19);
+        const unsigned last = p[19] - '0';
+        overflow = head > (std::numeric_limits<uint64>::max() - last) / 10;
+        value = head * 10 + last;
+      }
+      else {
+        overflow = true;
+      }
+      return count;
+    }
+
+    template<class T>
+    size_t parse_integer(const lite_string& s, T& value, error_code_ref ec)
+    {
+      const char* begin = s.data();
+      const char* end = begin + s.size();
+      const char* p = begin;
+
+      bool negative = false;
+      if (p != end && *p == '-' && std::numeric_limits<T>::is_signed) {
+        negative = true;
+        ++p;
+      }
+
+      uint64 magnitude = 0;
+      bool overflow = false;
+      const size_t count = p != end ? parse_digits(p, end, magnitude, overflow) : 0;
+      if (!count) {
+        ec = generic_error::invalid_value;
+        return 0;
+      }
+
+      const uint64 max_magnitude = static_cast<uint64>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+      if (overflow || magnitude > max_magnitude) {
+        ec = generic_error::out_of_range;
+        return 0;
+      }
+
+      // the magnitude of the minimum value does not fit the type, so one is subtracted after the negation
+      if (!negative || magnitude == 0)
+        value = static_cast<T>(magnitude);
+      else
+        value = static_cast<T>(T(0) - static_cast<T>(magnitude - 1) - T(1));
+      return p + count - begin;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    //! Matches a word ignoring the case
+    bool match_word(const char* p, const char* end, const char* word)
+    {
+      for (; *word; ++p, ++word) {
+        if (p == end || (*p | 0x20) != *word)
+          return false;
+      }
+      return true;
+    }
+
+    inline float read_back(const char* pstr, float)
+    {
+      return std::strtof(pstr, nullptr);
+    }
+
+    inline double read_back(const char* pstr, double)
+    {
+      return std::strtod(pstr, nullptr);
+    }
+
+    template<class T>
+    size_t parse_floating(const lite_string& s, T& value, error_code_ref ec)
+    {
+      const char* begin = s.data();
+      const char* end = begin + s.size();
+      const char* p = begin;
+
+      const bool negative = p != end && *p == '-';
+      if (negative)
+        ++p;
+
+      if (p != end && ((*p | 0x20) == 'i' || (*p | 0x20) == 'n')) {
+        size_t length = 0;
+        T special = T();
+        if (match_word(p, end, "infinity"))
+          length = 8;
+        else if (match_word(p, end, "inf"))
+          length = 3;
+        if (length)
+          special = std::numeric_limits<T>::infinity();
+        else if (match_word(p, end, "nan")) {
+          length = 3;
+          special = std::numeric_limits<T>::quiet_NaN();
+        }
+        if (!length) {
+          ec = generic_error::invalid_value;
+          return 0;
+        }
+        value = negative ? -special : special;
+        return p + length - begin;
+      }
+
+      const char* pinteger = p;
+      const size_t integer_digits = p != end ? count_digits(p, end) : 0;
+      p += integer_digits;
+
+      const char* pfraction = p;
+      size_t fraction_digits = 0;
+      if (p != end && *p == '.') {
+        pfraction = ++p;
+        fraction_digits = count_digits(p, end);
+        p += fraction_digits;
+      }
+
+      if (integer_digits + fraction_digits == 0) {
+        ec = generic_error::invalid_value;
+        return 0;
+      }
+
+      // an exponent without digits is not a part of the number
+      int exponent = 0;
+      if (p != end && (*p | 0x20) == 'e') {
+        const char* q = p + 1;
+        const bool negative_exponent = q != end && *q == '-';
+        if (q != end && (*q == '-' || *q == '+'))
+          ++q;
+        const size_t exponent_digits = q != end ? count_digits(q, end) : 0;
+        if (exponent_digits) {
+          for (size_t i = 0; i < exponent_digits; ++i)
+            exponent = exponent < 100000 ? exponent * 10 + (q[i] - '0') : exponent;
+          if (negative_exponent)
+            exponent = -exponent;
+          p = q + exponent_digits;
+        }
+      }
+
+      // exact integers scaled by exact powers of ten are rounded once by the arithmetic. It is done
+      // in the type itself, since rounding a double to a float again may break a tie the wrong way
+      if (integer_digits + fraction_digits <= 19) {
+        const uint64 mantissa = digits_value(pfraction, fraction_digits, digits_value(pinteger, integer_digits));
+        const int scale = exponent - static_cast<int>(fraction_digits);
+        const int max_power = exact_limits<T>::max_power;
+        if (mantissa <= exact_limits<T>::max_integer && scale >= -max_power && scale <= max_power) {
+          const T result = scale < 0
+            ? static_cast<T>(mantissa) / static_cast<T>(powers_of_10[-scale])
+            : static_cast<T>(mantissa) * static_cast<T>(powers_of_10[scale]);
+          value = negative ? -result : result;
+          return p - begin;
+        }
+      }
+
+      // other numbers are left to the C library, which needs zero terminated text and follows
+      // LC_NUMERIC. Only numbers too long for the buffer are copied to the heap
+      const size_t length = p - begin;
+      char buffer[256];
+      std::string long_number;
+      const char* pnumber = buffer;
+      if (length < sizeof(buffer)) {
+        std::memcpy(buffer, begin, length);
+        buffer[length] = '\0';
+      }
+      else {
+        long_number.assign(begin, length);
+        pnumber = long_number.c_str();
+      }
+
+      const T result = read_back(pnumber, T());
+      if (result == std::numeric_limits<T>::infinity() || result == -std::numeric_limits<T>::infinity()) {
+        ec = generic_error::out_of_range;
+        return 0;
+      }
+      value = result;
+      return length;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    //! Writes the digits backwards ending at pend, two at a time. Returns the first digit
+    char* format_unsigned(uint64 value, char* pend)
+    {
+      char* p = pend;
+      while (value >= 100) {
+        const size_t pair = static_cast<size_t>(value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+      }
+      if (value >= 10) {
+        const size_t pair = static_cast<size_t>(value) * 2;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+      }
+      else {
+        *--p = static_cast<char>('0' + value);
+      }
+      return p;
+    }
+
+    char* format_signed(int64 value, char* pend)
+    {
+      const uint64 magnitude = value < 0 ? 0 - static_cast<uint64>(value) : static_cast<uint64>(value);
+      char* p = format_unsigned(magnitude, pend);
+      if (value < 0)
+        *--p = '-';
+      return p;
+    }
+
+    //! Formats values with up to 8 decimals exactly, as prices and measurements mostly are.
+    //! Returns 0 for other values
+    size_t format_short_decimal(double value, char* pbuffer)
+    {
+      const int max_fraction_digits = 8;
+
+      const double magnitude = value < 0 ? -value : value;
+      if (!(magnitude < 1e15) || (value == 0 && 1 / value < 0))
+        return 0; // large, not finite or negative zero
+
+      for (int digits = 0; digits <= max_fraction_digits; ++digits) {
+        const double scaled = magnitude * powers_of_10[digits];
+        if (scaled >= static_cast<double>(max_exact_integer))
+          return 0;
+        const uint64 mantissa = static_cast<uint64>(scaled + 0.5);
+        // the division is correctly rounded like parsing, so the text reads back to the value
+        if (static_cast<double>(mantissa) / powers_of_10[digits] != magnitude)
+          continue;
+
+        char buffer[max_number_length];
+        char* pend = buffer + sizeof(buffer);
+        char* p = pend;
+        uint64 integer = mantissa;
+        if (digits > 0) {
+          for (int i = 0; i < digits; ++i) {
+            *--p = static_cast<char>('0' + integer % 10);
+            integer /= 10;
+          }
+          *--p = '.';
+        }
+        p = format_unsigned(integer, p);
+        if (value < 0)
+          *--p = '-';
+        std::memcpy(pbuffer, p, pend - p);
+        return pend - p;
+      }
+      return 0;
+    }
+
+    //! Prints the value with the precision to a buffer of max_number_length. Returns 0 if it
+    //! does not fit, which the precisions of float and double never make happen
+    template<class T>
+    size_t print_general(T value, int precision, char* pbuffer)
+    {
+#ifdef EASY_MSVC_VERSION
+      // no snprintf before Visual Studio 2015, the truncation gives -1
+      const int size = ::_snprintf_s(pbuffer, max_number_length, _TRUNCATE, "%.*g", precision, static_cast<double>(value));
+#else
+      const int size = std::snprintf(pbuffer, max_number_length, "%.*g", precision, static_cast<double>(value));
+#endif
+      if (size < 0 || static_cast<size_t>(size) >= max_number_length) {
+        EASY_ASSERT(!"A number does not fit max_number_length");
+        return 0;
+      }
+      return static_cast<size_t>(size);
+    }
+
+    //! Formats with the smallest precision which reads back to the same value. More digits
+    //! never stop a value from reading back, so the precision is found by bisection. Values which
+    //! are not short decimals go through sprintf and strtod, which follow LC_NUMERIC
+    template<class T>
+    size_t format_floating(T value, char* pbuffer)
+    {
+      if (value != value) {
+        std::memcpy(pbuffer, "nan", 3);
+        return 3;
+      }
+      if (value == std::numeric_limits<T>::infinity() || value == -std::numeric_limits<T>::infinity()) {
+        const char* ptext = value < 0 ? "-inf" : "inf";
+        const size_t size = std::strlen(ptext);
+        std::memcpy(pbuffer, ptext, size);
+        return size;
+      }
+      if (const size_t size = format_short_decimal(value, pbuffer))
+        return size;
+
+      int low = 1;
+      int high = std::numeric_limits<T>::digits10 + 3; // always reads back
+      while (low < high) {
+        const int precision = (low + high) / 2;
+        if (print_general(value, precision, pbuffer) && read_back(pbuffer, T()) == value)
+          high = precision;
+        else
+          low = precision + 1;
+      }
+      return print_general(value, low, pbuffer);
+    }
+
+    size_t copy_number(const char* p, size_t size, char* pdest, size_t dest_size, error_code_ref ec)
+    {
+      if (size > dest_size) {
+        ec = boost::system::errc::make_error_code(boost::system::errc::no_buffer_space);
+        return 0;
+      }
+      std::memcpy(pdest, p, size);
+      return size;
+    }
+
+    size_t format_integer(int64 value, char* pdest, size_t size, error_code_ref ec)
+    {
+      char buffer[max_number_length];
+      const char* p = format_signed(value, buffer + sizeof(buffer));
+      return copy_number(p, buffer + sizeof(buffer) - p, pdest, size, ec);
+    }
+
+    size_t format_integer(uint64 value, char* pdest, size_t size, error_code_ref ec)
+    {
+      char buffer[max_number_length];
+      const char* p = format_unsigned(value, buffer + sizeof(buffer));
+      return copy_number(p, buffer + sizeof(buffer) - p, pdest, size, ec);
+    }
+
+    template<class T>
+    size_t format_floating(T value, char* pdest, size_t size, error_code_ref ec)
+    {
+      char buffer[max_number_length];
+      const size_t length = format_floating(value, buffer);
+      if (!length) {
+        ec = boost::system::errc::make_error_code(boost::system::errc::value_too_large);
+        return 0;
+      }
+      return copy_number(buffer, length, pdest, size, ec);
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+
+  size_t parse(const lite_string& s, int& value, error_code_ref ec)
+  {
+    return parse_integer(s, value, ec);
+  }
+
+  size_t parse(const lite_string& s, unsigned int& value, error_code_ref ec)
+  {
+    return parse_integer(s, value, ec);
+  }
+
+  size_t parse(const lite_string& s, long& value, error_code_ref ec)
+  {
+    return parse_integer(s, value, ec);
+  }
+
+  size_t parse(const lite_string& s, unsigned long& value, error_code_ref ec)
+  {
+    return parse_integer(s, value, ec);
+  }
+
+  size_t parse(const lite_string& s, int64& value, error_code_ref ec)
+  {
+    return parse_integer(s, value, ec);
+  }
+
+  size_t parse(const lite_string& s, uint64& value, error_code_ref ec)
+  {
+    return parse_integer(s, value, ec);
+  }
+
+  size_t parse(const lite_string& s, float& value, error_code_ref ec)
+  {
+    return parse_floating(s, value, ec);
+  }
+
+  size_t parse(const lite_string& s, double& value, error_code_ref ec)
+  {
+    return parse_floating(s, value, ec);
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+
+  size_t format(int value, char* pdest, size_t size, error_code_ref ec)
+  {
+    return format_integer(static_cast<int64>(value), pdest, size, ec);
+  }
+
+  size_t format(unsigned int value, char* pdest, size_t size, error_code_ref ec)
+  {
+    return format_integer(static_cast<uint64>(value), pdest, size, ec);
+  }
+
+  size_t format(long value, char* pdest, size_t size, error_code_ref ec)
+  {
+    return format_integer(static_cast<int64>(value), pdest, size, ec);
+  }
+
+  size_t format(unsigned long value, char* pdest, size_t size, error_code_ref ec)
+  {
+    return format_integer(static_cast<uint64>(value), pdest, size, ec);
+  }
+
+  size_t format(int64 value, char* pdest, size_t size, error_code_ref ec)
+  {
+    return format_integer(value, pdest, size, ec);
+  }
+
+  size_t format(uint64 value, char* pdest, size_t size, error_code_ref ec)
+  {
+    return format_integer(value, pdest, size, ec);
+  }
+
+  size_t format(float value, char* pdest, size_t size, error_code_ref ec)
+  {
+    return format_floating(value, pdest, size, ec);
+  }
+
+  size_t format(double value, char* pdest, size_t size, error_code_ref ec)
+  {
+    return format_floating(value, pdest, size, ec);
+  }
+
+}
@@ -0,0 +1,203 @@
+#include <easy/strings/string_builder.h>
+#include <easy/strings/numbers.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace easy
+{
+  const size_t string_builder::default_chunk_size;
+  const size_t string_builder::max_chunk_size;
+
+  string_builder::string_builder(size_t chunk_size, memory::memory_resource* presource)
+    : m_arena(chunk_size, max_chunk_size, presource)
+    , m_fragments(memory::polymorphic_allocator<string_fragment>(presource))
+    , m_chunk_size(chunk_size)
+    , m_next_chunk_size(chunk_size)
+    , m_pcurrent(nullptr)
+    , m_remaining(0)
+    , m_size(0)
+  {
+  }
+
+  string_builder::~string_builder()
+  {
+  }
+
+  string_builder& string_builder::append(const char* pstr, size_t size)
+  {
+    while (size > 0) {
+      char* pdest = reserve(m_remaining ? 1 : size);
+      const size_t count = std::min(size, m_remaining);
+      std::memcpy(pdest, pstr, count);
+      commit(pdest, count);
+      pstr += count;
+      size -= count;
+    }
+    return *this;
+  }
+
+  string_builder& string_builder::append(const lite_string& s)
+  {
+    return append(s.data(), s.size());
+  }
+
+  string_builder& string_builder::append(char c)
+  {
+    char* pdest = reserve(1);
+    *pdest = c;
+    commit(pdest, 1);
+    return *this;
+  }
+
+  string_builder& string_builder::append(size_t count, char c)
+  {
+    while (count > 0) {
+      char* pdest = reserve(m_remaining ? 1 : count);
+      const size_t n = std::min(count, m_remaining);
+      std::memset(pdest, c, n);
+      commit(pdest, n);
+      count -= n;
+    }
+    return *this;
+  }
+
+  string_builder& string_builder::append_view(const lite_string& s)
+  {
+    if (!s.empty()) {
+      const string_fragment fragment = { s.data(), s.size() };
+      m_fragments.push_back(fragment);
+      m_size += s.size();
+    }
+    return *this;
+  }
+
+  string_builder& string_builder::append(int value)
+  {
+    return append(static_cast<int64>(value));
+  }
+
+  string_builder& string_builder::append(unsigned int value)
+  {
+    return append(static_cast<uint64>(value));
+  }
+
+  string_builder& string_builder::append(long value)
+  {
+    return append(static_cast<int64>(value));
+  }
+
+  string_builder& string_builder::append(unsigned long value)
+  {
+    return append(static_cast<uint64>(value));
+  }
+
+  string_builder& string_builder::append(int64 value)
+  {
+    char buffer[max_number_length];
+    return append(buffer, format(value, buffer, sizeof(buffer)));
+  }
+
+  string_builder& string_builder::append(uint64 value)
+  {
+    char buffer[max_number_length];
+    return append(buffer, format(value, buffer, sizeof(buffer)));
+  }
+
+  string_builder& string_builder::append(double value)
+  {
+    char buffer[max_number_length];
+    return append(buffer, format(value, buffer, sizeof(buffer)));
+  }
+
+  size_t string_builder::size() const
+  {
+    return m_size;
+  }
+
+  bool string_builder::empty() const
+  {
+    return m_size == 0;
+  }
+
+  const string_builder::fragments_type& string_builder::fragments() const
+  {
+    return m_fragments;
+  }
+
+  lite_string string_builder::flatten()
+  {
+    if (m_size == 0)
+      return lite_string();
+
+    // a single fragment in a chunk can be terminated in place
+    if (m_fragments.size() == 1 && m_fragments[0].pdata + m_size == m_pcurrent && m_remaining > 0) {
+      *m_pcurrent = '\0';
+      return lite_string(m_fragments[0].pdata, m_size);
+    }
+
+    char* pdest = static_cast<char*>(m_arena.allocate(m_size + 1, 1));
+    copy_to(pdest);
+    pdest[m_size] = '\0';
+
+    m_fragments.clear();
+    const string_fragment fragment = { pdest, m_size };
+    m_fragments.push_back(fragment);
+    // the terminating zero is not a part of the text, so appends start in a new chunk
+    m_pcurrent = nullptr;
+    m_remaining = 0;
+    return lite_string(pdest, m_size);
+  }
+
+  void string_builder::copy_to(char* pdest) const
+  {
+    for (auto it = m_fragments.begin(); it != m_fragments.end(); ++it) {
+      std::memcpy(pdest, it->pdata, it->size);
+      pdest += it->size;
+    }
+  }
+
+  std::string string_builder::str() const
+  {
+    std::string result(m_size, '\0');
+    if (m_size > 0)
+      copy_to(&result[0]);
+    return result;
+  }
+
+  void string_builder::clear()
+  {
+    m_fragments.clear();
+    m_arena.release();
+    m_next_chunk_size = m_chunk_size;
+    m_pcurrent = nullptr;
+    m_remaining = 0;
+    m_size = 0;
+  }
+
+  char* string_builder::reserve(size_t size)
+  {
+    if (m_remaining < size) {
+      const size_t chunk_size = std::max(m_next_chunk_size, size);
+      m_pcurrent = static_cast<char*>(m_arena.allocate(chunk_size, 1));
+      m_remaining = chunk_size;
+      m_next_chunk_size = std::min(m_next_chunk_size * 2, max_chunk_size);
+    }
+    return m_pcurrent;
+  }
+
+  void string_builder::commit(char* pdata, size_t size)
+  {
+    // appends following each other in a chunk extend the last fragment
+    if (!m_fragments.empty() && m_fragments.back().pdata + m_fragments.back().size == pdata)
+      m_fragments.back().size += size;
+    else {
+      const string_fragment fragment = { pdata, size };
+      m_fragments.push_back(fragment);
+    }
+    m_pcurrent += size;
+    m_remaining -= size;
+    m_size += size;
+  }
+
+}
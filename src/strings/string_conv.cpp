@@ -1,69 +1,55 @@
 #include <easy/strings/conv.h>
-
-#ifdef EASY_OS_WINDOWS
-
-#include <easy/windows/error.h>
-#include <Windows.h>
-
-#endif
+#include <easy/strings/utf.h>
 
 namespace easy
 {
   namespace 
   {
-#ifdef EASY_OS_WINDOWS
+#ifdef EASY_HAS_WCAHR
+    // wchar_t strings keep UTF-16 where wchar_t has two bytes, as on Windows, and UTF-32 otherwise
+    const bool is_wchar_utf16 = sizeof(wchar_t) == sizeof(uint16);
+
     std::wstring utf8_to_utf16_impl(const lite_string& s, error_code_ref ec)
     {
-      // first find the size
-      int size = ::MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, s.c_str(), -1, nullptr, 0);
-      if (size == 0) {
-        ec = windows::make_last_win_error();
+      const size_t size = is_wchar_utf16
+        ? utf::utf16_length_from_utf8(s.data(), s.size())
+        : utf::utf32_length_from_utf8(s.data(), s.size());
+      std::wstring result(size, L'\0');
+
+      error_code convert_ec;
+      if (is_wchar_utf16)
+        utf::convert_utf8_to_utf16(s.data(), s.size(), reinterpret_cast<uint16*>(&result[0]), convert_ec);
+      else
+        utf::convert_utf8_to_utf32(s.data(), s.size(), reinterpret_cast<uint32*>(&result[0]), convert_ec);
+      if (convert_ec) {
+        ec.forward(convert_ec);
         return std::wstring();
       }
-
-      // this length includes the terminating null
-      std::wstring result(size-1, L'\0');
-
-      // now call again to format the string
-      int res_size = ::MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, s.c_str(), -1, &result.front(), size);
-      if (res_size == size)
-        return result;
-
-      ec = windows::make_last_win_error();
-      return std::wstring();
+      return result;
     }
 
     std::string utf16_to_utf8_impl(const lite_wstring& s, error_code_ref ec)
     {
-#if EASY_WIN_VERSION < EASY_WINDOWS_VISTA
-      const DWORD flags = 0;
-#else
-      const DWORD flags = WC_ERR_INVALID_CHARS;
-#endif
-      // first find the size
-      int size = ::WideCharToMultiByte(CP_UTF8, flags, s.c_str(), -1,  nullptr, 0, nullptr, nullptr);
-      if (size == 0) {
-        ec = windows::make_last_win_error();
+      const size_t size = is_wchar_utf16
+        ? utf::utf8_length_from_utf16(reinterpret_cast<const uint16*>(s.data()), s.size())
+        : utf::utf8_length_from_utf32(reinterpret_cast<const uint32*>(s.data()), s.size());
+      std::string result(size, '\0');
+
+      error_code convert_ec;
+      if (is_wchar_utf16)
+        utf::convert_utf16_to_utf8(reinterpret_cast<const uint16*>(s.data()), s.size(), &result[0], convert_ec);
+      else
+        utf::convert_utf32_to_utf8(reinterpret_cast<const uint32*>(s.data()), s.size(), &result[0], convert_ec);
+      if (convert_ec) {
+        ec.forward(convert_ec);
         return std::string();
       }
-
-      // this length includes the terminating null
-      std::string result(size-1, '\0');
-
-      // now call again to format the string
-      int res_size = ::WideCharToMultiByte(CP_UTF8, flags, s.c_str(), -1, &result.front(), size, nullptr, nullptr);
-      if (res_size == size)
-        return result;
-
-      ec = windows::make_last_win_error();
-      return std::string();
+      return result;
     }
-#else
-
 #endif
-
   }
 
+#ifdef EASY_HAS_WCAHR
   std::wstring utf8_to_utf16(const lite_string& s, error_code_ref ec)
   {
     if (!s) // an empty string is not an error
@@ -77,6 +63,6 @@ namespace easy
       return std::string();
     return utf16_to_utf8_impl(s, ec);
   }
+#endif
 
 }
-
@@ -0,0 +1,114 @@
+#include <easy/strings/hash.h>
+
+#include <cstring>
+
+#if defined(EASY_MSVC_VERSION) && defined(_M_X64)
+#  include <intrin.h>
+#endif
+
+namespace easy { namespace detail
+{
+  namespace
+  {
+    const uint64 secret[4] = {
+      0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+    };
+
+    //! Replaces a and b with the low and the high halves of their 128 bit product
+    inline void multiply(uint64& a, uint64& b)
+    {
+#if defined(__SIZEOF_INT128__)
+      const unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+      a = static_cast<uint64>(r);
+      b = static_cast<uint64>(r >> 64);
+#elif defined(EASY_MSVC_VERSION) && defined(_M_X64)
+      a = _umul128(a, b, &b);
+#else
+      const uint64 ha = a >> 32, la = static_cast<uint32>(a);
+      const uint64 hb = b >> 32, lb = static_cast<uint32>(b);
+      const uint64 hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+      const uint64 t = ll + (hl << 32);
+      const uint64 lo = t + (lh << 32);
+      const uint64 carry = (t < ll ? 1 : 0) + (lo < t ? 1 : 0);
+      a = lo;
+      b = hh + (hl >> 32) + (lh >> 32) + carry;
+#endif
+    }
+
+    inline uint64 mix(uint64 a, uint64 b)
+    {
+      multiply(a, b);
+      return a ^ b;
+    }
+
+    // the hash is defined over little endian reads, which all supported targets do
+    inline uint64 read8(const byte* p)
+    {
+      uint64 v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    inline uint64 read4(const byte* p)
+    {
+      uint32 v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    inline uint64 read3(const byte* p, size_t size)
+    {
+      return (static_cast<uint64>(p[0]) << 16) | (static_cast<uint64>(p[size >> 1]) << 8) | p[size - 1];
+    }
+  }
+
+  uint64 hash_bytes(const void* pdata, size_t size, uint64 seed)
+  {
+    const byte* p = static_cast<const byte*>(pdata);
+    seed ^= mix(seed ^ secret[0], secret[1]);
+
+    uint64 a, b;
+    if (size <= 16) {
+      // short keys, the common case, are read with at most four overlapping loads
+      if (size >= 4) {
+        const size_t shift = (size >> 3) << 2;
+        a = (read4(p) << 32) | read4(p + shift);
+        b = (read4(p + size - 4) << 32) | read4(p + size - 4 - shift);
+      }
+      else if (size > 0) {
+        a = read3(p, size);
+        b = 0;
+      }
+      else {
+        a = b = 0;
+      }
+    }
+    else {
+      size_t i = size;
+      if (i > 48) {
+        uint64 seed1 = seed, seed2 = seed;
+        do {
+          seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+          seed1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ seed1);
+          seed2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ seed2);
+          p += 48;
+          i -= 48;
+        } while (i > 48);
+        seed ^= seed1 ^ seed2;
+      }
+      while (i > 16) {
+        seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+        p += 16;
+        i -= 16;
+      }
+      a = read8(p + i - 16);
+      b = read8(p + i - 8);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    multiply(a, b);
+    return mix(a ^ secret[0] ^ size, b ^ secret[1]);
+  }
+
+}}
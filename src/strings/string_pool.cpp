@@ -0,0 +1,243 @@
+#include <easy/strings/string_pool.h>
+#include <easy/strings/hash.h>
+
+#include <cstring>
+
+namespace easy
+{
+  namespace
+  {
+    const size_t initial_index_size = 64;
+
+    size_t hash_of(const lite_string& s) EASY_NOEXCEPT
+    {
+      return detail::hash_chars(s.data(), s.size());
+    }
+
+    size_t round_up_to_power_of_two(size_t n) EASY_NOEXCEPT
+    {
+      size_t r = 1;
+      while (r < n)
+        r <<= 1;
+      return r;
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+
+  const size_t string_pool::default_chunk_size;
+
+  string_pool::string_pool(size_t chunk_size, memory::memory_resource* presource)
+    : m_arena(chunk_size, chunk_size, presource)
+    , m_index(memory::polymorphic_allocator<entry>(presource))
+  {
+  }
+
+  string_pool::~string_pool()
+  {
+  }
+
+  lite_string string_pool::intern(const lite_string& s)
+  {
+    return intern(s, hash_of(s));
+  }
+
+  lite_string string_pool::intern(const static_string& s)
+  {
+    return intern(s, s.hash());
+  }
+
+  lite_string string_pool::intern(const lite_string& s, size_t hash)
+  {
+    m_stats.lookups++;
+    if (s.empty())
+      return lite_string();
+
+    if (const entry* pentry = lookup(s.data(), s.size(), hash)) {
+      m_stats.hits++;
+      m_stats.saved_bytes += s.size() + 1;
+      return lite_string(pentry->pstr, pentry->size);
+    }
+
+    // keep the load factor at most 1/2, so the probe sequences stay short
+    if ((m_stats.strings + 1) * 2 > m_index.size())
+      grow_index();
+
+    const char* pstr = store(s.data(), s.size());
+    const size_t mask = m_index.size() - 1;
+    size_t i = hash & mask;
+    while (m_index[i].pstr)
+      i = (i + 1) & mask;
+
+    entry& e = m_index[i];
+    e.pstr = pstr;
+    e.size = s.size();
+    e.hash = hash;
+
+    m_stats.strings++;
+    m_stats.string_bytes += s.size() + 1;
+    return lite_string(pstr, s.size());
+  }
+
+  lite_string string_pool::find(const lite_string& s) const
+  {
+    if (s.empty())
+      return lite_string();
+    const entry* pentry = lookup(s.data(), s.size(), hash_of(s));
+    return pentry ? lite_string(pentry->pstr, pentry->size) : lite_string();
+  }
+
+  size_t string_pool::size() const
+  {
+    return static_cast<size_t>(m_stats.strings);
+  }
+
+  string_pool_stats string_pool::get_stats() const
+  {
+    return m_stats;
+  }
+
+  void string_pool::clear()
+  {
+    m_arena.release();
+    index_type(m_index.get_allocator()).swap(m_index);
+    m_stats = string_pool_stats();
+  }
+
+  const string_pool::entry* string_pool::lookup(const char* pstr, size_t size, size_t hash) const
+  {
+    if (m_index.empty())
+      return nullptr;
+
+    const size_t mask = m_index.size() - 1;
+    for (size_t i = hash & mask; m_index[i].pstr; i = (i + 1) & mask) {
+      const entry& e = m_index[i];
+      if (e.hash == hash && e.size == size && std::memcmp(e.pstr, pstr, size) == 0)
+        return &e;
+    }
+    return nullptr;
+  }
+
+  const char* string_pool::store(const char* pstr, size_t size)
+  {
+    // characters need no alignment, so the strings are packed one after another
+    char* pdest = static_cast<char*>(m_arena.allocate(size + 1, 1));
+    std::memcpy(pdest, pstr, size);
+    pdest[size] = '\0';
+    m_stats.arena_bytes = m_arena.reserved_bytes();
+    return pdest;
+  }
+
+  void string_pool::grow_index()
+  {
+    const entry empty_entry = { nullptr, 0, 0 };
+    index_type index(m_index.empty() ? initial_index_size : m_index.size() * 2, empty_entry, m_index.get_allocator());
+
+    const size_t mask = index.size() - 1;
+    for (auto it = m_index.begin(); it != m_index.end(); ++it) {
+      if (!it->pstr)
+        continue;
+      size_t i = it->hash & mask;
+      while (index[i].pstr)
+        i = (i + 1) & mask;
+      index[i] = *it;
+    }
+
+    m_index.swap(index);
+    m_stats.index_bytes = m_index.size() * sizeof(entry);
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+
+  struct concurrent_string_pool::shard
+  {
+    mutable std::mutex mutex;
+    std::unique_ptr<string_pool> pool;
+  };
+
+  const size_t concurrent_string_pool::default_shard_count;
+
+  concurrent_string_pool::concurrent_string_pool(size_t shard_count, size_t chunk_size, memory::memory_resource* presource)
+  {
+    shard_count = round_up_to_power_of_two(shard_count);
+    m_shards.reset(new shard[shard_count]);
+    m_shard_mask = shard_count - 1;
+    for (size_t i = 0; i < shard_count; ++i)
+      m_shards[i].pool.reset(new string_pool(chunk_size, presource));
+  }
+
+  concurrent_string_pool::~concurrent_string_pool()
+  {
+  }
+
+  lite_string concurrent_string_pool::intern(const lite_string& s)
+  {
+    const size_t hash = hash_of(s);
+    shard& sh = get_shard(hash);
+    std::lock_guard<std::mutex> lock(sh.mutex);
+    return sh.pool->intern(s, hash);
+  }
+
+  lite_string concurrent_string_pool::intern(const static_string& s)
+  {
+    shard& sh = get_shard(s.hash());
+    std::lock_guard<std::mutex> lock(sh.mutex);
+    return sh.pool->intern(s);
+  }
+
+  lite_string concurrent_string_pool::find(const lite_string& s) const
+  {
+    const size_t hash = hash_of(s);
+    shard& sh = get_shard(hash);
+    std::lock_guard<std::mutex> lock(sh.mutex);
+    if (s.empty())
+      return lite_string();
+    const string_pool::entry* pentry = sh.pool->lookup(s.data(), s.size(), hash);
+    return pentry ? lite_string(pentry->pstr, pentry->size) : lite_string();
+  }
+
+  size_t concurrent_string_pool::size() const
+  {
+    size_t count = 0;
+    for (size_t i = 0; i <= m_shard_mask; ++i) {
+      std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+      count += m_shards[i].pool->size();
+    }
+    return count;
+  }
+
+  string_pool_stats concurrent_string_pool::get_stats() const
+  {
+    string_pool_stats stats;
+    for (size_t i = 0; i <= m_shard_mask; ++i) {
+      string_pool_stats shard_stats;
+      {
+        std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+        shard_stats = m_shards[i].pool->get_stats();
+      }
+      stats.strings += shard_stats.strings;
+      stats.lookups += shard_stats.lookups;
+      stats.hits += shard_stats.hits;
+      stats.string_bytes += shard_stats.string_bytes;
+      stats.saved_bytes += shard_stats.saved_bytes;
+      stats.arena_bytes += shard_stats.arena_bytes;
+      stats.index_bytes += shard_stats.index_bytes;
+    }
+    return stats;
+  }
+
+  void concurrent_string_pool::clear()
+  {
+    for (size_t i = 0; i <= m_shard_mask; ++i) {
+      std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+      m_shards[i].pool->clear();
+    }
+  }
+
+  concurrent_string_pool::shard& concurrent_string_pool::get_shard(size_t hash) const
+  {
+    // the low bits select the slot inside the shard, so the shard is selected by the high ones
+    return m_shards[(hash >> (sizeof(size_t) * 4)) & m_shard_mask];
+  }
+
+}
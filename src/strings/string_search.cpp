@@ -0,0 +1,218 @@
+#include <easy/strings/detail/search.h>
+
+#include <cstring>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#  define EASY_SEARCH_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#  define EASY_SEARCH_AVX2
+#  include <immintrin.h>
+#endif
+
+#ifdef EASY_MSVC_VERSION
+#  include <intrin.h>
+#endif
+
+namespace easy { namespace detail
+{
+  namespace
+  {
+    inline unsigned first_bit(unsigned mask)
+    {
+      EASY_ASSERT(mask);
+#ifdef EASY_MSVC_VERSION
+      unsigned long index;
+      _BitScanForward(&index, mask);
+      return index;
+#else
+      return __builtin_ctz(mask);
+#endif
+    }
+
+    inline unsigned last_bit(unsigned mask)
+    {
+      EASY_ASSERT(mask);
+#ifdef EASY_MSVC_VERSION
+      unsigned long index;
+      _BitScanReverse(&index, mask);
+      return index;
+#else
+      return 31 - __builtin_clz(mask);
+#endif
+    }
+
+    //! Sets with more characters are looked up in a table, comparing every character costs more
+    const size_t max_vector_set_size = 8;
+
+    const char* find_in_table(const char* p, const char* end, const char* pset, size_t set_size)
+    {
+      bool table[256] = {};
+      for (size_t i = 0; i < set_size; ++i)
+        table[static_cast<unsigned char>(pset[i])] = true;
+      for (; p < end; ++p) {
+        if (table[static_cast<unsigned char>(*p)])
+          return p;
+      }
+      return nullptr;
+    }
+  }
+
+  const char* find_char(const char* pstr, size_t size, char c)
+  {
+    const char* p = pstr;
+    const char* end = pstr + size;
+#ifdef EASY_SEARCH_AVX2
+    const __m256i needle32 = _mm256_set1_epi8(c);
+    for (; end - p >= 32; p += 32) {
+      const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle32)));
+      if (mask)
+        return p + first_bit(mask);
+    }
+#endif
+#ifdef EASY_SEARCH_SSE2
+    const __m128i needle = _mm_set1_epi8(c);
+    for (; end - p >= 16; p += 16) {
+      const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+      if (mask)
+        return p + first_bit(mask);
+    }
+#endif
+    for (; p < end; ++p) {
+      if (*p == c)
+        return p;
+    }
+    return nullptr;
+  }
+
+  const char* rfind_char(const char* pstr, size_t size, char c)
+  {
+    const char* end = pstr + size;
+#ifdef EASY_SEARCH_AVX2
+    const __m256i needle32 = _mm256_set1_epi8(c);
+    for (; end - pstr >= 32; end -= 32) {
+      const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(end - 32));
+      const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle32)));
+      if (mask)
+        return end - 32 + last_bit(mask);
+    }
+#endif
+#ifdef EASY_SEARCH_SSE2
+    const __m128i needle = _mm_set1_epi8(c);
+    for (; end - pstr >= 16; end -= 16) {
+      const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(end - 16));
+      const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+      if (mask)
+        return end - 16 + last_bit(mask);
+    }
+#endif
+    while (end != pstr) {
+      if (*--end == c)
+        return end;
+    }
+    return nullptr;
+  }
+
+  const char* find_any_of(const char* pstr, size_t size, const char* pset, size_t set_size)
+  {
+    if (set_size == 0)
+      return nullptr;
+    if (set_size == 1)
+      return find_char(pstr, size, pset[0]);
+
+    const char* p = pstr;
+    const char* end = pstr + size;
+    if (set_size > max_vector_set_size)
+      return find_in_table(p, end, pset, set_size);
+
+#ifdef EASY_SEARCH_SSE2
+    __m128i needles[max_vector_set_size];
+    for (size_t i = 0; i < set_size; ++i)
+      needles[i] = _mm_set1_epi8(pset[i]);
+
+    for (; end - p >= 16; p += 16) {
+      const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      __m128i eq = _mm_cmpeq_epi8(block, needles[0]);
+      for (size_t i = 1; i < set_size; ++i)
+        eq = _mm_or_si128(eq, _mm_cmpeq_epi8(block, needles[i]));
+      const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+      if (mask)
+        return p + first_bit(mask);
+    }
+#endif
+    return find_in_table(p, end, pset, set_size);
+  }
+
+  const char* find_substr(const char* pstr, size_t size, const char* psub, size_t sub_size)
+  {
+    if (sub_size == 0)
+      return pstr;
+    if (sub_size > size)
+      return nullptr;
+    if (sub_size == 1)
+      return find_char(pstr, size, psub[0]);
+
+    // candidates must match both the first and the last character of the substring,
+    // which filters out most of them before the comparison
+    size_t i = 0;
+#ifdef EASY_SEARCH_AVX2
+    const __m256i first32 = _mm256_set1_epi8(psub[0]);
+    const __m256i last32 = _mm256_set1_epi8(psub[sub_size - 1]);
+    for (; i + sub_size + 31 <= size; i += 32) {
+      const __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pstr + i));
+      const __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pstr + i + sub_size - 1));
+      const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first32), _mm256_cmpeq_epi8(block_last, last32));
+      for (unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq)); mask; mask &= mask - 1) {
+        const char* p = pstr + i + first_bit(mask);
+        if (std::memcmp(p + 1, psub + 1, sub_size - 2) == 0)
+          return p;
+      }
+    }
+#endif
+#ifdef EASY_SEARCH_SSE2
+    const __m128i first = _mm_set1_epi8(psub[0]);
+    const __m128i last = _mm_set1_epi8(psub[sub_size - 1]);
+    for (; i + sub_size + 15 <= size; i += 16) {
+      const __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pstr + i));
+      const __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pstr + i + sub_size - 1));
+      const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last));
+      for (unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq)); mask; mask &= mask - 1) {
+        const char* p = pstr + i + first_bit(mask);
+        if (std::memcmp(p + 1, psub + 1, sub_size - 2) == 0)
+          return p;
+      }
+    }
+#endif
+    for (const char* p = pstr + i; p + sub_size <= pstr + size; ++p) {
+      p = find_char(p, size - sub_size + 1 - (p - pstr), psub[0]);
+      if (!p)
+        return nullptr;
+      if (std::memcmp(p, psub, sub_size) == 0)
+        return p;
+    }
+    return nullptr;
+  }
+
+  const char* rfind_substr(const char* pstr, size_t size, const char* psub, size_t sub_size)
+  {
+    if (sub_size > size)
+      return nullptr;
+    if (sub_size == 0)
+      return pstr + size;
+
+    for (size_t limit = size - sub_size + 1; limit > 0; ) {
+      const char* p = rfind_char(pstr, limit, psub[0]);
+      if (!p)
+        return nullptr;
+      if (std::memcmp(p, psub, sub_size) == 0)
+        return p;
+      limit = p - pstr;
+    }
+    return nullptr;
+  }
+
+}}
@@ -0,0 +1,724 @@
+#include <easy/strings/utf.h>
+
+#include <boost/system/error_code.hpp>
+
+#include <cstring>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#  define EASY_UTF_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace easy { namespace utf
+{
+  namespace
+  {
+    typedef unsigned char uchar;
+
+    inline bool is_continuation(uchar b)
+    {
+      return (b & 0xC0) == 0x80;
+    }
+
+    inline bool is_surrogate(uint32 c)
+    {
+      return (c & 0xFFFFF800) == 0xD800;
+    }
+
+    inline bool is_valid_code_point(uint32 c)
+    {
+      return c <= 0x10FFFF && !is_surrogate(c);
+    }
+
+    //! Decodes a code point starting at p. Returns the number of bytes or 0 for invalid input
+    inline size_t decode_utf8(const uchar* p, const uchar* end, uint32& c)
+    {
+      const uchar b0 = p[0];
+      if (b0 < 0x80) {
+        c = b0;
+        return 1;
+      }
+
+      const size_t available = end - p;
+      if (b0 < 0xC2) {
+        // a continuation byte or an overlong two byte form
+        return 0;
+      }
+      if (b0 < 0xE0) {
+        if (available < 2 || !is_continuation(p[1]))
+          return 0;
+        c = ((b0 & 0x1F) << 6) | (p[1] & 0x3F);
+        return 2;
+      }
+      if (b0 < 0xF0) {
+        if (available < 3 || !is_continuation(p[1]) || !is_continuation(p[2]))
+          return 0;
+        if ((b0 == 0xE0 && p[1] < 0xA0) || (b0 == 0xED && p[1] >= 0xA0))
+          return 0; // overlong or a surrogate
+        c = ((b0 & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+        return 3;
+      }
+      if (b0 < 0xF5) {
+        if (available < 4 || !is_continuation(p[1]) || !is_continuation(p[2]) || !is_continuation(p[3]))
+          return 0;
+        if ((b0 == 0xF0 && p[1] < 0x90) || (b0 == 0xF4 && p[1] >= 0x90))
+          return 0; // overlong or above U+10FFFF
+        c = ((b0 & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        return 4;
+      }
+      return 0;
+    }
+
+    //! Decodes a code point starting at p. Returns the number of units or 0 for invalid input
+    inline size_t decode_utf16(const uint16* p, const uint16* end, uint32& c)
+    {
+      const uint16 w = p[0];
+      if (!is_surrogate(w)) {
+        c = w;
+        return 1;
+      }
+      if (w >= 0xDC00 || end - p < 2 || (p[1] & 0xFC00) != 0xDC00)
+        return 0;
+      c = 0x10000 + ((static_cast<uint32>(w) - 0xD800) << 10) + (p[1] - 0xDC00);
+      return 2;
+    }
+
+    inline size_t encode_utf8(uint32 c, char* pdest)
+    {
+      if (c < 0x80) {
+        pdest[0] = static_cast<char>(c);
+        return 1;
+      }
+      if (c < 0x800) {
+        pdest[0] = static_cast<char>(0xC0 | (c >> 6));
+        pdest[1] = static_cast<char>(0x80 | (c & 0x3F));
+        return 2;
+      }
+      if (c < 0x10000) {
+        pdest[0] = static_cast<char>(0xE0 | (c >> 12));
+        pdest[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        pdest[2] = static_cast<char>(0x80 | (c & 0x3F));
+        return 3;
+      }
+      pdest[0] = static_cast<char>(0xF0 | (c >> 18));
+      pdest[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+      pdest[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+      pdest[3] = static_cast<char>(0x80 | (c & 0x3F));
+      return 4;
+    }
+
+    inline size_t encode_utf16(uint32 c, uint16* pdest)
+    {
+      if (c < 0x10000) {
+        pdest[0] = static_cast<uint16>(c);
+        return 1;
+      }
+      c -= 0x10000;
+      pdest[0] = static_cast<uint16>(0xD800 + (c >> 10));
+      pdest[1] = static_cast<uint16>(0xDC00 + (c & 0x3FF));
+      return 2;
+    }
+
+    // After a vector block with non ASCII characters this many input units are handled
+    // by the scalar code, so mixed text does not pay for a failed vector check per character
+    const size_t scalar_run = 16;
+
+    //! Returns the length of the ASCII prefix
+    size_t ascii_prefix(const uchar* p, size_t size)
+    {
+      size_t i = 0;
+#ifdef EASY_UTF_SSE2
+      for (; i + 16 <= size; i += 16) {
+        if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))))
+          break;
+      }
+#endif
+      while (i < size && p[i] < 0x80)
+        ++i;
+      return i;
+    }
+
+    //! Returns the length of the sequence starting with the byte or 0 if it cannot start one
+    inline size_t sequence_length(uchar b0)
+    {
+      return b0 < 0x80 ? 1 : b0 < 0xC2 ? 0 : b0 < 0xE0 ? 2 : b0 < 0xF0 ? 3 : b0 < 0xF5 ? 4 : 0;
+    }
+
+    //! Returns true if the bytes can be completed to a valid multibyte sequence
+    inline bool is_valid_prefix(const uchar* p, size_t size)
+    {
+      if (sequence_length(p[0]) < 2)
+        return false;
+      for (size_t i = 1; i < size; ++i) {
+        if (!is_continuation(p[i]))
+          return false;
+      }
+      if (size > 1) {
+        const uchar b0 = p[0];
+        const uchar b1 = p[1];
+        if ((b0 == 0xE0 && b1 < 0xA0) || (b0 == 0xED && b1 >= 0xA0) || (b0 == 0xF0 && b1 < 0x90) || (b0 == 0xF4 && b1 >= 0x90))
+          return false;
+      }
+      return true;
+    }
+
+    //! Returns the first invalid sequence or end
+    const uchar* find_invalid_utf8(const uchar* p, const uchar* end)
+    {
+      while (p < end) {
+        p += ascii_prefix(p, end - p);
+        const uchar* run_end = end - p > static_cast<std::ptrdiff_t>(scalar_run) ? p + scalar_run : end;
+        while (p < run_end) {
+          uint32 c;
+          const size_t length = decode_utf8(p, end, c);
+          if (!length)
+            return p;
+          p += length;
+        }
+      }
+      return end;
+    }
+
+    //! Converts UTF-8 to UTF-16 or UTF-32. On invalid input returns false with p at the invalid sequence
+    template<class TUnit>
+    bool transcode_utf8(const uchar*& p, const uchar* end, TUnit*& d)
+    {
+      while (p < end) {
+#ifdef EASY_UTF_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; end - p >= 16; p += 16, d += 16) {
+          const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+          if (_mm_movemask_epi8(v))
+            break;
+          const __m128i lo = _mm_unpacklo_epi8(v, zero);
+          const __m128i hi = _mm_unpackhi_epi8(v, zero);
+          if (sizeof(TUnit) == 2) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 8), hi);
+          }
+          else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 4), _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 8), _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 12), _mm_unpackhi_epi16(hi, zero));
+          }
+        }
+#endif
+        const uchar* run_end = end - p > static_cast<std::ptrdiff_t>(scalar_run) ? p + scalar_run : end;
+        while (p < run_end) {
+          uint32 c;
+          const size_t length = decode_utf8(p, end, c);
+          if (!length)
+            return false;
+          p += length;
+          if (sizeof(TUnit) == 2)
+            d += encode_utf16(c, reinterpret_cast<uint16*>(d));
+          else
+            *d++ = static_cast<TUnit>(c);
+        }
+      }
+      return true;
+    }
+
+    template<class TUnit>
+    size_t convert_from_utf8(const char* pstr, size_t size, TUnit* pdest, error_code_ref ec)
+    {
+      const uchar* p = reinterpret_cast<const uchar*>(pstr);
+      TUnit* d = pdest;
+      if (!transcode_utf8(p, p + size, d)) {
+        ec = make_invalid_sequence_error();
+        return 0;
+      }
+      return d - pdest;
+    }
+
+#ifdef EASY_UTF_SSE2
+    //! Returns the number of non continuation bytes and of four byte sequence leads in 16 byte blocks
+    void count_utf8_blocks(const uchar*& p, const uchar* end, size_t& leads, size_t& long_leads)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i last_continuation = _mm_set1_epi8(static_cast<char>(0xBF));
+      const __m128i first_long_lead = _mm_set1_epi8(static_cast<char>(0xF0));
+      while (end - p >= 16) {
+        // the byte counters must not overflow
+        __m128i lead_count = zero;
+        __m128i long_lead_count = zero;
+        for (size_t i = 0; i < 255 && end - p >= 16; ++i, p += 16) {
+          const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+          // continuation bytes are the smallest signed values
+          lead_count = _mm_sub_epi8(lead_count, _mm_cmpgt_epi8(v, last_continuation));
+          long_lead_count = _mm_sub_epi8(long_lead_count, _mm_cmpeq_epi8(_mm_max_epu8(v, first_long_lead), v));
+        }
+        const __m128i lead_sum = _mm_sad_epu8(lead_count, zero);
+        const __m128i long_lead_sum = _mm_sad_epu8(long_lead_count, zero);
+        leads += _mm_cvtsi128_si32(lead_sum) + _mm_cvtsi128_si32(_mm_srli_si128(lead_sum, 8));
+        long_leads += _mm_cvtsi128_si32(long_lead_sum) + _mm_cvtsi128_si32(_mm_srli_si128(long_lead_sum, 8));
+      }
+    }
+#endif
+
+    void count_utf8(const char* pstr, size_t size, size_t& leads, size_t& long_leads)
+    {
+      const uchar* p = reinterpret_cast<const uchar*>(pstr);
+      const uchar* end = p + size;
+      leads = long_leads = 0;
+#ifdef EASY_UTF_SSE2
+      count_utf8_blocks(p, end, leads, long_leads);
+#endif
+      for (; p < end; ++p) {
+        leads += is_continuation(*p) ? 0 : 1;
+        long_leads += *p >= 0xF0 ? 1 : 0;
+      }
+    }
+  }
+
+  error_code make_invalid_sequence_error()
+  {
+    return boost::system::errc::make_error_code(boost::system::errc::illegal_byte_sequence);
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+
+  bool validate_utf8(const char* pstr, size_t size)
+  {
+    const uchar* p = reinterpret_cast<const uchar*>(pstr);
+    return find_invalid_utf8(p, p + size) == p + size;
+  }
+
+  bool validate_utf16(const uint16* pstr, size_t size)
+  {
+    const uint16* p = pstr;
+    const uint16* end = pstr + size;
+    while (p < end) {
+#ifdef EASY_UTF_SSE2
+      const __m128i surrogate_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+      const __m128i surrogate = _mm_set1_epi16(static_cast<short>(0xD800));
+      for (; end - p >= 8; p += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, surrogate_mask), surrogate)))
+          break;
+      }
+#endif
+      const uint16* run_end = end - p > static_cast<std::ptrdiff_t>(scalar_run) ? p + scalar_run : end;
+      while (p < run_end) {
+        uint32 c;
+        const size_t length = decode_utf16(p, end, c);
+        if (!length)
+          return false;
+        p += length;
+      }
+    }
+    return true;
+  }
+
+  bool validate_utf32(const uint32* pstr, size_t size)
+  {
+    size_t i = 0;
+#ifdef EASY_UTF_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max_code_point = _mm_set1_epi32(0x10FFFF);
+    const __m128i surrogate_mask = _mm_set1_epi32(static_cast<int>(0xFFFFF800));
+    const __m128i surrogate = _mm_set1_epi32(0xD800);
+    for (; i + 4 <= size; i += 4) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pstr + i));
+      const __m128i invalid = _mm_or_si128(
+        _mm_or_si128(_mm_cmplt_epi32(v, zero), _mm_cmpgt_epi32(v, max_code_point)),
+        _mm_cmpeq_epi32(_mm_and_si128(v, surrogate_mask), surrogate));
+      if (_mm_movemask_epi8(invalid))
+        return false;
+    }
+#endif
+    for (; i < size; ++i) {
+      if (!is_valid_code_point(pstr[i]))
+        return false;
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+
+  size_t utf16_length_from_utf8(const char* pstr, size_t size)
+  {
+    // every sequence gives a unit and four byte sequences give a surrogate pair
+    size_t leads, long_leads;
+    count_utf8(pstr, size, leads, long_leads);
+    return leads + long_leads;
+  }
+
+  size_t utf32_length_from_utf8(const char* pstr, size_t size)
+  {
+    size_t leads, long_leads;
+    count_utf8(pstr, size, leads, long_leads);
+    return leads;
+  }
+
+  size_t utf8_length_from_utf16(const uint16* pstr, size_t size)
+  {
+    size_t length = 0;
+    size_t i = 0;
+#ifdef EASY_UTF_SSE2
+    // the unsigned comparisons are made signed by flipping the sign bits
+    const __m128i sign = _mm_set1_epi16(static_cast<short>(0x8000));
+    const __m128i last_one_byte = _mm_set1_epi16(static_cast<short>(0x007F ^ 0x8000));
+    const __m128i last_two_byte = _mm_set1_epi16(static_cast<short>(0x07FF ^ 0x8000));
+    const __m128i surrogate_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+    const __m128i surrogate = _mm_set1_epi16(static_cast<short>(0xD800));
+    const __m128i ones = _mm_set1_epi16(1);
+    while (i + 8 <= size) {
+      // a unit adds at most 3 to a 16 bit counter
+      __m128i count = _mm_setzero_si128();
+      for (size_t j = 0; j < 8192 && i + 8 <= size; ++j, i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pstr + i));
+        const __m128i flipped = _mm_xor_si128(v, sign);
+        // 1 + (v >= 0x80) + (v >= 0x800) - is_surrogate(v), a surrogate pair gives 4 bytes
+        count = _mm_add_epi16(count, ones);
+        count = _mm_sub_epi16(count, _mm_cmpgt_epi16(flipped, last_one_byte));
+        count = _mm_sub_epi16(count, _mm_cmpgt_epi16(flipped, last_two_byte));
+        count = _mm_add_epi16(count, _mm_cmpeq_epi16(_mm_and_si128(v, surrogate_mask), surrogate));
+      }
+      __m128i sum = _mm_madd_epi16(count, ones);
+      sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+      sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+      length += static_cast<uint32>(_mm_cvtsi128_si32(sum));
+    }
+#endif
+    for (; i < size; ++i) {
+      const uint16 w = pstr[i];
+      length += 1 + (w >= 0x80 ? 1 : 0) + (w >= 0x800 ? 1 : 0) - (is_surrogate(w) ? 1 : 0);
+    }
+    return length;
+  }
+
+  size_t utf32_length_from_utf16(const uint16* pstr, size_t size)
+  {
+    size_t high_surrogates = 0;
+    for (size_t i = 0; i < size; ++i)
+      high_surrogates += (pstr[i] & 0xFC00) == 0xD800 ? 1 : 0;
+    return size - high_surrogates;
+  }
+
+  size_t utf8_length_from_utf32(const uint32* pstr, size_t size)
+  {
+    size_t length = 0;
+    for (size_t i = 0; i < size; ++i) {
+      const uint32 c = pstr[i];
+      length += 1 + (c >= 0x80 ? 1 : 0) + (c >= 0x800 ? 1 : 0) + (c >= 0x10000 ? 1 : 0);
+    }
+    return length;
+  }
+
+  size_t utf16_length_from_utf32(const uint32* pstr, size_t size)
+  {
+    size_t length = size;
+    for (size_t i = 0; i < size; ++i)
+      length += pstr[i] >= 0x10000 ? 1 : 0;
+    return length;
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+
+  size_t convert_utf8_to_utf16(const char* pstr, size_t size, uint16* pdest, error_code_ref ec)
+  {
+    return convert_from_utf8(pstr, size, pdest, ec);
+  }
+
+  size_t convert_utf8_to_utf32(const char* pstr, size_t size, uint32* pdest, error_code_ref ec)
+  {
+    return convert_from_utf8(pstr, size, pdest, ec);
+  }
+
+  size_t convert_utf16_to_utf8(const uint16* pstr, size_t size, char* pdest, error_code_ref ec)
+  {
+    const uint16* p = pstr;
+    const uint16* end = pstr + size;
+    char* d = pdest;
+
+    while (p < end) {
+#ifdef EASY_UTF_SSE2
+      const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+      const __m128i zero = _mm_setzero_si128();
+      for (; end - p >= 16; p += 16, d += 16) {
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+        const __m128i high_bits = _mm_and_si128(_mm_or_si128(v1, v2), non_ascii);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, zero)) != 0xFFFF)
+          break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_packus_epi16(v1, v2));
+      }
+#endif
+      const uint16* run_end = end - p > static_cast<std::ptrdiff_t>(scalar_run) ? p + scalar_run : end;
+      while (p < run_end) {
+        uint32 c;
+        const size_t length = decode_utf16(p, end, c);
+        if (!length) {
+          ec = make_invalid_sequence_error();
+          return 0;
+        }
+        p += length;
+        d += encode_utf8(c, d);
+      }
+    }
+    return d - pdest;
+  }
+
+  size_t convert_utf16_to_utf32(const uint16* pstr, size_t size, uint32* pdest, error_code_ref ec)
+  {
+    const uint16* p = pstr;
+    const uint16* end = pstr + size;
+    uint32* d = pdest;
+
+    while (p < end) {
+#ifdef EASY_UTF_SSE2
+      const __m128i surrogate_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+      const __m128i surrogate = _mm_set1_epi16(static_cast<short>(0xD800));
+      const __m128i zero = _mm_setzero_si128();
+      for (; end - p >= 8; p += 8, d += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, surrogate_mask), surrogate)))
+          break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_unpacklo_epi16(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 4), _mm_unpackhi_epi16(v, zero));
+      }
+#endif
+      const uint16* run_end = end - p > static_cast<std::ptrdiff_t>(scalar_run) ? p + scalar_run : end;
+      while (p < run_end) {
+        uint32 c;
+        const size_t length = decode_utf16(p, end, c);
+        if (!length) {
+          ec = make_invalid_sequence_error();
+          return 0;
+        }
+        p += length;
+        *d++ = c;
+      }
+    }
+    return d - pdest;
+  }
+
+  size_t convert_utf32_to_utf8(const uint32* pstr, size_t size, char* pdest, error_code_ref ec)
+  {
+    const uint32* p = pstr;
+    const uint32* end = pstr + size;
+    char* d = pdest;
+
+    while (p < end) {
+#ifdef EASY_UTF_SSE2
+      const __m128i non_ascii = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+      const __m128i zero = _mm_setzero_si128();
+      for (; end - p >= 16; p += 16, d += 16) {
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+        const __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+        const __m128i v4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+        const __m128i high_bits = _mm_and_si128(_mm_or_si128(_mm_or_si128(v1, v2), _mm_or_si128(v3, v4)), non_ascii);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(high_bits, zero)) != 0xFFFF)
+          break;
+        const __m128i lo = _mm_packs_epi32(v1, v2);
+        const __m128i hi = _mm_packs_epi32(v3, v4);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_packus_epi16(lo, hi));
+      }
+#endif
+      const uint32* run_end = end - p > static_cast<std::ptrdiff_t>(scalar_run) ? p + scalar_run : end;
+      for (; p < run_end; ++p) {
+        if (!is_valid_code_point(*p)) {
+          ec = make_invalid_sequence_error();
+          return 0;
+        }
+        d += encode_utf8(*p, d);
+      }
+    }
+    return d - pdest;
+  }
+
+  size_t convert_utf32_to_utf16(const uint32* pstr, size_t size, uint16* pdest, error_code_ref ec)
+  {
+    const uint32* p = pstr;
+    const uint32* end = pstr + size;
+    uint16* d = pdest;
+
+    while (p < end) {
+#ifdef EASY_UTF_SSE2
+      // units below the surrogates are packed with signed saturation after a shift by 0x8000
+      const __m128i last_bmp_unit = _mm_set1_epi32(0xD7FF);
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i shift32 = _mm_set1_epi32(0x8000);
+      const __m128i shift16 = _mm_set1_epi16(static_cast<short>(0x8000));
+      for (; end - p >= 8; p += 8, d += 8) {
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+        const __m128i out_of_range = _mm_or_si128(
+          _mm_or_si128(_mm_cmplt_epi32(v1, zero), _mm_cmplt_epi32(v2, zero)),
+          _mm_or_si128(_mm_cmpgt_epi32(v1, last_bmp_unit), _mm_cmpgt_epi32(v2, last_bmp_unit)));
+        if (_mm_movemask_epi8(out_of_range))
+          break;
+        const __m128i packed = _mm_packs_epi32(_mm_sub_epi32(v1, shift32), _mm_sub_epi32(v2, shift32));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_add_epi16(packed, shift16));
+      }
+#endif
+      const uint32* run_end = end - p > static_cast<std::ptrdiff_t>(scalar_run) ? p + scalar_run : end;
+      for (; p < run_end; ++p) {
+        if (!is_valid_code_point(*p)) {
+          ec = make_invalid_sequence_error();
+          return 0;
+        }
+        d += encode_utf16(*p, d);
+      }
+    }
+    return d - pdest;
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+
+  namespace
+  {
+    inline void append_code_point(uint32 c, std::vector<uint16>& out)
+    {
+      uint16 units[2];
+      out.insert(out.end(), units, units + encode_utf16(c, units));
+    }
+
+    inline void append_code_point(uint32 c, std::vector<uint32>& out)
+    {
+      out.push_back(c);
+    }
+  }
+
+  utf8_decoder::utf8_decoder()
+    : m_offset(0), m_error_offset(0), m_pending_size(0), m_failed(false)
+  {
+  }
+
+  void utf8_decoder::validate(const char* pstr, size_t size, error_code_ref ec)
+  {
+    decode_chunk<uint32>(pstr, size, nullptr, ec);
+  }
+
+  void utf8_decoder::decode(const char* pstr, size_t size, std::vector<uint16>& out, error_code_ref ec)
+  {
+    decode_chunk(pstr, size, &out, ec);
+  }
+
+  void utf8_decoder::decode(const char* pstr, size_t size, std::vector<uint32>& out, error_code_ref ec)
+  {
+    decode_chunk(pstr, size, &out, ec);
+  }
+
+  void utf8_decoder::finish(error_code_ref ec)
+  {
+    if (!m_failed && m_pending_size)
+      set_failed(m_offset - m_pending_size);
+    if (m_failed)
+      ec = make_invalid_sequence_error();
+  }
+
+  void utf8_decoder::reset()
+  {
+    m_offset = m_error_offset = 0;
+    m_pending_size = 0;
+    m_failed = false;
+  }
+
+  uint64 utf8_decoder::offset() const
+  {
+    return m_offset;
+  }
+
+  uint64 utf8_decoder::error_offset() const
+  {
+    return m_failed ? m_error_offset : m_offset;
+  }
+
+  bool utf8_decoder::failed() const
+  {
+    return m_failed;
+  }
+
+  size_t utf8_decoder::pending() const
+  {
+    return m_pending_size;
+  }
+
+  void utf8_decoder::set_failed(uint64 offset)
+  {
+    m_failed = true;
+    m_error_offset = offset;
+    m_pending_size = 0;
+  }
+
+  template<class TUnit>
+  void utf8_decoder::decode_chunk(const char* pstr, size_t size, std::vector<TUnit>* pout, error_code_ref ec)
+  {
+    if (m_failed) {
+      ec = make_invalid_sequence_error();
+      return;
+    }
+
+    const uchar* p = reinterpret_cast<const uchar*>(pstr);
+    const uchar* end = p + size;
+    const uint64 chunk_offset = m_offset;
+    m_offset += size;
+
+    // complete the sequence the previous chunk ended with
+    if (m_pending_size) {
+      uchar* pending = reinterpret_cast<uchar*>(m_pending);
+      const size_t pending_size = m_pending_size;
+      const size_t length = sequence_length(pending[0]);
+      while (m_pending_size < length && p < end)
+        pending[m_pending_size++] = *p++;
+
+      uint32 c;
+      if (m_pending_size < length ? !is_valid_prefix(pending, m_pending_size) : !decode_utf8(pending, pending + length, c)) {
+        set_failed(chunk_offset - pending_size);
+        ec = make_invalid_sequence_error();
+        return;
+      }
+      if (m_pending_size < length)
+        return;
+      if (pout)
+        append_code_point(c, *pout);
+      m_pending_size = 0;
+    }
+
+    // a sequence cut by the end of the chunk is kept for the next one,
+    // an invalid one is left in place to be reported at its offset
+    size_t tail = 0;
+    for (size_t k = 1; k <= 3 && k <= static_cast<size_t>(end - p); ++k) {
+      if (!is_continuation(end[-static_cast<std::ptrdiff_t>(k)])) {
+        const uchar* plead = end - k;
+        if (sequence_length(*plead) > k && is_valid_prefix(plead, k))
+          tail = k;
+        break;
+      }
+    }
+    const uchar* body_end = end - tail;
+
+    bool valid;
+    if (pout) {
+      std::vector<TUnit>& out = *pout;
+      const size_t out_size = out.size();
+      const char* pbody = reinterpret_cast<const char*>(p);
+      const size_t length = sizeof(TUnit) == 2
+        ? utf16_length_from_utf8(pbody, body_end - p)
+        : utf32_length_from_utf8(pbody, body_end - p);
+      out.resize(out_size + length);
+      TUnit* pdest = out.empty() ? nullptr : &out[0] + out_size;
+      TUnit* d = pdest;
+      valid = transcode_utf8(p, body_end, d);
+      out.resize(out_size + (d - pdest));
+    }
+    else {
+      p = find_invalid_utf8(p, body_end);
+      valid = p == body_end;
+    }
+
+    if (!valid) {
+      set_failed(chunk_offset + (p - reinterpret_cast<const uchar*>(pstr)));
+      ec = make_invalid_sequence_error();
+      return;
+    }
+
+    std::memcpy(m_pending, body_end, tail);
+    m_pending_size = tail;
+  }
+
+}}
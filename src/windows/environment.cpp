@@ -70,7 +70,7 @@ namespace windows
 
 
   class process_environment_variable_enumerator_impl
-    : public enumerator<environment_variable>
+    : public batch_enumerator<process_environment_variable_enumerator_impl, environment_variable>
   {
   public:
     process_environment_variable_enumerator_impl(error_code_ref ec)
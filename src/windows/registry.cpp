@@ -19,9 +19,11 @@ namespace windows
   {
     template<class RegKeyTracker>
     class reg_key_enumerator_impl
-      : public enumerator<std::wstring>
+      : public batch_enumerator<reg_key_enumerator_impl<RegKeyTracker>, std::wstring>
     {
     public:    
+      typedef enumerator<std::wstring>::result_type result_type;
+
       enum { MAX_REG_KEY_LENGTH = 256 };
 
       typedef RegKeyTracker tracker_type;
@@ -82,9 +84,11 @@ namespace windows
 
     template<class RegKeyTracker>
     class reg_value_name_enumerator_impl
-      : public enumerator<std::wstring>
+      : public batch_enumerator<reg_value_name_enumerator_impl<RegKeyTracker>, std::wstring>
     {
     public:    
+      typedef enumerator<std::wstring>::result_type result_type;
+
       enum { MAX_REG_VALUE_NAME_LENGTH = 163834 };
 
       typedef RegKeyTracker tracker_type;
@@ -0,0 +1,120 @@
+/*!
+ *  @file   tests/error_handling_benchmark.cpp
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  @brief Cost of reporting errors through error_code_ref and result<T> in tight loops.
+ *
+ *  A function converting a digit is called through a pointer, so it is not inlined, the way
+ *  api:: functions are called from other translation units. It is called with a throwable
+ *  error_code_ref, with an error_code and returning result<int>, succeeding every time and
+ *  failing on every 16th call. The results are printed to stdout as JSON.
+ *
+ *  Build on Linux from the repository root:
+ *
+ *    g++ -std=c++11 -O2 -DNDEBUG -I. tests/error_handling_benchmark.cpp src/error_handling.cpp -o error_handling_benchmark -lboost_system
+ *
+ *  Usage: error_handling_benchmark [calls]
+ */
+#include <easy/error_handling.h>
+#include <easy/result.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+  typedef std::chrono::steady_clock clock_type;
+
+  int to_digit(char c, easy::error_code_ref ec)
+  {
+    if (c < '0' || c > '9') {
+      ec = easy::generic_error::invalid_value;
+      return 0;
+    }
+    return c - '0';
+  }
+
+  easy::result<int> to_digit_result(char c)
+  {
+    if (c < '0' || c > '9')
+      return easy::generic_error::invalid_value;
+    return c - '0';
+  }
+
+  int (* volatile pto_digit)(char, easy::error_code_ref) = &to_digit;
+  easy::result<int> (* volatile pto_digit_result)(char) = &to_digit_result;
+
+  char digit_at(size_t i, bool failing)
+  {
+    return failing && i % 16 == 0 ? 'x' : static_cast<char>('0' + i % 10);
+  }
+
+  template<class Loop>
+  double measure(Loop loop, size_t calls, size_t& checksum)
+  {
+    const clock_type::time_point start = clock_type::now();
+    checksum += loop(calls);
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+  }
+
+  struct throwable_loop
+  {
+    size_t operator () (size_t calls) const {
+      size_t sum = 0;
+      for (size_t i = 0; i < calls; ++i)
+        sum += pto_digit(digit_at(i, false), nullptr);
+      return sum;
+    }
+  };
+
+  struct error_code_loop
+  {
+    bool failing;
+
+    size_t operator () (size_t calls) const {
+      size_t sum = 0;
+      easy::error_code ec;
+      for (size_t i = 0; i < calls; ++i) {
+        sum += pto_digit(digit_at(i, failing), ec);
+        sum += ec ? 1 : 0;
+      }
+      return sum;
+    }
+  };
+
+  struct result_loop
+  {
+    bool failing;
+
+    size_t operator () (size_t calls) const {
+      size_t sum = 0;
+      for (size_t i = 0; i < calls; ++i) {
+        const easy::result<int> r = pto_digit_result(digit_at(i, failing));
+        sum += r ? *r : 1;
+      }
+      return sum;
+    }
+  };
+}
+
+int main(int argc, char* argv[])
+{
+  const size_t calls = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000000;
+
+  size_t checksum = 0;
+  const error_code_loop error_code_ok = { false };
+  const error_code_loop error_code_failing = { true };
+  const result_loop result_ok = { false };
+  const result_loop result_failing = { true };
+
+  std::printf("{\n  \"calls\": %u,\n  \"seconds\": {\n", static_cast<unsigned>(calls));
+  std::printf("    \"throwable_ok\": %.3f,\n", measure(throwable_loop(), calls, checksum));
+  std::printf("    \"error_code_ok\": %.3f,\n", measure(error_code_ok, calls, checksum));
+  std::printf("    \"error_code_failing\": %.3f,\n", measure(error_code_failing, calls, checksum));
+  std::printf("    \"result_ok\": %.3f,\n", measure(result_ok, calls, checksum));
+  std::printf("    \"result_failing\": %.3f\n", measure(result_failing, calls, checksum));
+  std::printf("  },\n  \"checksum\": %u\n}\n", static_cast<unsigned>(checksum));
+  return 0;
+}
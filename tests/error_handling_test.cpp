@@ -9,6 +9,13 @@
 #include "include.h"
 
 #include <easy/error_handling.h>
+#include <easy/result.h>
+#include <easy/error_telemetry.h>
+#include <easy/strings/conv.h>
+#include <easy/strings/numbers.h>
+
+#include <string>
+#include <thread>
 
 namespace {
   enum class user_error;
@@ -36,7 +43,7 @@ namespace {
   {
   public:
 
-    const char * name() const EASY_NOEXCEPT
+    const char * name() const BOOST_SYSTEM_NOEXCEPT
     {
       return "user_error";
     }
@@ -61,6 +68,14 @@ namespace {
   void test_func2(easy::error_code_ref ec = nullptr) {
     ec.set_system_error(0); // will not throw
   }
+
+  easy::result<std::string> test_result(int v) {
+    if (v < 0)
+      return user_error::invalid;
+    if (v == 0)
+      return easy::error_code(user_error::empty);
+    return std::string(v, 'x');
+  }
 }
 
 
@@ -84,3 +99,227 @@ BOOST_AUTO_TEST_CASE(ErrorCode)
   }
   throw "The call within try-catch block must shouldn't throw";
 }
+
+
+BOOST_AUTO_TEST_CASE(ErrorCodeRef)
+{
+  easy::error_code ec = user_error::invalid;
+  easy::error_code_ref ref = ec;
+  BOOST_CHECK(!ec);
+  BOOST_CHECK(!ref);
+  BOOST_CHECK(!ref.is_throwable());
+
+  ref = easy::error_code();
+  BOOST_CHECK(!ec);
+  ref = user_error::empty;
+  BOOST_CHECK(ref.is_error());
+  BOOST_CHECK(ec == user_error::empty);
+
+  // a copy passed down clears the code
+  easy::error_code_ref copy = ref;
+  BOOST_CHECK(!ec);
+
+  easy::error_code_ref throwable;
+  BOOST_CHECK(throwable.is_throwable());
+  throwable = easy::error_code();
+  BOOST_CHECK_THROW(throwable = user_error::invalid, easy::system_error);
+
+  // every generic error has a message
+  for (int e = static_cast<int>(easy::generic_error::null_ptr); e <= static_cast<int>(easy::generic_error::out_of_range); ++e)
+    BOOST_CHECK(!easy::make_error_code(static_cast<easy::generic_error>(e)).message().empty());
+}
+
+BOOST_AUTO_TEST_CASE(Result)
+{
+  auto r = test_result(3);
+  BOOST_REQUIRE(r);
+  BOOST_CHECK(r.has_value());
+  BOOST_CHECK(!r.error());
+  BOOST_CHECK_EQUAL(*r, "xxx");
+  BOOST_CHECK_EQUAL(r->size(), 3);
+  BOOST_CHECK_EQUAL(r.value(), "xxx");
+
+  auto failed = test_result(-1);
+  BOOST_CHECK(!failed);
+  BOOST_CHECK(failed.error() == user_error::invalid);
+  BOOST_CHECK_EQUAL(failed.value_or("none"), "none");
+  BOOST_CHECK_THROW(failed.value(), easy::system_error);
+  BOOST_CHECK(test_result(0).error() == user_error::empty);
+
+  // assignments switch between the value and the error
+  r = failed;
+  BOOST_CHECK(r.error() == user_error::invalid);
+  r = test_result(2);
+  BOOST_CHECK_EQUAL(*r, "xx");
+  failed = r;
+  BOOST_CHECK_EQUAL(*failed, "xx");
+  failed = test_result(-1);
+  BOOST_CHECK(!failed);
+
+  easy::error_code ec;
+  BOOST_CHECK_EQUAL(r.get(ec), "xx");
+  BOOST_CHECK(!ec);
+  BOOST_CHECK(failed.get(ec).empty());
+  BOOST_CHECK(ec == user_error::invalid);
+
+  // the value and the error share the storage
+  BOOST_CHECK(sizeof(easy::result<std::string>) < sizeof(std::string) + sizeof(easy::error_code));
+
+  easy::result<void> done;
+  BOOST_CHECK(done);
+  done.value();
+  easy::result<void> not_done = easy::generic_error::invalid_value;
+  BOOST_CHECK(!not_done);
+  not_done.get(ec);
+  BOOST_CHECK(ec == easy::generic_error::invalid_value);
+  BOOST_CHECK_THROW(not_done.get(), easy::system_error);
+}
+
+#ifdef EASY_NO_EXCEPTIONS
+
+namespace {
+  size_t g_unhandled = 0;
+
+  // the tests are built with exceptions, so raised errors leave the calls as they do without EASY_NO_EXCEPTIONS
+  void throw_unhandled(const easy::error_code& ec) {
+    ++g_unhandled;
+    throw easy::system_error(ec);
+  }
+
+  void drop_unhandled(const easy::error_code&) {
+    ++g_unhandled;
+  }
+
+  struct unhandled_error_fixture
+  {
+    unhandled_error_fixture() {
+      easy::set_unhandled_error_handler(&throw_unhandled);
+    }
+  };
+}
+
+BOOST_GLOBAL_FIXTURE(unhandled_error_fixture);
+
+BOOST_AUTO_TEST_CASE(NoExceptions)
+{
+  // a handler which returns drops the error
+  BOOST_CHECK(easy::set_unhandled_error_handler(&drop_unhandled) == &throw_unhandled);
+  g_unhandled = 0;
+  test_func1();
+  BOOST_CHECK_EQUAL(g_unhandled, 1u);
+  easy::result<void>(easy::generic_error::invalid_value).value();
+  BOOST_CHECK_EQUAL(g_unhandled, 2u);
+
+  easy::error_code ec;
+  test_func1(ec);
+  BOOST_CHECK(ec == user_error::invalid);
+  BOOST_CHECK_EQUAL(g_unhandled, 2u);
+
+  // result<T>::value() has nothing to return, so it does not go on after the handler
+  easy::set_unhandled_error_handler(&throw_unhandled);
+  BOOST_CHECK_THROW(test_result(-1).value(), easy::system_error);
+  BOOST_CHECK_EQUAL(g_unhandled, 3u);
+
+  // nullptr restores the default handler
+  easy::set_unhandled_error_handler(nullptr);
+  BOOST_CHECK(easy::set_unhandled_error_handler(&throw_unhandled) != &throw_unhandled);
+}
+
+#endif
+
+#ifdef EASY_ERROR_TELEMETRY
+
+namespace {
+  size_t g_samples = 0;
+
+  // the way boost functions report errors
+  void set_code(easy::error_code& ec, user_error e) {
+    ec = e;
+  }
+
+  // a layer between the caller and test_func1
+  void forward_func1(easy::error_code_ref ec = nullptr) {
+    easy::error_code local;
+    test_func1(local);
+    if (local)
+      ec.forward(local);
+  }
+
+  void count_sample(const easy::error_code& ec) {
+    ++g_samples;
+    easy::error_code inner;
+    test_func1(inner);   // not sampled again
+  }
+
+  easy::uint64 count_of(const easy::error_snapshot& snapshot, const easy::error_code& ec) {
+    for (auto it = snapshot.counters.begin(); it != snapshot.counters.end(); ++it) {
+      if (it->error() == ec)
+        return it->count;
+    }
+    return 0;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ErrorTelemetry)
+{
+  const easy::error_code invalid = user_error::invalid;
+  const easy::error_code empty = user_error::empty;
+  const easy::error_snapshot before = easy::get_error_snapshot();
+
+  easy::error_code ec;
+  for (int i = 0; i < 10; ++i)
+    test_func1(ec);
+  test_func2(ec);   // no error, not counted
+  set_code(easy::error_code_ref(ec).get(), user_error::empty);
+  BOOST_CHECK_THROW(test_func1(), easy::system_error);
+
+  // the other threads count in their own tables
+  std::thread t([] {
+    easy::error_code ec;
+    for (int i = 0; i < 5; ++i)
+      test_func1(ec);
+  });
+  t.join();
+
+  easy::error_snapshot after = easy::get_error_snapshot();
+  BOOST_CHECK_EQUAL(count_of(after, invalid) - count_of(before, invalid), 16u);
+  BOOST_CHECK_EQUAL(count_of(after, empty) - count_of(before, empty), 1u);
+  BOOST_CHECK_EQUAL(after.untracked, 0u);
+  for (size_t i = 1; i < after.counters.size(); ++i)
+    BOOST_CHECK(after.counters[i - 1].count >= after.counters[i].count);
+
+  easy::set_error_sampler(&count_sample, 4);
+  for (int i = 0; i < 8; ++i)
+    test_func1(ec);
+  easy::set_error_sampler(nullptr);
+  test_func1(ec);
+  BOOST_CHECK_EQUAL(g_samples, 2u);
+  BOOST_CHECK_EQUAL(count_of(easy::get_error_snapshot(), invalid) - count_of(after, invalid), 11u);
+}
+
+BOOST_AUTO_TEST_CASE(ErrorTelemetryForwarded)
+{
+  const easy::error_code invalid = user_error::invalid;
+  const easy::error_snapshot before = easy::get_error_snapshot();
+
+  // every error is counted once however many layers pass it on
+  easy::error_code ec;
+  forward_func1(ec);
+  BOOST_CHECK_THROW(forward_func1(), easy::system_error);
+  easy::result<int> r = user_error::invalid;
+  r.get(ec);
+  easy::result<void>(ec).get(ec);
+  easy::error_snapshot after = easy::get_error_snapshot();
+  BOOST_CHECK_EQUAL(count_of(after, invalid) - count_of(before, invalid), 3u);
+
+  easy::parse<int>("x", ec);
+  BOOST_CHECK(ec);
+  easy::error_snapshot parsed = easy::get_error_snapshot();
+  BOOST_CHECK_EQUAL(count_of(parsed, ec) - count_of(after, ec), 1u);
+
+  easy::utf8_to_utf16("\xC3", ec);
+  BOOST_CHECK(ec);
+  BOOST_CHECK_EQUAL(count_of(easy::get_error_snapshot(), ec) - count_of(parsed, ec), 1u);
+}
+
+#endif
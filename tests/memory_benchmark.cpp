@@ -0,0 +1,127 @@
+/*!
+ *  @file   tests/memory_benchmark.cpp
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  @brief Cost of request scoped allocations with the easy/memory resources.
+ *
+ *  Every simulated request builds a map of small nodes and a few vectors and frees all of them.
+ *  The global heap is compared with an arena released per request, a fixed_pool of the map nodes
+ *  and a thread_cache_resource shared by the threads. The results are printed to stdout as JSON.
+ *
+ *  Build on Linux from the repository root:
+ *
+ *    g++ -std=c++11 -O2 -DNDEBUG -I. tests/memory_benchmark.cpp src/memory/memory_resource.cpp src/memory/arena.cpp src/memory/pool.cpp src/memory/thread_cache.cpp -o memory_benchmark -lpthread
+ *
+ *  Usage: memory_benchmark [requests per thread] [threads]
+ */
+#include <easy/memory.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  typedef std::chrono::steady_clock clock_type;
+  typedef easy::memory::polymorphic_allocator<std::pair<const int, int>> node_allocator;
+  typedef std::map<int, int, std::less<int>, node_allocator> map_type;
+  typedef std::vector<int, easy::memory::polymorphic_allocator<int>> vector_type;
+
+  struct benchmark_result
+  {
+    const char* resource;
+    size_t threads;
+    size_t requests;
+    double seconds;
+  };
+
+  //! One request: 64 map nodes and 8 vectors growing to 32 elements
+  size_t handle_request(easy::memory::memory_resource* pnodes, easy::memory::memory_resource* pvectors)
+  {
+    map_type headers((std::less<int>()), node_allocator(pnodes));
+    for (int i = 0; i < 64; ++i)
+      headers[i * 7] = i;
+
+    size_t sum = headers.size();
+    for (int v = 0; v < 8; ++v) {
+      vector_type values((easy::memory::polymorphic_allocator<int>(pvectors)));
+      for (int i = 0; i < 32; ++i)
+        values.push_back(i);
+      sum += values.size();
+    }
+    return sum;
+  }
+
+  template<class Thread>
+  benchmark_result run(const char* resource, size_t threads, size_t requests, Thread thread)
+  {
+    const clock_type::time_point start = clock_type::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+      workers.push_back(std::thread(thread));
+    for (size_t t = 0; t < threads; ++t)
+      workers[t].join();
+
+    benchmark_result r;
+    r.resource = resource;
+    r.threads = threads;
+    r.requests = requests * threads;
+    r.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    return r;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  using namespace easy::memory;
+
+  const size_t requests = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 100000;
+  const size_t thread_count = argc > 2 ? static_cast<size_t>(std::max(1, std::atoi(argv[2]))) : 4;
+
+  std::vector<benchmark_result> results;
+  for (size_t threads = 1; threads <= thread_count; threads *= thread_count > 1 ? thread_count : 2) {
+    results.push_back(run("new_delete", threads, requests, [=]() {
+      volatile size_t sink = 0;
+      for (size_t i = 0; i < requests; ++i)
+        sink += handle_request(new_delete_resource(), new_delete_resource());
+    }));
+
+    results.push_back(run("arena", threads, requests, [=]() {
+      volatile size_t sink = 0;
+      arena request;
+      for (size_t i = 0; i < requests; ++i) {
+        sink += handle_request(&request, &request);
+        request.release();
+      }
+    }));
+
+    results.push_back(run("fixed_pool", threads, requests, [=]() {
+      volatile size_t sink = 0;
+      fixed_pool nodes(sizeof(std::pair<const int, int>) + 4 * sizeof(void*));
+      for (size_t i = 0; i < requests; ++i)
+        sink += handle_request(&nodes, new_delete_resource());
+    }));
+
+    thread_cache_resource shared;
+    results.push_back(run("thread_cache", threads, requests, [=, &shared]() {
+      volatile size_t sink = 0;
+      for (size_t i = 0; i < requests; ++i)
+        sink += handle_request(&shared, &shared);
+    }));
+  }
+
+  std::printf("{\n  \"results\": [\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const benchmark_result& r = results[i];
+    std::printf("    {\"resource\": \"%s\", \"threads\": %u, \"requests\": %u, \"seconds\": %.6f, \"requests_per_second\": %.0f}%s\n",
+      r.resource, static_cast<unsigned>(r.threads), static_cast<unsigned>(r.requests), r.seconds,
+      r.seconds > 0 ? r.requests / r.seconds : 0.0, i + 1 < results.size() ? "," : "");
+  }
+  std::printf("  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,245 @@
+#include "include.h"
+
+#include <easy/memory.h>
+#include <easy/range.h>
+#include <easy/strings.h>
+
+#include <cstring>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  //! Upstream resource counting the memory it hands out
+  class counting_resource
+    : public easy::memory::memory_resource
+  {
+  public:
+    counting_resource()
+      : allocations(0), deallocations(0), bytes(0) {
+    }
+
+    size_t allocations;
+    size_t deallocations;
+    size_t bytes;
+
+  protected:
+    virtual void* do_allocate(size_t size, size_t alignment) EASY_OVERRIDE {
+      ++allocations;
+      bytes += size;
+      return easy::memory::new_delete_resource()->allocate(size, alignment);
+    }
+
+    virtual void do_deallocate(void* p, size_t size, size_t alignment) EASY_OVERRIDE {
+      ++deallocations;
+      bytes -= size;
+      easy::memory::new_delete_resource()->deallocate(p, size, alignment);
+    }
+  };
+
+  bool is_aligned(void* p, size_t alignment) {
+    return reinterpret_cast<size_t>(p) % alignment == 0;
+  }
+
+  class counter_enumerator
+    : public easy::enumerator<int>
+  {
+  public:
+    explicit counter_enumerator(int count)
+      : m_count(count), m_next(0) {
+    }
+
+    virtual result_type get_next(easy::error_code_ref ec = nullptr) EASY_OVERRIDE {
+      ec = easy::error_code();
+      return m_next < m_count ? result_type(m_next++) : result_type();
+    }
+
+  private:
+    int m_count;
+    int m_next;
+  };
+}
+
+BOOST_AUTO_TEST_CASE(MemoryArena)
+{
+  using namespace easy::memory;
+
+  counting_resource upstream;
+  {
+    arena a(1024, 4096, &upstream);
+    void* p1 = a.allocate(10, 1);
+    void* p2 = a.allocate(24, 8);
+    BOOST_CHECK(is_aligned(p2, 8));
+    BOOST_CHECK(static_cast<char*>(p2) >= static_cast<char*>(p1) + 10);
+    BOOST_CHECK_EQUAL(upstream.allocations, 1u);
+    BOOST_CHECK(is_aligned(a.allocate(100, 64), 64));
+
+    // a big allocation gets its own chunk and the small ones continue in the current chunk
+    char* pbig = static_cast<char*>(a.allocate(2000));
+    char* psmall = static_cast<char*>(a.allocate(8));
+    BOOST_CHECK_EQUAL(upstream.allocations, 2u);
+    BOOST_CHECK(psmall < pbig || psmall > pbig + 2000);
+
+    // chunk sizes grow up to the maximum
+    for (int i = 0; i < 100; ++i)
+      a.allocate(200);
+    BOOST_CHECK_EQUAL(a.used_bytes(), 10u + 24 + 100 + 2000 + 8 + 100 * 200);
+    BOOST_CHECK_EQUAL(a.reserved_bytes(), upstream.bytes);
+    BOOST_CHECK(upstream.allocations < 12u);
+
+    a.release();
+    BOOST_CHECK_EQUAL(upstream.bytes, 0u);
+    BOOST_CHECK_EQUAL(a.used_bytes(), 0u);
+    a.allocate(10);
+  }
+  BOOST_CHECK_EQUAL(upstream.bytes, 0u);
+  BOOST_CHECK_EQUAL(upstream.allocations, upstream.deallocations);
+
+  // the initial buffer is used before any chunk
+  char buffer[256];
+  {
+    arena a(buffer, sizeof(buffer), &upstream);
+    char* p = static_cast<char*>(a.allocate(100));
+    BOOST_CHECK(p >= buffer && p < buffer + sizeof(buffer));
+    BOOST_CHECK_EQUAL(upstream.allocations, upstream.deallocations);
+    a.allocate(200);
+    BOOST_CHECK_EQUAL(upstream.allocations, upstream.deallocations + 1);
+    a.release();
+    p = static_cast<char*>(a.allocate(100));
+    BOOST_CHECK(p >= buffer && p < buffer + sizeof(buffer));
+  }
+  BOOST_CHECK_EQUAL(upstream.bytes, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(MemoryFixedPool)
+{
+  using namespace easy::memory;
+
+  counting_resource upstream;
+  {
+    fixed_pool pool(20, 4, &upstream);
+    BOOST_CHECK_EQUAL(pool.block_size() % max_align, 0u);
+    BOOST_CHECK(pool.block_size() >= 20u);
+
+    std::set<void*> blocks;
+    for (int i = 0; i < 6; ++i) {
+      void* p = pool.allocate(20);
+      BOOST_CHECK(is_aligned(p, max_align));
+      blocks.insert(p);
+    }
+    BOOST_CHECK_EQUAL(blocks.size(), 6u);
+    BOOST_CHECK_EQUAL(pool.used_blocks(), 6u);
+    BOOST_CHECK_EQUAL(upstream.allocations, 2u);
+
+    // freed blocks are reused
+    void* p = *blocks.begin();
+    pool.deallocate(p, 20);
+    BOOST_CHECK(pool.allocate(16) == p);
+
+    // bigger allocations go upstream
+    void* pbig = pool.allocate(100);
+    BOOST_CHECK_EQUAL(upstream.allocations, 3u);
+    pool.deallocate(pbig, 100);
+    BOOST_CHECK_EQUAL(upstream.deallocations, 1u);
+
+  }
+  BOOST_CHECK_EQUAL(upstream.bytes, 0u);
+
+  // node based containers
+  {
+    fixed_pool nodes(64, 16, &upstream);
+    std::map<int, int, std::less<int>, polymorphic_allocator<std::pair<const int, int>>> map(std::less<int>(), &nodes);
+    for (int i = 0; i < 100; ++i)
+      map[i] = i;
+    BOOST_CHECK_EQUAL(nodes.used_blocks(), 100u);
+    map.clear();
+    BOOST_CHECK_EQUAL(nodes.used_blocks(), 0u);
+  }
+  BOOST_CHECK_EQUAL(upstream.bytes, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(MemoryThreadCache)
+{
+  using namespace easy::memory;
+
+  counting_resource upstream;
+  {
+    thread_cache_resource resource(&upstream);
+
+    void* p = resource.allocate(24);
+    BOOST_CHECK(is_aligned(p, max_align));
+    resource.deallocate(p, 24);
+    BOOST_CHECK(resource.allocate(32) == p);
+    resource.deallocate(p, 32);
+
+    void* pbig = resource.allocate(4096);
+    resource.deallocate(pbig, 4096);
+
+    // blocks allocated by one thread are freed by another
+    const size_t count = 20000;
+    std::vector<void*> blocks(count);
+    std::thread producer([&]() {
+      for (size_t i = 0; i < count; ++i) {
+        blocks[i] = resource.allocate(16 << (i % 7));
+        std::memset(blocks[i], 0x5a, 16);
+      }
+    });
+    producer.join();
+    BOOST_CHECK_EQUAL(std::set<void*>(blocks.begin(), blocks.end()).size(), count);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+      threads.push_back(std::thread([&, t]() {
+        for (size_t i = t; i < count; i += 4)
+          resource.deallocate(blocks[i], 16 << (i % 7));
+        std::vector<int, polymorphic_allocator<int>> v(&resource);
+        for (int i = 0; i < 200; ++i)
+          v.push_back(i);
+      }));
+    }
+    for (size_t t = 0; t < threads.size(); ++t)
+      threads[t].join();
+  }
+  BOOST_CHECK_EQUAL(upstream.bytes, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(MemoryRequestScope)
+{
+  using namespace easy;
+
+  memory::arena request;
+
+  // strings copied to the arena are freed with it
+  const lite_string name(lite_string("x-request-id"), request);
+  BOOST_CHECK_EQUAL(name, "x-request-id");
+  BOOST_CHECK(!name.is_owner());
+  BOOST_CHECK_EQUAL(name.c_str()[name.size()], '\0');
+  BOOST_CHECK(!lite_string(lite_string(), request));
+
+  std::vector<int, memory::polymorphic_allocator<int>> values(&request);
+  values.push_back(1);
+  BOOST_CHECK(values.get_allocator().resource() == &request);
+
+  // the range bookkeeping is allocated from the arena
+  counting_resource upstream;
+  {
+    memory::arena scope(1024, 1024, &upstream);
+    int sum = 0;
+    for (int v : make_range(std::unique_ptr<enumerator<int>>(new counter_enumerator(5)), scope))
+      sum += v;
+    BOOST_CHECK_EQUAL(sum, 10);
+    BOOST_CHECK(scope.used_bytes() > 0);
+    BOOST_CHECK_EQUAL(upstream.allocations, 1u);
+  }
+  BOOST_CHECK_EQUAL(upstream.bytes, 0u);
+
+  // string pools take their memory from a resource
+  {
+    easy::string_pool pool(1024, &upstream);
+    pool.intern("column");
+    BOOST_CHECK(upstream.allocations > 1u);
+  }
+  BOOST_CHECK_EQUAL(upstream.bytes, 0u);
+}
@@ -0,0 +1,318 @@
+#include "include.h"
+
+#include <easy/range.h>
+#include <easy/range_adaptors.h>
+#include <easy/parallel_range.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  //! Counts the enumeration calls, returning one value per call
+  class single_enumerator
+    : public easy::enumerator<int>
+  {
+  public:
+    single_enumerator(int count, size_t& calls)
+      : m_next(0), m_count(count), m_calls(calls) {
+    }
+
+    virtual result_type get_next(easy::error_code_ref ec = nullptr) EASY_OVERRIDE {
+      ++m_calls;
+      if (m_next == m_count)
+        return result_type();
+      return m_next++;
+    }
+
+  private:
+    int m_next;
+    int m_count;
+    size_t& m_calls;
+  };
+
+  //! Returns strings read ahead in batches, failing at the given value
+  class string_enumerator
+    : public easy::batch_enumerator<string_enumerator, std::string>
+  {
+  public:
+    string_enumerator(int count, size_t& calls, int fail_at = -1)
+      : m_next(0), m_count(count), m_fail_at(fail_at), m_calls(calls) {
+    }
+
+    virtual size_t get_next_batch(result_type* pvalues, size_t count, easy::error_code_ref ec = nullptr) EASY_OVERRIDE {
+      ++m_calls;
+      return batch_enumerator::get_next_batch(pvalues, count, ec);
+    }
+
+    virtual result_type get_next(easy::error_code_ref ec = nullptr) EASY_OVERRIDE {
+      if (m_next == m_fail_at) {
+        ec = easy::generic_error::invalid_value;
+        return result_type();
+      }
+      if (m_next == m_count)
+        return result_type();
+      return std::to_string(m_next++);
+    }
+
+  private:
+    int m_next;
+    int m_count;
+    int m_fail_at;
+    size_t& m_calls;
+  };
+
+  std::unique_ptr<easy::enumerator<std::string>> make_strings(int count, size_t& calls, int fail_at = -1)
+  {
+    return std::unique_ptr<easy::enumerator<std::string>>(new string_enumerator(count, calls, fail_at));
+  }
+
+  std::unique_ptr<easy::enumerator<int>> make_ints(int count, size_t& calls)
+  {
+    return std::unique_ptr<easy::enumerator<int>>(new single_enumerator(count, calls));
+  }
+
+  template<class Value>
+  std::vector<Value> collect(std::unique_ptr<easy::enumerator<Value>> && enum_ptr, easy::error_code_ref ec = nullptr)
+  {
+    std::vector<Value> values;
+    for (const auto& v : easy::make_range(std::move(enum_ptr), ec))
+      values.push_back(v);
+    return values;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RangeSingleValues)
+{
+  using namespace easy;
+
+  size_t calls = 0;
+  std::vector<int> values;
+  for (int v : make_range(std::unique_ptr<enumerator<int>>(new single_enumerator(40, calls))))
+    values.push_back(v);
+
+  BOOST_REQUIRE_EQUAL(values.size(), 40);
+  for (int i = 0; i < 40; ++i)
+    BOOST_CHECK_EQUAL(values[i], i);
+  BOOST_CHECK_EQUAL(calls, 41);
+
+  calls = 0;
+  auto r = make_range(std::unique_ptr<enumerator<int>>(new single_enumerator(0, calls)));
+  BOOST_CHECK(r.begin() == r.end());
+}
+
+BOOST_AUTO_TEST_CASE(RangeBatches)
+{
+  using namespace easy;
+
+  // 40 values take three batches of 16 and the end is one more call
+  size_t calls = 0;
+  std::vector<std::string> values;
+  for (const auto& s : make_range(make_strings(40, calls)))
+    values.push_back(s);
+
+  BOOST_REQUIRE_EQUAL(values.size(), 40);
+  for (int i = 0; i < 40; ++i)
+    BOOST_CHECK_EQUAL(values[i], std::to_string(i));
+  BOOST_CHECK_EQUAL(calls, 4);
+
+  // a full last batch is followed by an empty one
+  calls = 0;
+  size_t count = 0;
+  for (const auto& s : make_range(make_strings(32, calls)))
+    count += s.empty() ? 0 : 1;
+  BOOST_CHECK_EQUAL(count, 32);
+  BOOST_CHECK_EQUAL(calls, 3);
+
+  // copies of an iterator share the position
+  calls = 0;
+  auto r = make_range(make_strings(20, calls));
+  auto it = r.begin();
+  auto copy = it;
+  BOOST_CHECK_EQUAL(*it, "0");
+  ++it;
+  BOOST_CHECK(it == copy);
+  BOOST_CHECK_EQUAL(*copy, "1");
+  for (int i = 1; i < 20; ++i, ++it)
+    BOOST_CHECK_EQUAL(*it, std::to_string(i));
+  BOOST_CHECK(it == r.end());
+
+  // breaking out of the loop reads no more than the current batch
+  calls = 0;
+  for (const auto& s : make_range(make_strings(1000, calls))) {
+    if (s == "3")
+      break;
+  }
+  BOOST_CHECK_EQUAL(calls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(RangeBatchErrors)
+{
+  using namespace easy;
+
+  // the values read before the error come first, the next call reports it
+  size_t calls = 0;
+  error_code ec;
+  enumerator<std::string>::result_type values[16];
+  auto failing = make_strings(10, calls, 5);
+  BOOST_REQUIRE_EQUAL(failing->get_next_batch(values, 16, ec), 5u);
+  BOOST_CHECK(!ec);
+  BOOST_CHECK_EQUAL(*values[4], "4");
+  BOOST_CHECK_EQUAL(failing->get_next_batch(values, 16, ec), 0u);
+  BOOST_CHECK_EQUAL(ec, make_error_code(generic_error::invalid_value));
+  BOOST_CHECK_EQUAL(make_strings(10, calls, 5)->get_next_batch(values, 16), 5u);
+
+  ec.clear();
+  auto r = make_range(make_strings(10, calls, 0), ec);
+  BOOST_CHECK_EQUAL(ec, make_error_code(generic_error::invalid_value));
+  BOOST_CHECK(r.begin() == r.end());
+
+  ec.clear();
+  auto empty = make_range(make_strings(0, calls), ec);
+  BOOST_CHECK(!ec);
+  BOOST_CHECK(empty.begin() == empty.end());
+
+  BOOST_CHECK_THROW(make_range(make_strings(10, calls, 0)), boost::system::system_error);
+}
+
+BOOST_AUTO_TEST_CASE(RangeAdaptors)
+{
+  using namespace easy;
+
+  size_t calls = 0;
+  const auto even = collect(filter(make_ints(10, calls), [](int v) { return v % 2 == 0; }));
+  BOOST_REQUIRE_EQUAL(even.size(), 5);
+  BOOST_CHECK_EQUAL(even[4], 8);
+
+  const auto squares = collect(transform(make_ints(4, calls), [](int v) { return std::to_string(v * v); }));
+  BOOST_REQUIRE_EQUAL(squares.size(), 4);
+  BOOST_CHECK_EQUAL(squares[3], "9");
+
+  // take does not read the source after its last value
+  calls = 0;
+  const auto first = collect(take(make_ints(100, calls), 3));
+  BOOST_REQUIRE_EQUAL(first.size(), 3);
+  BOOST_CHECK_EQUAL(first[2], 2);
+  BOOST_CHECK_EQUAL(calls, 3);
+  BOOST_CHECK(collect(take(make_ints(100, calls), 0)).empty());
+
+  const auto rest = collect(skip(make_ints(5, calls), 3));
+  BOOST_REQUIRE_EQUAL(rest.size(), 2);
+  BOOST_CHECK_EQUAL(rest[0], 3);
+  BOOST_CHECK(collect(skip(make_ints(5, calls), 10)).empty());
+
+  const auto chunks = collect(chunk(make_ints(7, calls), 3));
+  BOOST_REQUIRE_EQUAL(chunks.size(), 3);
+  BOOST_CHECK_EQUAL(chunks[0].size(), 3);
+  BOOST_CHECK_EQUAL(chunks[1][0], 3);
+  BOOST_REQUIRE_EQUAL(chunks[2].size(), 1);
+  BOOST_CHECK_EQUAL(chunks[2][0], 6);
+  BOOST_CHECK(collect(chunk(make_ints(0, calls), 3)).empty());
+
+  const auto both = collect(concat(make_ints(2, calls), make_ints(3, calls)));
+  BOOST_REQUIRE_EQUAL(both.size(), 5);
+  BOOST_CHECK_EQUAL(both[1], 1);
+  BOOST_CHECK_EQUAL(both[2], 0);
+
+  const auto pairs = collect(zip(make_ints(5, calls), make_strings(3, calls)));
+  BOOST_REQUIRE_EQUAL(pairs.size(), 3);
+  BOOST_CHECK_EQUAL(pairs[2].first, 2);
+  BOOST_CHECK_EQUAL(pairs[2].second, "2");
+}
+
+BOOST_AUTO_TEST_CASE(RangeAdaptorPipelines)
+{
+  using namespace easy;
+
+  // the adaptors keep the batches of the source
+  size_t calls = 0;
+  auto pipeline = transform(
+    take(skip(filter(make_strings(1000, calls), [](const std::string& s) { return s.size() == 3; }), 50), 100),
+    [](std::string&& s) { return s + "!"; });
+  const auto values = collect(std::move(pipeline));
+  BOOST_REQUIRE_EQUAL(values.size(), 100);
+  BOOST_CHECK_EQUAL(values.front(), "150!");
+  BOOST_CHECK_EQUAL(values.back(), "249!");
+  BOOST_CHECK(calls < 30);
+
+  // source errors pass through every adaptor
+  error_code ec;
+  auto failing = chunk(transform(filter(make_strings(100, calls, 40), [](const std::string&) { return true; }),
+    [](const std::string& s) { return s.size(); }), 8);
+  size_t chunks = 0;
+  while (failing->get_next(ec))
+    ++chunks;
+  BOOST_CHECK_EQUAL(chunks, 5u);
+  BOOST_CHECK_EQUAL(ec, make_error_code(generic_error::invalid_value));
+
+  auto joined = concat(make_strings(1, calls), make_strings(3, calls, 1));
+  BOOST_CHECK_EQUAL(*joined->get_next(ec), "0");
+  BOOST_CHECK_EQUAL(*joined->get_next(ec), "0");
+  BOOST_CHECK(!joined->get_next(ec));
+  BOOST_CHECK_EQUAL(ec, make_error_code(generic_error::invalid_value));
+}
+
+BOOST_AUTO_TEST_CASE(RangePrefetch)
+{
+  using namespace easy;
+
+  // a ring smaller than a batch wraps around many times
+  size_t calls = 0;
+  const auto values = collect(prefetch(make_strings(1000, calls), 5));
+  BOOST_REQUIRE_EQUAL(values.size(), 1000);
+  for (int i = 0; i < 1000; ++i)
+    BOOST_CHECK_EQUAL(values[i], std::to_string(i));
+
+  const auto ints = collect(prefetch(make_ints(300, calls)));
+  BOOST_REQUIRE_EQUAL(ints.size(), 300);
+  BOOST_CHECK_EQUAL(ints[299], 299);
+  BOOST_CHECK(collect(prefetch(make_ints(0, calls))).empty());
+
+  // the batches read before the error come first
+  error_code ec;
+  auto failing = prefetch(make_strings(100, calls, 40), 8);
+  int count = 0;
+  while (failing->get_next(ec))
+    ++count;
+  BOOST_CHECK_EQUAL(count, 40);
+  BOOST_CHECK_EQUAL(ec, make_error_code(generic_error::invalid_value));
+
+  // destroying the enumerator stops the thread waiting for space
+  {
+    auto r = make_range(prefetch(make_strings(100000, calls), 4));
+    BOOST_CHECK_EQUAL(*r.begin(), "0");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RangeParallelForEach)
+{
+  using namespace easy;
+
+  size_t calls = 0;
+  std::mutex mutex;
+  std::set<std::string> seen;
+  std::atomic<size_t> total(0);
+  parallel_for_each(prefetch(make_strings(2000, calls)), [&](std::string& s) {
+    total += s.size();
+    std::lock_guard<std::mutex> lock(mutex);
+    seen.insert(std::move(s));
+  }, 4);
+  BOOST_CHECK_EQUAL(seen.size(), 2000);
+  BOOST_CHECK_EQUAL(total.load(), 10 + 90 * 2 + 900 * 3 + 1000 * 4);
+
+  error_code ec;
+  std::atomic<int> processed(0);
+  parallel_for_each(make_strings(100, calls, 40), [&](std::string&) { ++processed; }, 3, ec);
+  BOOST_CHECK_EQUAL(ec, make_error_code(generic_error::invalid_value));
+  BOOST_CHECK_EQUAL(processed.load(), 40);
+
+  BOOST_CHECK_THROW(parallel_for_each(make_ints(1000, calls), [](int& v) {
+    if (v == 10)
+      throw std::runtime_error("failed");
+  }, 3), std::runtime_error);
+}
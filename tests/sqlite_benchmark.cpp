@@ -0,0 +1,363 @@
+/*!
+ *  @file   tests/sqlite_benchmark.cpp
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  @brief Throughput of the easy::db::sqlite wrapper against raw sqlite3 calls.
+ *
+ *  Every workload runs over a fresh temporary database per API and the results are
+ *  printed to stdout as JSON, so the wrapper overhead can be compared across releases.
+ *  The benchmark is a standalone executable, it is not a part of the unit test module.
+ *
+ *  Build on Linux from the repository root:
+ *
+ *    g++ -std=c++11 -O2 -DNDEBUG -I. tests/sqlite_benchmark.cpp src/error_handling.cpp \
+ *        src/db/sqlite/sqlite.cpp src/db/sqlite/bulk_inserter.cpp src/db/sqlite/async_executor.cpp \
+ *        src/db/sqlite/connection_pool.cpp src/db/sqlite/checkpoint_scheduler.cpp \
+ *        -lsqlite3 -lboost_filesystem -lboost_system -lpthread -o sqlite_benchmark
+ *
+ *  Usage: sqlite_benchmark [rows] [operations]
+ */
+#include <easy/db/sqlite/sqlite.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  typedef std::chrono::steady_clock clock_type;
+
+  const int range_scan_length = 100;
+
+  struct benchmark_config
+  {
+    benchmark_config()
+      : rows(100000)
+      , operations(100000) {
+    }
+
+    int rows;       //!< Rows inserted by the bulk insert
+    int operations; //!< Lookups, scans and updates per run
+  };
+
+  struct benchmark_result
+  {
+    std::string workload;
+    std::string api;
+    uint64 operations;
+    double seconds;
+  };
+
+  //! Temporary database file removed with its WAL files on destruction
+  class temp_database_file
+    : boost::noncopyable
+  {
+  public:
+    temp_database_file()
+      : m_path((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("easy-bench-%%%%-%%%%.db")).string()) {
+    }
+
+    ~temp_database_file() {
+      boost::system::error_code ec;
+      boost::filesystem::remove(m_path, ec);
+      boost::filesystem::remove(m_path + "-wal", ec);
+      boost::filesystem::remove(m_path + "-shm", ec);
+    }
+
+    const std::string& path() const {
+      return m_path;
+    }
+  private:
+    std::string m_path;
+  };
+
+  std::string make_name(int id)
+  {
+    return "name-" + std::to_string(id);
+  }
+
+  //! Random ids, the same sequence for both APIs
+  std::vector<int> make_ids(const benchmark_config& config, int upper)
+  {
+    std::mt19937 gen(20130501);
+    std::uniform_int_distribution<int> dist(1, std::max(1, upper));
+    std::vector<int> ids(config.operations);
+    for (auto it = ids.begin(); it != ids.end(); ++it)
+      *it = dist(gen);
+    return ids;
+  }
+
+  double measure(const std::function<void()>& fn)
+  {
+    const clock_type::time_point start = clock_type::now();
+    fn();
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+  }
+
+  void check_raw(int res, int expected, ::sqlite3* db)
+  {
+    if (res != expected)
+      throw std::runtime_error(::sqlite3_errmsg(db));
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+  // raw sqlite3
+
+  class raw_benchmark
+    : boost::noncopyable
+  {
+  public:
+    explicit raw_benchmark(const std::string& path)
+      : m_db(nullptr)
+    {
+      check_raw(::sqlite3_open_v2(path.c_str(), &m_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nullptr), SQLITE_OK, m_db);
+      exec("PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;"
+        "create table t (_id integer primary key, name text not null, value integer not null)");
+    }
+
+    ~raw_benchmark() {
+      ::sqlite3_close_v2(m_db);
+    }
+
+    void bulk_insert(int rows) {
+      ::sqlite3_stmt* stmt = prepare("insert into t values (?, ?, ?)");
+      exec("BEGIN");
+      for (int id = 1; id <= rows; ++id) {
+        const std::string name = make_name(id);
+        ::sqlite3_bind_int(stmt, 1, id);
+        ::sqlite3_bind_text(stmt, 2, name.c_str(), static_cast<int>(name.length()), SQLITE_TRANSIENT);
+        ::sqlite3_bind_int(stmt, 3, id);
+        check_raw(::sqlite3_step(stmt), SQLITE_DONE, m_db);
+        ::sqlite3_reset(stmt);
+        if (id % sqlite::bulk_inserter::default_batch_size == 0)
+          exec("COMMIT; BEGIN");
+      }
+      exec("COMMIT");
+      ::sqlite3_finalize(stmt);
+    }
+
+    uint64 point_lookup(const std::vector<int>& ids) {
+      ::sqlite3_stmt* stmt = prepare("select name, value from t where _id = ?");
+      uint64 length = 0;
+      for (auto it = ids.begin(); it != ids.end(); ++it) {
+        ::sqlite3_bind_int(stmt, 1, *it);
+        if (::sqlite3_step(stmt) == SQLITE_ROW) {
+          ::sqlite3_column_text(stmt, 0);
+          length += ::sqlite3_column_bytes(stmt, 0) + ::sqlite3_column_int(stmt, 1);
+        }
+        ::sqlite3_reset(stmt);
+      }
+      ::sqlite3_finalize(stmt);
+      return length;
+    }
+
+    uint64 range_scan(const std::vector<int>& ids) {
+      ::sqlite3_stmt* stmt = prepare("select _id, name, value from t where _id between ? and ?");
+      uint64 length = 0;
+      for (auto it = ids.begin(); it != ids.end(); ++it) {
+        ::sqlite3_bind_int(stmt, 1, *it);
+        ::sqlite3_bind_int(stmt, 2, *it + range_scan_length - 1);
+        while (::sqlite3_step(stmt) == SQLITE_ROW) {
+          ::sqlite3_column_text(stmt, 1);
+          length += ::sqlite3_column_int64(stmt, 0) + ::sqlite3_column_bytes(stmt, 1) + ::sqlite3_column_int(stmt, 2);
+        }
+        ::sqlite3_reset(stmt);
+      }
+      ::sqlite3_finalize(stmt);
+      return length;
+    }
+
+    void update(const std::vector<int>& ids) {
+      ::sqlite3_stmt* stmt = prepare("update t set value = value + 1 where _id = ?");
+      exec("BEGIN");
+      for (auto it = ids.begin(); it != ids.end(); ++it) {
+        ::sqlite3_bind_int(stmt, 1, *it);
+        check_raw(::sqlite3_step(stmt), SQLITE_DONE, m_db);
+        ::sqlite3_reset(stmt);
+      }
+      exec("COMMIT");
+      ::sqlite3_finalize(stmt);
+    }
+
+  private:
+    void exec(const char* sql) {
+      check_raw(::sqlite3_exec(m_db, sql, nullptr, nullptr, nullptr), SQLITE_OK, m_db);
+    }
+
+    ::sqlite3_stmt* prepare(const char* sql) {
+      ::sqlite3_stmt* stmt = nullptr;
+      check_raw(::sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr), SQLITE_OK, m_db);
+      return stmt;
+    }
+  private:
+    ::sqlite3* m_db;
+  };
+
+  //////////////////////////////////////////////////////////////////////////
+  // easy::db::sqlite
+
+  class easy_benchmark
+    : boost::noncopyable
+  {
+  public:
+    explicit easy_benchmark(const std::string& path)
+    {
+      sqlite::database_options options;
+      options.journal = sqlite::journal_mode::wal;
+      options.synchronous = sqlite::synchronous_mode::normal;
+      m_db = sqlite::database(path, sqlite::open_flag::read_write | sqlite::open_flag::create | sqlite::open_flag::nomutex, options);
+      m_db.execute("create table t (_id integer primary key, name text not null, value integer not null)");
+    }
+
+    void bulk_insert(int rows) {
+      sqlite::bulk_inserter inserter(m_db, "insert into t values (?, ?, ?)");
+      for (int id = 1; id <= rows; ++id)
+        inserter.insert(std::make_tuple(id, make_name(id), id));
+      inserter.flush();
+    }
+
+    uint64 point_lookup(const std::vector<int>& ids) {
+      sqlite::statement st(m_db, "select name, value from t where _id = ?");
+      uint64 length = 0;
+      for (auto it = ids.begin(); it != ids.end(); ++it) {
+        st.bind(*it);
+        if (st.next())
+          length += st.get<lite_string>(0).length() + st.get<int>(1);
+        st.reset();
+      }
+      return length;
+    }
+
+    uint64 range_scan(const std::vector<int>& ids) {
+      sqlite::statement st(m_db, "select _id, name, value from t where _id between ? and ?");
+      uint64 length = 0;
+      for (auto it = ids.begin(); it != ids.end(); ++it) {
+        st.bind(*it, *it + range_scan_length - 1);
+        for (auto& row : make_range(st.rows<int64, lite_string, int>()))
+          length += std::get<0>(row) + std::get<1>(row).length() + std::get<2>(row);
+        st.reset();
+      }
+      return length;
+    }
+
+    void update(const std::vector<int>& ids) {
+      sqlite::statement st(m_db, "update t set value = value + 1 where _id = ?");
+      m_db.execute("BEGIN");
+      for (auto it = ids.begin(); it != ids.end(); ++it) {
+        st.bind(*it);
+        st.next();
+        st.reset();
+      }
+      m_db.execute("COMMIT");
+    }
+
+  private:
+    sqlite::database m_db;
+  };
+
+  //////////////////////////////////////////////////////////////////////////
+
+  template<class Benchmark>
+  void run(const char* api, const benchmark_config& config, std::vector<benchmark_result>& results)
+  {
+    temp_database_file file;
+    Benchmark bench(file.path());
+
+    const std::vector<int> lookup_ids = make_ids(config, config.rows);
+    const std::vector<int> scan_ids = make_ids(config, config.rows - range_scan_length + 1);
+    const int scans = std::max(1, config.operations / range_scan_length);
+    const std::vector<int> scan_starts(scan_ids.begin(), scan_ids.begin() + std::min<size_t>(scans, scan_ids.size()));
+
+    volatile uint64 sink = 0; // keeps the reads from being optimized out
+    benchmark_result r;
+    r.api = api;
+
+    r.workload = "bulk_insert";
+    r.operations = config.rows;
+    r.seconds = measure([&]() { bench.bulk_insert(config.rows); });
+    results.push_back(r);
+
+    r.workload = "point_lookup";
+    r.operations = lookup_ids.size();
+    r.seconds = measure([&]() { sink += bench.point_lookup(lookup_ids); });
+    results.push_back(r);
+
+    r.workload = "range_scan";
+    r.operations = scan_starts.size() * range_scan_length;
+    r.seconds = measure([&]() { sink += bench.range_scan(scan_starts); });
+    results.push_back(r);
+
+    r.workload = "update";
+    r.operations = lookup_ids.size();
+    r.seconds = measure([&]() { bench.update(lookup_ids); });
+    results.push_back(r);
+  }
+
+  const benchmark_result* find_result(const std::vector<benchmark_result>& results, const std::string& workload, const char* api)
+  {
+    for (auto it = results.begin(); it != results.end(); ++it) {
+      if (it->workload == workload && it->api == api)
+        return &*it;
+    }
+    return nullptr;
+  }
+
+  void print_json(const benchmark_config& config, const std::vector<benchmark_result>& results)
+  {
+    std::printf("{\n");
+    std::printf("  \"sqlite_version\": \"%s\",\n", ::sqlite3_libversion());
+    std::printf("  \"rows\": %d,\n", config.rows);
+    std::printf("  \"operations\": %d,\n", config.operations);
+    std::printf("  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+      const benchmark_result& r = results[i];
+      std::printf("    {\"workload\": \"%s\", \"api\": \"%s\", \"operations\": %llu, \"seconds\": %.6f, \"ops_per_second\": %.1f}%s\n",
+        r.workload.c_str(), r.api.c_str(), static_cast<unsigned long long>(r.operations), r.seconds,
+        r.seconds > 0 ? r.operations / r.seconds : 0.0, i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ],\n");
+
+    // time of the wrapper relative to the raw calls, 1.0 means no overhead
+    std::printf("  \"overhead\": {");
+    const char* workloads[] = { "bulk_insert", "point_lookup", "range_scan", "update" };
+    for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); ++i) {
+      const benchmark_result* raw = find_result(results, workloads[i], "raw");
+      const benchmark_result* wrapped = find_result(results, workloads[i], "easy");
+      const double ratio = raw && wrapped && raw->seconds > 0 ? wrapped->seconds / raw->seconds : 0.0;
+      std::printf("%s\"%s\": %.3f", i ? ", " : "", workloads[i], ratio);
+    }
+    std::printf("}\n}\n");
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  benchmark_config config;
+  if (argc > 1)
+    config.rows = std::max(range_scan_length, std::atoi(argv[1]));
+  if (argc > 2)
+    config.operations = std::max(1, std::atoi(argv[2]));
+
+  try {
+    std::vector<benchmark_result> results;
+    run<raw_benchmark>("raw", config, results);
+    run<easy_benchmark>("easy", config, results);
+    print_json(config, results);
+  }
+  catch (const std::exception& e) {
+    std::fprintf(stderr, "benchmark failed: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -1,5 +1,14 @@
 #include "include.h"
 #include <easy/db/sqlite/sqlite.h>
+#include <easy/scope.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
 
 
 BOOST_AUTO_TEST_CASE(SQLite)
@@ -20,3 +29,450 @@ BOOST_AUTO_TEST_CASE(SQLite)
   //BOOST_CHECK(!ec);
 
 }
+
+BOOST_AUTO_TEST_CASE(SQLiteStatementCache)
+{
+  using namespace easy::db;
+
+  easy::error_code ec;
+  sqlite::database db(":memory:", ec);
+  BOOST_REQUIRE(!ec);
+
+  db.execute("create table t (_id integer primary key, name text)", ec);
+  BOOST_REQUIRE(!ec);
+
+  const char* query = "select name from t where _id = 1";
+  {
+    sqlite::statement st = db.create_statement(query, ec);
+    BOOST_CHECK(!ec);
+  }
+  {
+    sqlite::statement st = db.create_statement(query, ec);
+    BOOST_CHECK(!ec);
+  }
+
+  sqlite::statement_cache_stats stats = db.get_statement_cache_stats();
+  BOOST_CHECK_EQUAL(stats.misses, 1u);
+  BOOST_CHECK_EQUAL(stats.hits, 1u);
+  BOOST_CHECK_EQUAL(stats.size, 1u);
+
+  db.set_statement_cache_capacity(0);
+  stats = db.get_statement_cache_stats();
+  BOOST_CHECK_EQUAL(stats.size, 0u);
+  BOOST_CHECK_EQUAL(stats.evictions, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(SQLiteBindAndGet)
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  error_code ec;
+  sqlite::database db(":memory:", ec);
+  BOOST_REQUIRE(!ec);
+
+  db.execute("create table t (_id integer primary key, name text, weight real, data blob)", ec);
+  BOOST_REQUIRE(!ec);
+
+  const byte data[] = { 1, 2, 3 };
+  {
+    sqlite::statement st(db, "insert into t values (?, ?, ?, ?)", ec);
+    BOOST_REQUIRE(!ec);
+    BOOST_CHECK(st.bind(1, "first", 1.5, lite_buffer<byte>(data, sizeof(data)), ec));
+    BOOST_CHECK(!st.next(ec));
+    BOOST_CHECK(!ec);
+
+    BOOST_CHECK(st.reset(ec));
+    BOOST_CHECK(st.bind(2, nullptr, boost::optional<double>(), lite_buffer<byte>(), ec));
+    BOOST_CHECK(!st.next(ec));
+    BOOST_CHECK(!ec);
+  }
+
+  sqlite::statement st(db, "select _id, name, weight, data from t order by _id", ec);
+  BOOST_REQUIRE(!ec);
+
+  BOOST_REQUIRE(st.next(ec));
+  BOOST_CHECK_EQUAL(st.get_column_count(), 4);
+  BOOST_CHECK_EQUAL(st.get<int>(0), 1);
+  BOOST_CHECK(st.get<lite_string>(1) == "first");
+  BOOST_CHECK_EQUAL(st.get<double>(2), 1.5);
+  lite_buffer<byte> blob = st.get<lite_buffer<byte>>(3);
+  BOOST_REQUIRE_EQUAL(blob.size(), sizeof(data));
+  BOOST_CHECK(std::equal(blob.begin(), blob.end(), data));
+
+  BOOST_REQUIRE(st.next(ec));
+  BOOST_CHECK_EQUAL(st.get<int64>(0), 2);
+  BOOST_CHECK(st.is_null(1));
+  BOOST_CHECK(!st.get<boost::optional<double>>(2));
+  BOOST_CHECK(st.get<lite_buffer<byte>>(3).empty());
+
+  BOOST_CHECK(!st.next(ec));
+  BOOST_CHECK(!ec);
+}
+
+BOOST_AUTO_TEST_CASE(SQLiteBulkInserter)
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  error_code ec;
+  sqlite::database db(":memory:", ec);
+  BOOST_REQUIRE(!ec);
+
+  db.execute("create table t (_id integer primary key, name text)", ec);
+  BOOST_REQUIRE(!ec);
+
+  std::vector<std::tuple<int, std::string>> rows;
+  for (int i = 0; i < 25; ++i)
+    rows.push_back(std::make_tuple(i, std::string("name")));
+
+  {
+    sqlite::bulk_inserter inserter(db, "insert into t values (?, ?)", 10, ec);
+    BOOST_REQUIRE(!ec);
+    BOOST_CHECK(inserter.insert_range(rows, ec));
+    BOOST_CHECK(inserter.flush(ec));
+
+    sqlite::bulk_insert_stats stats = inserter.get_stats();
+    BOOST_CHECK_EQUAL(stats.rows, 25u);
+    BOOST_CHECK_EQUAL(stats.transactions, 3u);
+
+    // duplicate primary key rolls the batch back
+    BOOST_CHECK(inserter.insert(std::make_tuple(100, "name"), ec));
+    BOOST_CHECK(!inserter.insert(std::make_tuple(0, "name"), ec));
+    BOOST_CHECK(ec);
+
+    // a row of the wrong arity throws after the rollback, so the next row starts a new transaction
+    BOOST_CHECK_THROW(inserter.insert(std::make_tuple(200, "name", 1)), system_error);
+    BOOST_CHECK(inserter.insert(std::make_tuple(201, "name")));
+    BOOST_CHECK(inserter.flush());
+  }
+
+  sqlite::statement st(db, "select count(*) from t", ec);
+  BOOST_REQUIRE(st.next(ec));
+  BOOST_CHECK_EQUAL(st.get<int>(0), 26);
+}
+
+BOOST_AUTO_TEST_CASE(SQLiteConnectionPool)
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  const std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  easy::scope_exit remove_db([&]() {
+    boost::system::error_code ec;
+    boost::filesystem::remove(path, ec);
+    boost::filesystem::remove(path + "-wal", ec);
+    boost::filesystem::remove(path + "-shm", ec);
+  });
+
+  error_code ec;
+  sqlite::connection_pool pool(path, 2, ec);
+  BOOST_REQUIRE(!ec);
+  {
+    sqlite::pooled_connection writer = pool.acquire_writer(ec);
+    BOOST_REQUIRE(!ec && writer.is_writer());
+    writer->execute("create table t (_id integer primary key)", ec);
+    BOOST_CHECK(!ec);
+
+    sqlite::pooled_connection busy = pool.acquire_writer(std::chrono::milliseconds(10), ec);
+    BOOST_CHECK(!busy);
+    BOOST_CHECK(ec);
+  }
+  {
+    sqlite::pooled_connection r1 = pool.acquire_reader(ec);
+    sqlite::pooled_connection r2 = pool.acquire_reader(ec);
+    BOOST_REQUIRE(r1 && r2);
+    BOOST_CHECK(!pool.acquire_reader(std::chrono::milliseconds(10), ec));
+
+    sqlite::statement st(*r1, "select count(*) from t", ec);
+    BOOST_REQUIRE(st.next(ec));
+    BOOST_CHECK_EQUAL(st.get<int>(0), 0);
+  }
+
+  sqlite::connection_pool_stats stats = pool.get_stats();
+  BOOST_CHECK_EQUAL(stats.idle_readers, 2u);
+  BOOST_CHECK_EQUAL(stats.timeouts, 2u);
+  BOOST_CHECK_EQUAL(stats.reader_checkouts, 2u);
+
+  // a pool which failed to open hands out no connections
+  sqlite::connection_pool broken((boost::filesystem::path(path) / "missing" / "db").string(), 2, ec);
+  BOOST_CHECK(ec);
+  BOOST_CHECK(!broken.acquire_writer(ec));
+  BOOST_CHECK(ec == sqlite::detail::make_db_error_code(static_cast<int>(sqlite::result_code::null_database)));
+  BOOST_CHECK(!broken.acquire_reader(ec));
+}
+
+BOOST_AUTO_TEST_CASE(SQLiteWalOptionsAndCheckpoints)
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  const std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  easy::scope_exit remove_db([&]() {
+    boost::system::error_code ec;
+    boost::filesystem::remove(path, ec);
+    boost::filesystem::remove(path + "-wal", ec);
+    boost::filesystem::remove(path + "-shm", ec);
+  });
+
+  sqlite::database_options options = sqlite::database_options::wal_profile();
+  options.wal_autocheckpoint = 0;
+
+  error_code ec;
+  sqlite::database db(path, sqlite::open_flag::read_write | sqlite::open_flag::create, options, ec);
+  BOOST_REQUIRE(!ec);
+  {
+    sqlite::statement st(db, "PRAGMA journal_mode", ec);
+    BOOST_REQUIRE(st.next(ec));
+    BOOST_CHECK(st.get<lite_string>(0) == "wal");
+  }
+
+  sqlite::checkpoint_scheduler scheduler(path, ec);
+  BOOST_REQUIRE(!ec);
+
+  db.execute("create table t (_id integer primary key)", ec);
+  BOOST_REQUIRE(!ec);
+  BOOST_CHECK(boost::filesystem::file_size(path + "-wal") > 0);
+
+  BOOST_CHECK(scheduler.checkpoint(sqlite::checkpoint_mode::truncate, ec));
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(path + "-wal"), 0u);
+  BOOST_CHECK_EQUAL(scheduler.get_stats().truncate_checkpoints, 1u);
+  scheduler.stop();
+
+  // the log file keeps its size after a passive checkpoint, which must not trigger more of them
+  sqlite::checkpoint_policy policy;
+  policy.poll_interval = sqlite::checkpoint_policy::duration_type(5);
+  policy.passive_wal_size = 1;
+  sqlite::checkpoint_scheduler passive(path, policy, ec);
+  BOOST_REQUIRE(!ec);
+  db.execute("insert into t values (null)", ec);
+  BOOST_REQUIRE(!ec);
+  for (int i = 0; i < 400 && !passive.get_stats().passive_checkpoints; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  BOOST_CHECK(boost::filesystem::file_size(path + "-wal") > 0);
+  const uint64 checkpoints = passive.get_stats().passive_checkpoints;
+  BOOST_CHECK_EQUAL(checkpoints, 1u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  BOOST_CHECK_EQUAL(passive.get_stats().passive_checkpoints, checkpoints);
+}
+
+BOOST_AUTO_TEST_CASE(SQLiteRowRange)
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  error_code ec;
+  sqlite::database db(":memory:", ec);
+  BOOST_REQUIRE(!ec);
+
+  db.execute("create table t (_id integer primary key, name text);"
+    "insert into t values (1, 'a');"
+    "insert into t values (2, 'bb');", ec);
+  BOOST_REQUIRE(!ec);
+
+  sqlite::statement st(db, "select _id, name from t order by _id", ec);
+  BOOST_REQUIRE(!ec);
+
+  int count = 0;
+  size_t length = 0;
+  for (auto& row : make_range(st.rows<int, lite_string>())) {
+    BOOST_CHECK_EQUAL(std::get<0>(row), ++count);
+    length += std::get<1>(row).length();
+  }
+  BOOST_CHECK_EQUAL(count, 2);
+  BOOST_CHECK_EQUAL(length, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(SQLiteAsyncExecutor)
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  error_code ec;
+  sqlite::database db(":memory:", ec);
+  BOOST_REQUIRE(!ec);
+
+  sqlite::async_executor executor(std::move(db));
+  BOOST_REQUIRE(!executor.execute("create table t (_id integer primary key)").get());
+
+  std::vector<std::future<error_code>> writes;
+  for (int i = 1; i <= 10; ++i) {
+    writes.push_back(executor.submit(sqlite::job_kind::write, [i](sqlite::database& _db, error_code_ref ec) {
+      sqlite::statement st(_db, "insert into t values (?)", ec);
+      if (!ec)
+        st.bind(i, ec);
+      if (!ec)
+        st.next(ec);
+    }));
+  }
+  // duplicate key is rolled back alone
+  std::future<error_code> failed = executor.execute("insert into t values (1)");
+
+  int count = 0;
+  std::future<error_code> read = executor.submit(sqlite::job_kind::read, [&count](sqlite::database& _db, error_code_ref ec) {
+    sqlite::statement st(_db, "select count(*) from t", ec);
+    if (!ec && st.next(ec))
+      count = st.get<int>(0);
+  });
+
+  for (auto& w : writes)
+    BOOST_CHECK(!w.get());
+  BOOST_CHECK(failed.get());
+  BOOST_CHECK(!read.get());
+  BOOST_CHECK_EQUAL(count, 10);
+
+  executor.stop();
+  BOOST_CHECK(executor.execute("delete from t").get() == sqlite::detail::make_db_error_code(static_cast<int>(sqlite::result_code::executor_stopped)));
+
+  sqlite::async_executor_stats stats = executor.get_stats();
+  BOOST_CHECK_EQUAL(stats.reads, 1u);
+  BOOST_CHECK_EQUAL(stats.writes, 12u);
+  BOOST_CHECK_EQUAL(stats.failed, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(SQLiteAsyncExecutorStopRace)
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  const error_code stopped = sqlite::detail::make_db_error_code(static_cast<int>(sqlite::result_code::executor_stopped));
+  for (int round = 0; round < 50; ++round) {
+    error_code ec;
+    sqlite::database db(":memory:", ec);
+    BOOST_REQUIRE(!ec);
+    sqlite::async_executor executor(std::move(db));
+
+    // every job submitted around stop is either run or completed as stopped
+    std::vector<std::future<error_code>> jobs;
+    std::thread submitter([&] {
+      for (int i = 0; i < 200; ++i)
+        jobs.push_back(executor.submit(sqlite::job_kind::read, [](sqlite::database&, error_code_ref) { }));
+    });
+    executor.stop();
+    submitter.join();
+
+    for (auto& job : jobs) {
+      BOOST_REQUIRE(job.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+      const error_code result = job.get();
+      BOOST_CHECK(!result || result == stopped);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SQLiteBlobStream)
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  error_code ec;
+  sqlite::database db(":memory:", ec);
+  BOOST_REQUIRE(!ec);
+
+  db.execute("create table t (_id integer primary key, data blob);"
+    "insert into t values (1, zeroblob(1000));"
+    "insert into t values (2, x'0102030405');", ec);
+  BOOST_REQUIRE(!ec);
+
+  byte chunk[64];
+  for (size_t i = 0; i < sizeof(chunk); ++i)
+    chunk[i] = static_cast<byte>(i);
+
+  sqlite::blob_stream blob(db, "t", "data", 1, sqlite::blob_access::read_write, ec);
+  BOOST_REQUIRE(!ec);
+  BOOST_CHECK_EQUAL(blob.size(), 1000u);
+  while (blob.tell() + sizeof(chunk) <= blob.size())
+    BOOST_REQUIRE(blob.write(chunk, sizeof(chunk), ec));
+  BOOST_CHECK(!blob.write(chunk, sizeof(chunk), ec)); // the value cannot grow
+  ec.clear();
+
+  blob.seek(0);
+  byte buffer[100];
+  size_t total = 0;
+  bool same = true;
+  while (size_t read = blob.read(buffer, sizeof(buffer), ec)) {
+    for (size_t i = 0; i < read && total + i < 960; ++i)
+      same = same && buffer[i] == chunk[(total + i) % sizeof(chunk)];
+    total += read;
+  }
+  BOOST_CHECK(!ec);
+  BOOST_CHECK(same);
+  BOOST_CHECK_EQUAL(total, 1000u);
+
+  BOOST_REQUIRE(blob.reopen(2, ec));
+  BOOST_CHECK_EQUAL(blob.size(), 5u);
+  BOOST_CHECK_EQUAL(blob.read(buffer, sizeof(buffer), ec), 5u);
+  BOOST_CHECK_EQUAL(buffer[4], 5);
+  BOOST_CHECK_EQUAL(blob.read(buffer, sizeof(buffer), ec), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(SQLiteProfiling)
+{
+  using namespace easy;
+  using namespace easy::db;
+
+  error_code ec;
+  sqlite::database db(":memory:", ec);
+  BOOST_REQUIRE(!ec);
+
+  db.execute("create table t (_id integer primary key, name text);"
+    "insert into t values (1, 'a');"
+    "insert into t values (2, 'b');"
+    "insert into t values (3, 'c');", ec);
+  BOOST_REQUIRE(!ec);
+
+  std::vector<std::string> slow_queries;
+  sqlite::profiling_options options;
+  options.slow_query_threshold = sqlite::profiling_options::duration_type(0);
+  options.slow_query_callback = [&slow_queries](const sqlite::slow_query& q) {
+    slow_queries.push_back(q.sql);
+  };
+  BOOST_REQUIRE(db.enable_profiling(options, ec));
+
+  const char* query = "select name from t where name <> 'b'";
+  for (int i = 0; i < 2; ++i) {
+    sqlite::statement st(db, query, ec);
+    BOOST_REQUIRE(!ec);
+    while (st.next(ec))
+      ;
+    BOOST_REQUIRE(!ec);
+    st.reset(ec);
+  }
+
+  std::vector<sqlite::query_stats> snapshot = db.get_profile_snapshot();
+  auto it = std::find_if(snapshot.begin(), snapshot.end(), [query](const sqlite::query_stats& s) { return s.sql == query; });
+  BOOST_REQUIRE(it != snapshot.end());
+  BOOST_CHECK_EQUAL(it->step_us.count, 2u);
+  BOOST_CHECK_EQUAL(it->rows.sum, 4u);
+  BOOST_CHECK_EQUAL(it->rows.largest, 2u);
+  BOOST_CHECK_EQUAL(it->prepare_us.count, 1u); // the second statement comes from the cache
+  BOOST_CHECK(it->fullscan_steps.sum > 0);
+  BOOST_CHECK_EQUAL(std::count(slow_queries.begin(), slow_queries.end(), query), 2);
+
+  db.reset_profile();
+  BOOST_CHECK(db.get_profile_snapshot().empty());
+  db.disable_profiling();
+
+  // snapshots taken by another thread while profiling is switched on and off
+  bool done = false;
+  std::mutex mutex;
+  std::thread reader([&] {
+    for (;;) {
+      db.get_profile_snapshot();
+      db.reset_profile();
+      std::lock_guard<std::mutex> lock(mutex);
+      if (done)
+        break;
+    }
+  });
+  for (int i = 0; i < 200; ++i) {
+    db.enable_profiling(sqlite::profiling_options(), ec);
+    db.execute("select count(*) from t", ec);
+    db.disable_profiling();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  reader.join();
+  BOOST_CHECK(!ec);
+}
@@ -0,0 +1,777 @@
+/*!
+ *  @file   tests/strings_benchmark.cpp
+ *  @author Sergey Tararay
+ *  @date   2013
+ *
+ *  @brief Costs of basic_lite_string ownership and search on key, name and log line workloads.
+ *
+ *  The inline storage of lite_string is compared with the former ownership path,
+ *  which put every taken over std::string into a separate heap holder.
+ *  Heap allocations are counted by replacing the global operator new.
+ *
+ *  The search functions are compared with scalar loops and std::string on multi-kilobyte log lines.
+ *
+ *  Header name lookups by view are compared with building a std::string key per probe.
+ *  Lookups of literal names by C string are compared with static_string keys.
+ *
+ *  Keeping duplicate names as std::string copies is compared with interning them in a string_pool.
+ *
+ *  Building a large SQL statement by std::string concatenation is compared with string_builder.
+ *
+ *  Parsing numbers out of views with easy::parse is compared with std::stoll and std::stod on
+ *  temporary strings, formatting them with easy::format is compared with std::to_string.
+ *
+ *  UTF-8 to UTF-16 transcoding and back is compared with std::codecvt_utf8_utf16 on ASCII,
+ *  mostly Latin and CJK text.
+ *
+ *  The results are printed to stdout as JSON.
+ *
+ *  Build on Linux from the repository root (add -mavx2 to measure the AVX2 kernels):
+ *
+ *    g++ -std=c++11 -O2 -DNDEBUG -I. tests/strings_benchmark.cpp src/strings/string_search.cpp src/strings/string_hash.cpp src/strings/string_pool.cpp \
+ *      src/strings/string_builder.cpp src/strings/numbers.cpp src/strings/utf.cpp src/error_handling.cpp src/memory/memory_resource.cpp src/memory/arena.cpp -o strings_benchmark
+ *
+ *  Usage: strings_benchmark [strings] [log lines]
+ */
+#include <easy/strings.h>
+
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <codecvt>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <locale>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+  unsigned long long g_allocations = 0;
+}
+
+void* operator new(size_t size)
+{
+  ++g_allocations;
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) EASY_NOEXCEPT
+{
+  std::free(p);
+}
+
+namespace
+{
+  typedef std::chrono::steady_clock clock_type;
+
+  //! The former ownership path of basic_lite_string
+  class holder_string
+    : boost::noncopyable
+  {
+  public:
+    holder_string(std::string && str)
+      : m_holder_ptr(new std::string(std::move(str)))
+      , m_pstr(m_holder_ptr->c_str())
+      , m_size(m_holder_ptr->size()) {
+    }
+
+    holder_string(holder_string && r)
+      : m_holder_ptr(std::move(r.m_holder_ptr))
+      , m_pstr(r.m_pstr)
+      , m_size(r.m_size) {
+    }
+
+    size_t length() const {
+      return m_size;
+    }
+  private:
+    std::unique_ptr<std::string> m_holder_ptr;
+    const char* m_pstr;
+    size_t m_size;
+  };
+
+  struct benchmark_result
+  {
+    const char* workload;
+    const char* storage;
+    size_t strings;
+    double seconds;
+    unsigned long long allocations;
+  };
+
+  std::string make_key(size_t i)
+  {
+    return "user:" + std::to_string(i);
+  }
+
+  std::string make_name(size_t i)
+  {
+    return "organization/department/team/member-" + std::to_string(i);
+  }
+
+  //! Takes over the strings and keeps them in a vector, the way parsed keys and names are stored
+  template<class String>
+  benchmark_result run(const char* workload, const char* storage, std::string (*make)(size_t), size_t count)
+  {
+    std::vector<std::string> sources;
+    sources.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+      sources.push_back(make(i));
+
+    std::vector<String> strings;
+    strings.reserve(count);
+
+    const unsigned long long allocations = g_allocations;
+    const clock_type::time_point start = clock_type::now();
+    for (size_t i = 0; i < count; ++i)
+      strings.push_back(String(std::move(sources[i])));
+    size_t length = 0;
+    for (size_t i = 0; i < count; ++i)
+      length += strings[i].length();
+
+    benchmark_result r;
+    r.workload = workload;
+    r.storage = storage;
+    r.strings = length ? count : 0;
+    r.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    r.allocations = g_allocations - allocations;
+    return r;
+  }
+}
+
+namespace
+{
+  struct search_result
+  {
+    const char* workload;
+    const char* implementation;
+    size_t bytes;
+    double seconds;
+  };
+
+  //! Log lines of a few kilobytes with the interesting part at the end
+  std::vector<std::string> make_log_lines(size_t count)
+  {
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      std::string line = "2013-08-04 12:00:00.000 INFO [worker-" + std::to_string(i % 16) + "] ";
+      while (line.size() < 4000)
+        line += "payload chunk with some words and numbers 1234567890 ";
+      line += "status=done; request_id=" + std::to_string(i);
+      lines.push_back(std::move(line));
+    }
+    return lines;
+  }
+
+  const char* scalar_find(const char* p, const char* end, char c)
+  {
+    for (; p != end; ++p) {
+      if (*p == c)
+        return p;
+    }
+    return nullptr;
+  }
+
+  const char* scalar_find(const char* p, const char* end, const char* psub, size_t sub_size)
+  {
+    for (; p + sub_size <= end; ++p) {
+      if (std::memcmp(p, psub, sub_size) == 0)
+        return p;
+    }
+    return nullptr;
+  }
+
+  const char* scalar_find_first_of(const char* p, const char* end, const char* pset, size_t set_size)
+  {
+    for (; p != end; ++p) {
+      for (size_t i = 0; i < set_size; ++i) {
+        if (*p == pset[i])
+          return p;
+      }
+    }
+    return nullptr;
+  }
+
+  template<class Fn>
+  search_result run_search(const char* workload, const char* implementation, const std::vector<std::string>& lines, Fn fn)
+  {
+    const int repeats = 20;
+    volatile size_t sink = 0; // keeps the searches from being optimized out
+    size_t bytes = 0;
+    const clock_type::time_point start = clock_type::now();
+    for (int r = 0; r < repeats; ++r) {
+      for (auto it = lines.begin(); it != lines.end(); ++it) {
+        sink += fn(*it);
+        bytes += it->size();
+      }
+    }
+
+    search_result result;
+    result.workload = workload;
+    result.implementation = implementation;
+    result.bytes = bytes;
+    result.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    return result;
+  }
+
+  size_t to_pos(const std::string& s, const char* p)
+  {
+    return p ? p - s.data() : std::string::npos;
+  }
+
+  size_t count_fields(easy::lite_string s)
+  {
+    size_t count = 0;
+    for (auto field : s.split(' '))
+      count += field.empty() ? 0 : 1;
+    return count;
+  }
+
+  size_t count_fields(const std::string& s)
+  {
+    size_t count = 0;
+    for (size_t pos = 0; pos <= s.size(); ) {
+      size_t end = s.find(' ', pos);
+      if (end == std::string::npos)
+        end = s.size();
+      count += end > pos ? 1 : 0;
+      pos = end + 1;
+    }
+    return count;
+  }
+
+  std::vector<search_result> run_searches(size_t count)
+  {
+    using easy::lite_string;
+
+    const std::vector<std::string> lines = make_log_lines(count);
+    std::vector<search_result> results;
+
+    results.push_back(run_search("find_char", "scalar", lines, [](const std::string& s) {
+      return to_pos(s, scalar_find(s.data(), s.data() + s.size(), ';'));
+    }));
+    results.push_back(run_search("find_char", "std_string", lines, [](const std::string& s) {
+      return s.find(';');
+    }));
+    results.push_back(run_search("find_char", "lite_string", lines, [](const std::string& s) {
+      return lite_string(s.data(), s.size()).find(';');
+    }));
+
+    results.push_back(run_search("rfind_char", "std_string", lines, [](const std::string& s) {
+      return s.rfind('[');
+    }));
+    results.push_back(run_search("rfind_char", "lite_string", lines, [](const std::string& s) {
+      return lite_string(s.data(), s.size()).rfind('[');
+    }));
+
+    results.push_back(run_search("find_substr", "scalar", lines, [](const std::string& s) {
+      return to_pos(s, scalar_find(s.data(), s.data() + s.size(), "request_id=", 11));
+    }));
+    results.push_back(run_search("find_substr", "std_string", lines, [](const std::string& s) {
+      return s.find("request_id=");
+    }));
+    results.push_back(run_search("find_substr", "lite_string", lines, [](const std::string& s) {
+      return lite_string(s.data(), s.size()).find("request_id=");
+    }));
+
+    results.push_back(run_search("find_first_of", "scalar", lines, [](const std::string& s) {
+      return to_pos(s, scalar_find_first_of(s.data(), s.data() + s.size(), "=;|", 3));
+    }));
+    results.push_back(run_search("find_first_of", "std_string", lines, [](const std::string& s) {
+      return s.find_first_of("=;|");
+    }));
+    results.push_back(run_search("find_first_of", "lite_string", lines, [](const std::string& s) {
+      return lite_string(s.data(), s.size()).find_first_of("=;|");
+    }));
+
+    results.push_back(run_search("split", "std_string", lines, [](const std::string& s) {
+      return count_fields(s);
+    }));
+    results.push_back(run_search("split", "lite_string", lines, [](const std::string& s) {
+      return count_fields(lite_string(s.data(), s.size()));
+    }));
+    return results;
+  }
+}
+
+namespace
+{
+  struct lookup_result
+  {
+    const char* implementation;
+    size_t lookups;
+    double seconds;
+    unsigned long long allocations;
+  };
+
+  //! Parses header names out of a request and looks each of them up
+  template<class Find>
+  lookup_result run_lookup(const char* implementation, const std::string& request, size_t repeats, Find find)
+  {
+    const easy::lite_string text(request.data(), request.size());
+
+    size_t lookups = 0;
+    size_t found = 0;
+    const unsigned long long allocations = g_allocations;
+    const clock_type::time_point start = clock_type::now();
+    for (size_t r = 0; r < repeats; ++r) {
+      for (auto line : text.split("\r\n")) {
+        const size_t colon = line.find(':');
+        if (colon == easy::lite_string::npos)
+          continue;
+        found += find(line.substr(0, colon));
+        ++lookups;
+      }
+    }
+
+    lookup_result result;
+    result.implementation = implementation;
+    result.lookups = found ? lookups : 0;
+    result.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    result.allocations = g_allocations - allocations;
+    return result;
+  }
+
+  //! Looks up the same literal names over and over, as handlers asking for known headers do
+  template<class Find>
+  lookup_result run_literal_lookup(const char* implementation, size_t repeats, Find find)
+  {
+    size_t found = 0;
+    const unsigned long long allocations = g_allocations;
+    const clock_type::time_point start = clock_type::now();
+    for (size_t r = 0; r < repeats; ++r)
+      found += find();
+
+    lookup_result result;
+    result.implementation = implementation;
+    result.lookups = found ? repeats * 4 : 0;
+    result.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    result.allocations = g_allocations - allocations;
+    return result;
+  }
+
+  std::vector<lookup_result> run_lookups(size_t repeats)
+  {
+    const char* names[] = {
+      "host", "user-agent", "accept", "accept-encoding", "accept-language", "content-type",
+      "content-length", "x-forwarded-for", "x-request-start-timestamp", "authorization"
+    };
+    const size_t name_count = sizeof(names) / sizeof(names[0]);
+
+    std::string request;
+    for (size_t i = 0; i < name_count; ++i)
+      request.append(names[i]).append(": value\r\n");
+    request.append("x-unknown-extension-header: value\r\n");
+
+    std::unordered_map<std::string, size_t> std_map;
+    boost::unordered_map<std::string, size_t, easy::lite_string_hash, easy::lite_string_equal> view_map;
+    for (size_t i = 0; i < name_count; ++i) {
+      std_map[names[i]] = i;
+      view_map[names[i]] = i;
+    }
+
+    std::vector<lookup_result> results;
+    results.push_back(run_lookup("std_string_key", request, repeats, [&](const easy::lite_string& name) {
+      return std_map.count(std::string(name.data(), name.size()));
+    }));
+    results.push_back(run_lookup("lite_string_view", request, repeats, [&](const easy::lite_string& name) {
+      return view_map.find(name, easy::lite_string_hash(), easy::lite_string_equal()) != view_map.end() ? 1 : 0;
+    }));
+
+    const easy::lite_string_hash hash;
+    const easy::lite_string_equal equal;
+    results.push_back(run_literal_lookup("literal_c_string", repeats * 10, [&]() {
+      return (view_map.find("content-type", hash, equal) != view_map.end() ? 1 : 0)
+        + (view_map.find("content-length", hash, equal) != view_map.end() ? 1 : 0)
+        + (view_map.find("x-request-start-timestamp", hash, equal) != view_map.end() ? 1 : 0)
+        + (view_map.find("authorization", hash, equal) != view_map.end() ? 1 : 0);
+    }));
+    static const easy::static_string content_type("content-type");
+    static const easy::static_string content_length("content-length");
+    static const easy::static_string request_start("x-request-start-timestamp");
+    static const easy::static_string authorization("authorization");
+    results.push_back(run_literal_lookup("literal_static_string", repeats * 10, [&]() {
+      return (view_map.find(content_type, hash, equal) != view_map.end() ? 1 : 0)
+        + (view_map.find(content_length, hash, equal) != view_map.end() ? 1 : 0)
+        + (view_map.find(request_start, hash, equal) != view_map.end() ? 1 : 0)
+        + (view_map.find(authorization, hash, equal) != view_map.end() ? 1 : 0);
+    }));
+    return results;
+  }
+}
+
+namespace
+{
+  struct interning_result
+  {
+    const char* storage;
+    size_t names;
+    double seconds;
+    unsigned long long allocations;
+    unsigned long long bytes;
+  };
+
+  //! Column names repeating over the rows of a result set
+  std::string make_column_name(size_t i)
+  {
+    return "customer_account_column_" + std::to_string(i % 1000);
+  }
+
+  std::vector<interning_result> run_interning(size_t count)
+  {
+    std::vector<std::string> sources;
+    sources.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+      sources.push_back(make_column_name(i));
+
+    std::vector<interning_result> results;
+    {
+      std::vector<std::string> names;
+      names.reserve(count);
+      const unsigned long long allocations = g_allocations;
+      const clock_type::time_point start = clock_type::now();
+      for (size_t i = 0; i < count; ++i)
+        names.push_back(sources[i]);
+
+      interning_result r;
+      r.storage = "std_string_copies";
+      r.names = names.size();
+      r.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+      r.allocations = g_allocations - allocations;
+      r.bytes = 0;
+      for (size_t i = 0; i < count; ++i)
+        r.bytes += names[i].capacity() + 1;
+      results.push_back(r);
+    }
+    {
+      easy::string_pool pool;
+      std::vector<easy::lite_string> names;
+      names.reserve(count);
+      const unsigned long long allocations = g_allocations;
+      const clock_type::time_point start = clock_type::now();
+      for (size_t i = 0; i < count; ++i)
+        names.push_back(pool.intern(sources[i]));
+
+      const easy::string_pool_stats stats = pool.get_stats();
+      interning_result r;
+      r.storage = "string_pool";
+      r.names = names.size();
+      r.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+      r.allocations = g_allocations - allocations;
+      r.bytes = stats.arena_bytes + stats.index_bytes;
+      results.push_back(r);
+    }
+    return results;
+  }
+}
+
+namespace
+{
+  struct building_result
+  {
+    const char* implementation;
+    size_t statements;
+    size_t bytes;
+    double seconds;
+    unsigned long long allocations;
+  };
+
+  template<class Build>
+  building_result run_building(const char* implementation, size_t statements, Build build)
+  {
+    size_t bytes = 0;
+    const unsigned long long allocations = g_allocations;
+    const clock_type::time_point start = clock_type::now();
+    for (size_t i = 0; i < statements; ++i)
+      bytes += build(i);
+
+    building_result result;
+    result.implementation = implementation;
+    result.statements = statements;
+    result.bytes = bytes;
+    result.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    result.allocations = g_allocations - allocations;
+    return result;
+  }
+
+  //! INSERT statements of 1000 rows with an integer, a string and a floating point column
+  std::vector<building_result> run_buildings(size_t statements)
+  {
+    const size_t rows = 1000;
+    std::vector<building_result> results;
+    results.push_back(run_building("std_string", statements, [&](size_t n) -> size_t {
+      std::string sql = "INSERT INTO orders (id, customer, amount) VALUES ";
+      for (size_t r = 0; r < rows; ++r) {
+        sql += r ? ", (" : "(";
+        sql += std::to_string(n * rows + r);
+        sql += ", 'customer_";
+        sql += std::to_string(r % 97);
+        sql += "', ";
+        sql += std::to_string(r * 0.25);
+        sql += ")";
+      }
+      return sql.size();
+    }));
+    results.push_back(run_building("string_builder", statements, [&](size_t n) -> size_t {
+      easy::string_builder sql;
+      sql << "INSERT INTO orders (id, customer, amount) VALUES ";
+      for (size_t r = 0; r < rows; ++r)
+        sql << (r ? ", (" : "(") << n * rows + r << ", 'customer_" << r % 97 << "', " << r * 0.25 << ")";
+      return sql.flatten().size();
+    }));
+    return results;
+  }
+}
+
+namespace
+{
+  struct number_result
+  {
+    const char* workload;
+    const char* implementation;
+    size_t numbers;
+    double seconds;
+    unsigned long long allocations;
+  };
+
+  template<class Fn>
+  number_result run_number(const char* workload, const char* implementation, const std::vector<easy::lite_string>& fields, Fn fn)
+  {
+    volatile double sink = 0;
+    const unsigned long long allocations = g_allocations;
+    const clock_type::time_point start = clock_type::now();
+    for (size_t i = 0; i < fields.size(); ++i)
+      sink += fn(fields[i]);
+
+    number_result result;
+    result.workload = workload;
+    result.implementation = implementation;
+    result.numbers = fields.size();
+    result.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    result.allocations = g_allocations - allocations;
+    return result;
+  }
+
+  //! Views of the comma separated fields of a CSV text
+  std::vector<easy::lite_string> split_fields(const std::string& text)
+  {
+    std::vector<easy::lite_string> fields;
+    for (auto field : easy::lite_string(text.data(), text.size()).split(','))
+      fields.push_back(easy::lite_string(field.data(), field.size()));
+    return fields;
+  }
+
+  std::vector<number_result> run_numbers(size_t count)
+  {
+    std::string integer_text;
+    std::string double_text;
+    for (size_t i = 0; i < count; ++i) {
+      integer_text.append(std::to_string(static_cast<long long>(i * 2654435761u % 100000000000ULL) - 50000000000LL)).append(",");
+      double_text.append(std::to_string(static_cast<double>(i % 100000) / 64)).append(",");
+    }
+    integer_text.append("0");
+    double_text.append("0");
+    const std::vector<easy::lite_string> integers = split_fields(integer_text);
+    const std::vector<easy::lite_string> doubles = split_fields(double_text);
+
+    std::vector<number_result> results;
+    results.push_back(run_number("parse_int64", "std_stoll", integers, [](const easy::lite_string& s) {
+      return static_cast<double>(std::stoll(std::string(s.data(), s.size())));
+    }));
+    results.push_back(run_number("parse_int64", "easy_parse", integers, [](const easy::lite_string& s) {
+      return static_cast<double>(easy::parse<easy::int64>(s));
+    }));
+    results.push_back(run_number("parse_double", "std_stod", doubles, [](const easy::lite_string& s) {
+      return std::stod(std::string(s.data(), s.size()));
+    }));
+    results.push_back(run_number("parse_double", "easy_parse", doubles, [](const easy::lite_string& s) {
+      return easy::parse<double>(s);
+    }));
+
+    results.push_back(run_number("format_int64", "std_to_string", integers, [](const easy::lite_string& s) {
+      return static_cast<double>(std::to_string(static_cast<long long>(s.size()) << 30).size());
+    }));
+    results.push_back(run_number("format_int64", "easy_format", integers, [](const easy::lite_string& s) {
+      char buffer[easy::max_number_length];
+      return static_cast<double>(easy::format(static_cast<easy::int64>(s.size()) << 30, buffer, sizeof(buffer)));
+    }));
+    results.push_back(run_number("format_double", "std_to_string", doubles, [](const easy::lite_string& s) {
+      return static_cast<double>(std::to_string(s.size() / 64.0).size());
+    }));
+    results.push_back(run_number("format_double", "easy_format", doubles, [](const easy::lite_string& s) {
+      char buffer[easy::max_number_length];
+      return static_cast<double>(easy::format(s.size() / 64.0, buffer, sizeof(buffer)));
+    }));
+    return results;
+  }
+}
+
+namespace
+{
+  struct transcoding_result
+  {
+    const char* payload;
+    const char* direction;
+    const char* implementation;
+    size_t bytes;
+    double seconds;
+  };
+
+  //! About 64K of UTF-8 text built by repeating the sample
+  std::string make_payload(const char* sample)
+  {
+    std::string text;
+    while (text.size() < 64 * 1024)
+      text += sample;
+    return text;
+  }
+
+  template<class Fn>
+  transcoding_result run_transcoding(const char* payload, const char* direction, const char* implementation,
+    const std::string& text, size_t repeats, Fn fn)
+  {
+    volatile size_t sink = 0;
+    const clock_type::time_point start = clock_type::now();
+    for (size_t r = 0; r < repeats; ++r)
+      sink += fn();
+
+    transcoding_result result;
+    result.payload = payload;
+    result.direction = direction;
+    result.implementation = implementation;
+    result.bytes = text.size() * repeats;
+    result.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    return result;
+  }
+
+  std::vector<transcoding_result> run_transcodings(size_t repeats)
+  {
+    using namespace easy;
+
+    struct payload_type
+    {
+      const char* name;
+      const char* sample;
+    };
+    const payload_type payloads[] = {
+      { "ascii", "GET /api/v1/accounts/42/orders?limit=100&offset=200 HTTP/1.1 user-agent: curl/7.29.0\n" },
+      { "latin", "Gr\xC3\xBC\xC3\x9F""e aus K\xC3\xB6ln, le caf\xC3\xA9 est ferm\xC3\xA9 \xC3\xA0 la m\xC3\xA9tropole.\n" },
+      { "cjk", "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE5\xAD\x97\xE5\x88\x97\xE3\x81\xA7\xE3\x81\x99\xE3\x80\x82 \xE4\xB8\xAD\xE6\x96\x87\xE6\x96\x87\xE6\x9C\xAC\n" }
+    };
+
+    std::vector<transcoding_result> results;
+    for (size_t p = 0; p < sizeof(payloads) / sizeof(payloads[0]); ++p) {
+      const char* name = payloads[p].name;
+      const std::string text = make_payload(payloads[p].sample);
+      std::vector<uint16> utf16(utf::utf16_length_from_utf8(text.data(), text.size()));
+      std::string utf8(text.size(), '\0');
+      std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> std_convert;
+      const std::u16string std_utf16 = std_convert.from_bytes(text);
+
+      results.push_back(run_transcoding(name, "utf8_to_utf16", "std_codecvt", text, repeats, [&]() {
+        return std_convert.from_bytes(text).size();
+      }));
+      results.push_back(run_transcoding(name, "utf8_to_utf16", "easy_utf", text, repeats, [&]() {
+        return utf::convert_utf8_to_utf16(text.data(), text.size(), &utf16[0]);
+      }));
+      results.push_back(run_transcoding(name, "utf16_to_utf8", "std_codecvt", text, repeats, [&]() {
+        return std_convert.to_bytes(std_utf16).size();
+      }));
+      results.push_back(run_transcoding(name, "utf16_to_utf8", "easy_utf", text, repeats, [&]() {
+        return utf::convert_utf16_to_utf8(&utf16[0], utf16.size(), &utf8[0]);
+      }));
+      results.push_back(run_transcoding(name, "validate_utf8", "easy_utf", text, repeats, [&]() {
+        return static_cast<size_t>(utf::validate_utf8(text.data(), text.size()));
+      }));
+    }
+    return results;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  const size_t count = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 1000000;
+  const size_t lines = argc > 2 ? static_cast<size_t>(std::max(1, std::atoi(argv[2]))) : 1000;
+
+  std::vector<benchmark_result> results;
+  results.push_back(run<holder_string>("keys", "holder", &make_key, count));
+  results.push_back(run<easy::lite_string>("keys", "inline", &make_key, count));
+  results.push_back(run<holder_string>("names", "holder", &make_name, count));
+  results.push_back(run<easy::lite_string>("names", "inline", &make_name, count));
+
+  std::printf("{\n");
+  std::printf("  \"small_capacity\": %u,\n", static_cast<unsigned>(easy::lite_string::small_capacity));
+  std::printf("  \"results\": [\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const benchmark_result& r = results[i];
+    std::printf("    {\"workload\": \"%s\", \"storage\": \"%s\", \"strings\": %u, \"seconds\": %.6f, \"allocations\": %llu}%s\n",
+      r.workload, r.storage, static_cast<unsigned>(r.strings), r.seconds, r.allocations, i + 1 < results.size() ? "," : "");
+  }
+  std::printf("  ],\n");
+
+  const std::vector<search_result> searches = run_searches(lines);
+  std::printf("  \"search\": [\n");
+  for (size_t i = 0; i < searches.size(); ++i) {
+    const search_result& r = searches[i];
+    std::printf("    {\"workload\": \"%s\", \"implementation\": \"%s\", \"seconds\": %.6f, \"gigabytes_per_second\": %.2f}%s\n",
+      r.workload, r.implementation, r.seconds, r.seconds > 0 ? r.bytes / r.seconds / 1e9 : 0.0, i + 1 < searches.size() ? "," : "");
+  }
+  std::printf("  ],\n");
+
+  const std::vector<lookup_result> lookups = run_lookups(count / 10);
+  std::printf("  \"lookup\": [\n");
+  for (size_t i = 0; i < lookups.size(); ++i) {
+    const lookup_result& r = lookups[i];
+    std::printf("    {\"implementation\": \"%s\", \"lookups\": %u, \"seconds\": %.6f, \"allocations\": %llu}%s\n",
+      r.implementation, static_cast<unsigned>(r.lookups), r.seconds, r.allocations, i + 1 < lookups.size() ? "," : "");
+  }
+  std::printf("  ],\n");
+
+  const std::vector<interning_result> interning = run_interning(count);
+  std::printf("  \"interning\": [\n");
+  for (size_t i = 0; i < interning.size(); ++i) {
+    const interning_result& r = interning[i];
+    std::printf("    {\"storage\": \"%s\", \"names\": %u, \"seconds\": %.6f, \"allocations\": %llu, \"string_bytes\": %llu}%s\n",
+      r.storage, static_cast<unsigned>(r.names), r.seconds, r.allocations, r.bytes, i + 1 < interning.size() ? "," : "");
+  }
+  std::printf("  ],\n");
+
+  const std::vector<building_result> buildings = run_buildings(lines);
+  std::printf("  \"building\": [\n");
+  for (size_t i = 0; i < buildings.size(); ++i) {
+    const building_result& r = buildings[i];
+    std::printf("    {\"implementation\": \"%s\", \"statements\": %u, \"bytes\": %u, \"seconds\": %.6f, \"allocations\": %llu}%s\n",
+      r.implementation, static_cast<unsigned>(r.statements), static_cast<unsigned>(r.bytes), r.seconds, r.allocations,
+      i + 1 < buildings.size() ? "," : "");
+  }
+  std::printf("  ],\n");
+
+  const std::vector<number_result> numbers = run_numbers(count);
+  std::printf("  \"numbers\": [\n");
+  for (size_t i = 0; i < numbers.size(); ++i) {
+    const number_result& r = numbers[i];
+    std::printf("    {\"workload\": \"%s\", \"implementation\": \"%s\", \"numbers\": %u, \"seconds\": %.6f, \"allocations\": %llu}%s\n",
+      r.workload, r.implementation, static_cast<unsigned>(r.numbers), r.seconds, r.allocations, i + 1 < numbers.size() ? "," : "");
+  }
+  std::printf("  ],\n");
+
+  const std::vector<transcoding_result> transcodings = run_transcodings(lines);
+  std::printf("  \"transcoding\": [\n");
+  for (size_t i = 0; i < transcodings.size(); ++i) {
+    const transcoding_result& r = transcodings[i];
+    std::printf("    {\"payload\": \"%s\", \"direction\": \"%s\", \"implementation\": \"%s\", \"seconds\": %.6f, \"gigabytes_per_second\": %.2f}%s\n",
+      r.payload, r.direction, r.implementation, r.seconds, r.seconds > 0 ? r.bytes / r.seconds / 1e9 : 0.0,
+      i + 1 < transcodings.size() ? "," : "");
+  }
+  std::printf("  ]\n}\n");
+  return 0;
+}
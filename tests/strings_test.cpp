@@ -9,7 +9,16 @@
 #include "include.h"
 
 #include <easy/strings.h>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <cstdlib>
 #include <iostream>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
 
 namespace {
 
@@ -50,3 +59,659 @@ BOOST_AUTO_TEST_CASE(Strings)
   lite_string csss(std::string("heeee"));
 
 }
+
+BOOST_AUTO_TEST_CASE(LiteStringOwnership)
+{
+  using namespace easy;
+
+  const char* pview = "view";
+  lite_string view(pview, 4);
+  BOOST_CHECK(!view.is_owner());
+  BOOST_CHECK(view.c_str() == pview);
+
+  std::string short_str("short");
+  lite_string small(std::move(short_str));
+  BOOST_CHECK(small.is_owner());
+  BOOST_CHECK(small == "short");
+  BOOST_CHECK(static_cast<const void*>(small.c_str()) >= static_cast<const void*>(&small));
+  BOOST_CHECK(static_cast<const void*>(small.c_str()) < static_cast<const void*>(&small + 1));
+
+  std::string long_str(lite_string::small_capacity + 10, 'x');
+  const char* plong = long_str.c_str();
+  lite_string owned(std::move(long_str));
+  BOOST_CHECK(owned.is_owner());
+  BOOST_CHECK(owned.c_str() == plong); // the buffer is taken over, not copied
+  BOOST_CHECK_EQUAL(owned.length(), lite_string::small_capacity + 10);
+
+  lite_string moved_small(std::move(small));
+  BOOST_CHECK(moved_small == "short");
+  BOOST_CHECK(small.empty());
+
+  lite_string moved_owned(std::move(owned));
+  BOOST_CHECK(moved_owned.c_str() == plong);
+  BOOST_CHECK(owned.empty());
+
+  moved_owned = std::move(view);
+  BOOST_CHECK(!moved_owned.is_owner());
+  BOOST_CHECK(moved_owned.c_str() == pview);
+  BOOST_CHECK(std::string(moved_owned) == "view");
+}
+
+BOOST_AUTO_TEST_CASE(LiteStringSearch)
+{
+  using namespace easy;
+
+  // long enough for the vector kernels and their tails
+  std::string line(1000, '.');
+  line += "key=value;id=42;key=last";
+  const lite_string s(line.c_str(), line.size());
+
+  BOOST_CHECK_EQUAL(s.find('k'), line.find('k'));
+  BOOST_CHECK_EQUAL(s.find('k', 1001), line.find('k', 1001));
+  BOOST_CHECK_EQUAL(s.find('z'), lite_string::npos);
+  BOOST_CHECK_EQUAL(s.rfind('k'), line.rfind('k'));
+  BOOST_CHECK_EQUAL(s.rfind('k', 1010), line.rfind('k', 1010));
+  BOOST_CHECK_EQUAL(s.find("key="), line.find("key="));
+  BOOST_CHECK_EQUAL(s.find("key=", 1001), line.find("key=", 1001));
+  BOOST_CHECK_EQUAL(s.find("key=x"), lite_string::npos);
+  BOOST_CHECK_EQUAL(s.rfind("key="), line.rfind("key="));
+  BOOST_CHECK_EQUAL(s.rfind("key=", 1010), line.rfind("key=", 1010));
+  BOOST_CHECK_EQUAL(s.find_first_of("=;"), line.find_first_of("=;"));
+  BOOST_CHECK_EQUAL(s.find_first_of("abcdefghijklmnopqrstuvwxyz4"), line.find_first_of("abcdefghijklmnopqrstuvwxyz4"));
+
+  for (size_t i = 0; i < 40; ++i) {
+    const lite_string tail = s.substr(s.size() - i);
+    BOOST_CHECK_EQUAL(tail.find('l'), line.substr(line.size() - i).find('l'));
+    BOOST_CHECK_EQUAL(tail.find("st"), line.substr(line.size() - i).find("st"));
+  }
+
+  // an empty needle is found like in std::string, also in empty and null views
+  const std::string empty_line;
+  const lite_string empties[] = { lite_string(), lite_string("") };
+  for (size_t i = 0; i < 2; ++i) {
+    BOOST_CHECK_EQUAL(empties[i].find(""), empty_line.find(""));
+    BOOST_CHECK_EQUAL(empties[i].find("", 1), empty_line.find("", 1));
+    BOOST_CHECK_EQUAL(empties[i].rfind(""), empty_line.rfind(""));
+    BOOST_CHECK(empties[i].contains(""));
+  }
+  BOOST_CHECK_EQUAL(s.find("", 5), line.find("", 5));
+  BOOST_CHECK_EQUAL(s.find("", s.size()), line.find("", line.size()));
+  BOOST_CHECK_EQUAL(s.find("", s.size() + 1), line.find("", line.size() + 1));
+  BOOST_CHECK_EQUAL(s.rfind(""), line.rfind(""));
+  BOOST_CHECK_EQUAL(s.rfind("", 5), line.rfind("", 5));
+
+  BOOST_CHECK(s.contains("id=42"));
+  BOOST_CHECK(!s.contains("id=43"));
+  BOOST_CHECK(s.starts_with("..."));
+  BOOST_CHECK(s.ends_with("=last"));
+  BOOST_CHECK(!s.ends_with("=lost"));
+
+  std::vector<std::string> parts;
+  for (auto part : s.substr(1000).split(';'))
+    parts.push_back(part);
+  BOOST_REQUIRE_EQUAL(parts.size(), 3u);
+  BOOST_CHECK_EQUAL(parts[1], "id=42");
+
+  parts.clear();
+  for (auto part : lite_string("a::b::::c", 9).split("::"))
+    parts.push_back(part);
+  BOOST_REQUIRE_EQUAL(parts.size(), 4u);
+  BOOST_CHECK_EQUAL(parts[0], "a");
+  BOOST_CHECK(parts[2].empty());
+  BOOST_CHECK_EQUAL(parts[3], "c");
+
+  BOOST_CHECK(lite_string().split(',').begin() == lite_string().split(',').end());
+}
+
+BOOST_AUTO_TEST_CASE(LiteStringHash)
+{
+  using namespace easy;
+
+  const std::string long_key(100, 'k');
+  const char* keys[] = { "", "a", "ab", "abc", "content-type", "x-forwarded-for-address", long_key.c_str() };
+
+  std::set<size_t> hashes;
+  for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+    const std::string key = keys[i];
+    const lite_string view(key.data(), key.size());
+    const lite_string owned = std::string(key);
+    const size_t hash = lite_string_hash()(view);
+
+    BOOST_CHECK_EQUAL(hash, lite_string_hash()(owned));
+    BOOST_CHECK_EQUAL(hash, lite_string_hash()(key));
+    BOOST_CHECK_EQUAL(hash, lite_string_hash()(keys[i]));
+    BOOST_CHECK_EQUAL(hash, std::hash<lite_string>()(view));
+    BOOST_CHECK_EQUAL(hash, boost::hash<lite_string>()(view));
+    hashes.insert(hash);
+
+    BOOST_CHECK(lite_string_equal()(view, key));
+    BOOST_CHECK(lite_string_equal()(key, owned));
+    BOOST_CHECK(lite_string_equal()(keys[i], view));
+    BOOST_CHECK(!lite_string_equal()(view, "z"));
+  }
+  BOOST_CHECK_EQUAL(hashes.size(), sizeof(keys) / sizeof(keys[0]));
+
+  // every length and a one character change give a different hash
+  hashes.clear();
+  std::string s;
+  for (size_t i = 0; i < 200; ++i) {
+    s.push_back('a');
+    hashes.insert(lite_string_hash()(s));
+    s.back() = 'b';
+    hashes.insert(lite_string_hash()(s));
+    s.back() = 'a';
+  }
+  BOOST_CHECK_EQUAL(hashes.size(), 400u);
+
+  // lookup by view in a container keyed by std::string
+  boost::unordered_map<std::string, int, lite_string_hash, lite_string_equal> headers;
+  headers["host"] = 1;
+  headers["content-length"] = 2;
+
+  const std::string request = "Content-Length: 5\r\nhost: example.com\r\n";
+  const lite_string line = lite_string(request).substr(19);
+  const lite_string name = line.substr(0, line.find(':'));
+  auto it = headers.find(name, lite_string_hash(), lite_string_equal());
+  BOOST_REQUIRE(it != headers.end());
+  BOOST_CHECK_EQUAL(it->second, 1);
+  BOOST_CHECK(headers.find(lite_string("Host"), lite_string_hash(), lite_string_equal()) == headers.end());
+}
+
+BOOST_AUTO_TEST_CASE(StringPool)
+{
+  using namespace easy;
+
+  string_pool pool(256);
+  const lite_string id = pool.intern("id");
+  const lite_string name = pool.intern(std::string("name"));
+  BOOST_CHECK_EQUAL(id, "id");
+  BOOST_CHECK(!id.is_owner());
+  BOOST_CHECK_EQUAL(id.c_str()[id.size()], '\0');
+
+  // equal strings share the characters
+  const std::string id_copy = "id";
+  BOOST_CHECK(pool.intern(id_copy).data() == id.data());
+  BOOST_CHECK(pool.intern(lite_string(id_copy)).data() == id.data());
+  BOOST_CHECK(pool.find("name").data() == name.data());
+  BOOST_CHECK(!pool.find("missing"));
+  BOOST_CHECK(!pool.intern(lite_string()));
+
+  // handles stay valid while the index and the arena grow, long strings get chunks of their own
+  std::vector<std::string> keys;
+  std::vector<const char*> handles;
+  for (size_t i = 0; i < 1000; ++i) {
+    keys.push_back("key_" + std::to_string(i) + (i % 100 == 0 ? std::string(300, 'x') : std::string()));
+    handles.push_back(pool.intern(keys.back()).data());
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    BOOST_CHECK(pool.intern(keys[i]).data() == handles[i]);
+    BOOST_CHECK_EQUAL(handles[i], keys[i]);
+  }
+  BOOST_CHECK(pool.find("id").data() == id.data());
+
+  string_pool_stats stats = pool.get_stats();
+  BOOST_CHECK_EQUAL(pool.size(), 1002u);
+  BOOST_CHECK_EQUAL(stats.strings, 1002u);
+  BOOST_CHECK_EQUAL(stats.lookups, 2005u);
+  BOOST_CHECK_EQUAL(stats.hits, 1002u);
+  BOOST_CHECK_EQUAL(stats.saved_bytes, stats.string_bytes - 8 + 6);
+  BOOST_CHECK(stats.arena_bytes >= stats.string_bytes);
+  BOOST_CHECK(stats.index_bytes > 0);
+
+  pool.clear();
+  BOOST_CHECK_EQUAL(pool.size(), 0u);
+  BOOST_CHECK_EQUAL(pool.get_stats().arena_bytes, 0u);
+  BOOST_CHECK(!pool.find("id"));
+
+  // concurrent interning of overlapping names gives a single copy of each
+  concurrent_string_pool shared_pool(6);
+  const size_t thread_count = 4;
+  std::vector<std::vector<const char*>> results(thread_count);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_count; ++t) {
+    threads.push_back(std::thread([&shared_pool, &results, t]() {
+      for (size_t i = 0; i < 2000; ++i)
+        results[t].push_back(shared_pool.intern("column_" + std::to_string(i)).data());
+    }));
+  }
+  for (size_t t = 0; t < thread_count; ++t)
+    threads[t].join();
+
+  for (size_t t = 1; t < thread_count; ++t)
+    BOOST_CHECK(results[t] == results[0]);
+  BOOST_CHECK_EQUAL(shared_pool.size(), 2000u);
+  BOOST_CHECK(shared_pool.find("column_42").data() == results[0][42]);
+
+  stats = shared_pool.get_stats();
+  BOOST_CHECK_EQUAL(stats.strings, 2000u);
+  BOOST_CHECK_EQUAL(stats.lookups, 8000u);
+  BOOST_CHECK_EQUAL(stats.hits, 6000u);
+}
+
+BOOST_AUTO_TEST_CASE(Utf)
+{
+  using namespace easy;
+
+  // every code point goes through all the encodings and back
+  std::vector<uint32> utf32;
+  for (uint32 c = 0; c <= 0x10FFFF; ++c) {
+    if (c < 0xD800 || c > 0xDFFF)
+      utf32.push_back(c);
+    if (c % 64 == 0) // long ASCII runs for the vector paths
+      utf32.insert(utf32.end(), 40, 'a');
+  }
+  BOOST_REQUIRE(utf::validate_utf32(utf32.data(), utf32.size()));
+
+  std::string utf8(utf::utf8_length_from_utf32(utf32.data(), utf32.size()), '\0');
+  BOOST_REQUIRE_EQUAL(utf::convert_utf32_to_utf8(utf32.data(), utf32.size(), &utf8[0]), utf8.size());
+  BOOST_REQUIRE(utf::validate_utf8(utf8.data(), utf8.size()));
+
+  std::vector<uint16> utf16(utf::utf16_length_from_utf8(utf8.data(), utf8.size()));
+  BOOST_CHECK_EQUAL(utf16.size(), utf::utf16_length_from_utf32(utf32.data(), utf32.size()));
+  BOOST_REQUIRE_EQUAL(utf::convert_utf8_to_utf16(utf8.data(), utf8.size(), utf16.data()), utf16.size());
+  BOOST_REQUIRE(utf::validate_utf16(utf16.data(), utf16.size()));
+
+  std::vector<uint16> utf16_from_32(utf16.size());
+  BOOST_CHECK_EQUAL(utf::convert_utf32_to_utf16(utf32.data(), utf32.size(), utf16_from_32.data()), utf16.size());
+  BOOST_CHECK(utf16_from_32 == utf16);
+
+  std::string utf8_from_16(utf::utf8_length_from_utf16(utf16.data(), utf16.size()), '\0');
+  BOOST_REQUIRE_EQUAL(utf8_from_16.size(), utf8.size());
+  BOOST_CHECK_EQUAL(utf::convert_utf16_to_utf8(utf16.data(), utf16.size(), &utf8_from_16[0]), utf8.size());
+  BOOST_CHECK(utf8_from_16 == utf8);
+
+  std::vector<uint32> utf32_from_8(utf::utf32_length_from_utf8(utf8.data(), utf8.size()));
+  BOOST_REQUIRE_EQUAL(utf32_from_8.size(), utf32.size());
+  utf::convert_utf8_to_utf32(utf8.data(), utf8.size(), utf32_from_8.data());
+  BOOST_CHECK(utf32_from_8 == utf32);
+
+  std::vector<uint32> utf32_from_16(utf::utf32_length_from_utf16(utf16.data(), utf16.size()));
+  BOOST_REQUIRE_EQUAL(utf32_from_16.size(), utf32.size());
+  utf::convert_utf16_to_utf32(utf16.data(), utf16.size(), utf32_from_16.data());
+  BOOST_CHECK(utf32_from_16 == utf32);
+
+  // malformed UTF-8 inside ASCII text
+  const char* invalid_utf8[] = {
+    "\x80", "\xBF", "\xC0\x80", "\xC1\xBF", "\xC3", "\xC3\x28", "\xE0\x80\x80", "\xE0\x9F\xBF",
+    "\xED\xA0\x80", "\xED\xBF\xBF", "\xE4\xB8", "\xF0\x8F\xBF\xBF", "\xF4\x90\x80\x80",
+    "\xF5\x80\x80\x80", "\xFF", "\xF0\x9F\x98"
+  };
+  for (size_t i = 0; i < sizeof(invalid_utf8) / sizeof(invalid_utf8[0]); ++i) {
+    const std::string text = std::string(37, 'x') + invalid_utf8[i] + std::string(20, 'y');
+    BOOST_CHECK(!utf::validate_utf8(text.data(), text.size()));
+
+    std::vector<uint16> buffer(utf::utf16_length_from_utf8(text.data(), text.size()));
+    error_code ec;
+    BOOST_CHECK_EQUAL(utf::convert_utf8_to_utf16(text.data(), text.size(), buffer.data(), ec), 0u);
+    BOOST_CHECK(ec == utf::make_invalid_sequence_error());
+    BOOST_CHECK_THROW(utf::convert_utf8_to_utf16(text.data(), text.size(), buffer.data()), system_error);
+  }
+
+  // unpaired surrogates and out of range code points
+  const uint16 lone_high[] = { 'a', 0xD800, 'b' };
+  const uint16 lone_low[] = { 0xDC00 };
+  const uint16 reversed[] = { 0xDC00, 0xD800 };
+  BOOST_CHECK(!utf::validate_utf16(lone_high, 3));
+  BOOST_CHECK(!utf::validate_utf16(lone_low, 1));
+  BOOST_CHECK(!utf::validate_utf16(reversed, 2));
+  BOOST_CHECK(!utf::validate_utf16(lone_high, 2));
+  const uint32 surrogate[] = { 0xDFFF };
+  const uint32 too_big[] = { 0x110000 };
+  BOOST_CHECK(!utf::validate_utf32(surrogate, 1));
+  BOOST_CHECK(!utf::validate_utf32(too_big, 1));
+  error_code ec;
+  char out[8];
+  BOOST_CHECK_EQUAL(utf::convert_utf32_to_utf8(too_big, 1, out, ec), 0u);
+  BOOST_CHECK(ec);
+
+  // random input is either rejected or survives a round trip
+  std::mt19937 random(42);
+  for (int i = 0; i < 2000; ++i) {
+    std::string text(random() % 40, '\0');
+    for (size_t j = 0; j < text.size(); ++j)
+      text[j] = static_cast<char>(random() % 3 == 0 ? random() : 'a' + random() % 26);
+
+    std::vector<uint16> buffer(utf::utf16_length_from_utf8(text.data(), text.size()) + 1);
+    error_code convert_ec;
+    const size_t written = utf::convert_utf8_to_utf16(text.data(), text.size(), buffer.data(), convert_ec);
+    BOOST_CHECK_EQUAL(!convert_ec, utf::validate_utf8(text.data(), text.size()));
+    if (!convert_ec) {
+      std::string back(utf::utf8_length_from_utf16(buffer.data(), written), '\0');
+      utf::convert_utf16_to_utf8(buffer.data(), written, &back[0]);
+      BOOST_CHECK(back == text);
+    }
+  }
+
+  // the std::wstring conversions
+  const std::string hello = "hello, \xD0\xBC\xD0\xB8\xD1\x80 \xF0\x9F\x98\x80";
+  const std::wstring whello = utf8_to_utf16(hello);
+  BOOST_CHECK_EQUAL(whello.size(), sizeof(wchar_t) == 2 ? 13u : 12u);
+  BOOST_CHECK(whello[7] == 0x43C);
+  BOOST_CHECK(utf16_to_utf8(whello) == hello);
+  BOOST_CHECK(utf8_to_utf16(lite_string()).empty());
+  ec.clear();
+  BOOST_CHECK(utf8_to_utf16(std::string("\xC3"), ec).empty());
+  BOOST_CHECK(ec);
+}
+
+BOOST_AUTO_TEST_CASE(Utf8Decoder)
+{
+  using namespace easy;
+
+  std::string text;
+  for (int i = 0; i < 10; ++i)
+    text += "plain ascii text, \xD0\xBC\xD0\xB8\xD1\x80, \xE6\x97\xA5\xE6\x9C\xAC, \xF0\x9F\x98\x80!";
+  std::vector<uint16> expected(utf::utf16_length_from_utf8(text.data(), text.size()));
+  utf::convert_utf8_to_utf16(text.data(), text.size(), expected.data());
+
+  // the text cut in two at every byte
+  utf::utf8_decoder decoder;
+  for (size_t cut = 0; cut <= text.size(); ++cut) {
+    decoder.reset();
+    std::vector<uint16> out;
+    decoder.decode(text.data(), cut, out);
+    decoder.decode(text.data() + cut, text.size() - cut, out);
+    decoder.finish();
+    BOOST_CHECK(out == expected);
+  }
+
+  // random chunks decoded into a reused buffer
+  std::mt19937 random(7);
+  for (int i = 0; i < 100; ++i) {
+    decoder.reset();
+    std::vector<uint32> buffer;
+    std::vector<uint32> all;
+    for (size_t pos = 0; pos < text.size(); ) {
+      const size_t size = std::min<size_t>(random() % 6, text.size() - pos);
+      buffer.clear();
+      decoder.decode(text.data() + pos, size, buffer);
+      BOOST_CHECK(decoder.pending() < 4u);
+      all.insert(all.end(), buffer.begin(), buffer.end());
+      pos += size;
+    }
+    decoder.finish();
+    BOOST_CHECK_EQUAL(decoder.offset(), text.size());
+    BOOST_CHECK_EQUAL(all.size(), utf::utf32_length_from_utf8(text.data(), text.size()));
+  }
+
+  // errors report the offset of the invalid sequence
+  error_code ec;
+  decoder.reset();
+  std::vector<uint16> out;
+  decoder.decode("abc\xE6\x97", 5, out, ec);
+  BOOST_CHECK(!ec);
+  BOOST_CHECK_EQUAL(decoder.pending(), 2u);
+  decoder.decode("xyz", 3, out, ec);
+  BOOST_CHECK(ec == utf::make_invalid_sequence_error());
+  BOOST_CHECK_EQUAL(decoder.error_offset(), 3u);
+  BOOST_CHECK_EQUAL(out.size(), 3u);
+
+  // the decoder stays failed until it is reset
+  ec.clear();
+  decoder.decode("ok", 2, out, ec);
+  BOOST_CHECK(ec);
+  BOOST_CHECK(decoder.failed());
+  decoder.reset();
+  decoder.decode("ok", 2, out);
+  BOOST_CHECK(!decoder.failed());
+
+  decoder.reset();
+  out.clear();
+  decoder.decode("0123456789", 10, out);
+  BOOST_CHECK_THROW(decoder.decode("abcdefghijklmnopqrstuvwxyz\xC0\xAF", 28, out), system_error);
+  BOOST_CHECK_EQUAL(decoder.error_offset(), 36u);
+  BOOST_CHECK_EQUAL(out.size(), 36u);
+
+  // an invalid prefix is reported before the sequence is complete
+  ec.clear();
+  decoder.reset();
+  decoder.validate("a\xED", 2, ec);
+  decoder.validate("\xA0", 1, ec);
+  BOOST_CHECK(ec);
+  BOOST_CHECK_EQUAL(decoder.error_offset(), 1u);
+
+  // a sequence cut by the end of the input
+  ec.clear();
+  decoder.reset();
+  decoder.validate("ab\xF0\x9F\x98", 5, ec);
+  BOOST_CHECK(!ec);
+  decoder.finish(ec);
+  BOOST_CHECK(ec);
+  BOOST_CHECK_EQUAL(decoder.error_offset(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(StaticString)
+{
+  using namespace easy;
+
+  static const static_string content_type("content-type");
+  BOOST_CHECK_EQUAL(content_type.size(), 12u);
+  BOOST_CHECK_EQUAL(content_type.c_str(), "content-type");
+  BOOST_CHECK_EQUAL(content_type.hash(), hash_value(lite_string("content-type")));
+  BOOST_CHECK_EQUAL(content_type.hash(), lite_string_hash()(std::string("content-type")));
+  BOOST_CHECK_EQUAL(std::hash<static_string>()(content_type), content_type.hash());
+  BOOST_CHECK(static_string("").empty());
+
+  // converts to a view of the literal
+  const lite_string view = content_type;
+  BOOST_CHECK(view.data() == content_type.data());
+  BOOST_CHECK_EQUAL(view.size(), 12u);
+  BOOST_CHECK(view == content_type);
+  BOOST_CHECK(content_type == lite_string("content-type"));
+  BOOST_CHECK(content_type != lite_string("content-length"));
+  BOOST_CHECK(lite_string("content") < content_type);
+  BOOST_CHECK(content_type == static_string("content-type"));
+  BOOST_CHECK(content_type != static_string("content-typf"));
+  BOOST_CHECK(lite_string(content_type).starts_with("content"));
+
+  // probes containers keyed by std::string
+  boost::unordered_map<std::string, int, lite_string_hash, lite_string_equal> headers;
+  headers["content-type"] = 1;
+  headers["host"] = 2;
+  BOOST_CHECK_EQUAL(headers.find(content_type, lite_string_hash(), lite_string_equal())->second, 1);
+  BOOST_CHECK(headers.find(static_string("accept"), lite_string_hash(), lite_string_equal()) == headers.end());
+  BOOST_CHECK(lite_string_equal()(content_type, std::string("content-type")));
+
+  // and string pools
+  string_pool pool;
+  const lite_string interned = pool.intern(content_type);
+  BOOST_CHECK(pool.intern(lite_string("content-type")).data() == interned.data());
+  BOOST_CHECK(pool.find(content_type).data() == interned.data());
+  concurrent_string_pool shared_pool;
+  BOOST_CHECK(shared_pool.intern(content_type).data() == shared_pool.intern("content-type").data());
+
+#ifdef EASY_HAS_WCAHR
+  const static_wstring wide(L"wide");
+  BOOST_CHECK_EQUAL(wide.size(), 4u);
+  BOOST_CHECK(lite_wstring(L"wide") == wide);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(StringBuilder)
+{
+  using namespace easy;
+
+  string_builder sql(16);
+  BOOST_CHECK(sql.empty());
+  BOOST_CHECK(!sql.flatten());
+
+  std::string expected = "SELECT id FROM orders WHERE id IN (";
+  sql << "SELECT id FROM orders WHERE id IN (";
+  for (int i = 0; i < 100; ++i) {
+    sql << (i ? ", " : "") << i * 1000;
+    expected += (i ? ", " : "") + std::to_string(i * 1000);
+  }
+  sql << ')';
+  expected += ')';
+  BOOST_CHECK_EQUAL(sql.size(), expected.size());
+  BOOST_CHECK(sql.fragments().size() > 1);
+  BOOST_CHECK_EQUAL(sql.str(), expected);
+
+  size_t fragment_bytes = 0;
+  for (size_t i = 0; i < sql.fragments().size(); ++i)
+    fragment_bytes += sql.fragments()[i].size;
+  BOOST_CHECK_EQUAL(fragment_bytes, expected.size());
+
+  const lite_string flat = sql.flatten();
+  BOOST_CHECK_EQUAL(flat, expected);
+  BOOST_CHECK_EQUAL(flat.c_str()[flat.size()], '\0');
+  BOOST_CHECK_EQUAL(sql.fragments().size(), 1u);
+
+  // appends after flattening continue the text
+  sql << " LIMIT " << 10u;
+  BOOST_CHECK_EQUAL(sql.str(), expected + " LIMIT 10");
+
+  // numbers
+  string_builder numbers;
+  numbers << 0 << ' ' << -7 << ' ' << std::numeric_limits<int64>::min() << ' ' << std::numeric_limits<uint64>::max()
+    << ' ' << 123456789L << ' ' << static_cast<unsigned short>(65535);
+  BOOST_CHECK_EQUAL(numbers.str(), "0 -7 -9223372036854775808 18446744073709551615 123456789 65535");
+
+  const double values[] = { 0.1, 1.0 / 3, 2.5, -1e-300, 1e21, 123456789012345678.0, 0.30000000000000004 };
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+    string_builder b;
+    b << values[i];
+    BOOST_CHECK_EQUAL(std::strtod(b.flatten().c_str(), nullptr), values[i]);
+  }
+  std::mt19937_64 random(3);
+  for (int i = 0; i < 10000; ++i) {
+    const double value = i % 2 ? static_cast<double>(random() % 100000000) / 1000 : static_cast<double>(random()) / 3e7;
+    string_builder b;
+    b << value;
+    BOOST_CHECK_EQUAL(std::strtod(b.flatten().c_str(), nullptr), value);
+  }
+  string_builder shortest;
+  shortest << 0.1 << ' ' << 2.5 << ' ' << 100.0 << ' ' << -0.0 << ' ' << -12.0625 << ' ' << 0.001;
+  BOOST_CHECK_EQUAL(shortest.str(), "0.1 2.5 100 -0 -12.0625 0.001");
+
+  // long appends, fill and views
+  const std::string big(100000, 'x');
+  string_builder text(64);
+  const char header[] = "HTTP/1.1 200 OK\r\n";
+  text.append_view(header).append(big).append(3, '!');
+  BOOST_CHECK(text.fragments()[0].pdata == header);
+  BOOST_CHECK_EQUAL(text.size(), sizeof(header) - 1 + big.size() + 3);
+  BOOST_CHECK_EQUAL(text.str(), header + big + "!!!");
+
+  text.clear();
+  BOOST_CHECK(text.empty());
+  BOOST_CHECK(text.fragments().empty());
+  text << "again";
+  BOOST_CHECK_EQUAL(text.flatten(), "again");
+}
+
+BOOST_AUTO_TEST_CASE(Numbers)
+{
+  using namespace easy;
+
+  // integers
+  BOOST_CHECK_EQUAL(parse<int>("0"), 0);
+  BOOST_CHECK_EQUAL(parse<int>("-2147483648"), std::numeric_limits<int>::min());
+  BOOST_CHECK_EQUAL(parse<int>("2147483647"), std::numeric_limits<int>::max());
+  BOOST_CHECK_EQUAL(parse<int64>("-9223372036854775808"), std::numeric_limits<int64>::min());
+  BOOST_CHECK_EQUAL(parse<uint64>("18446744073709551615"), std::numeric_limits<uint64>::max());
+  BOOST_CHECK_EQUAL(parse<uint64>("000000000000000000000000012345678901234567"), 12345678901234567ULL);
+  BOOST_CHECK_EQUAL(parse<unsigned int>("4294967295"), 4294967295u);
+  BOOST_CHECK_EQUAL(parse<long>("-0"), 0);
+
+  error_code ec;
+  BOOST_CHECK_EQUAL(parse<int>("2147483648", ec), 0);
+  BOOST_CHECK(ec == generic_error::out_of_range);
+  parse<uint64>("18446744073709551616", ec);
+  BOOST_CHECK(ec == generic_error::out_of_range);
+  parse<uint64>("123456789012345678901", ec);
+  BOOST_CHECK(ec == generic_error::out_of_range);
+  const char* invalid[] = { "", "-", "+1", " 1", "1 ", "0x10", "12a", "--1" };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+    parse<int>(invalid[i], ec);
+    BOOST_CHECK_MESSAGE(ec == generic_error::invalid_value, invalid[i]);
+  }
+  parse<unsigned int>("-1", ec);
+  BOOST_CHECK(ec == generic_error::invalid_value);
+  BOOST_CHECK_THROW(parse<int>("x"), system_error);
+
+  // prefixes in the manner of from_chars
+  int value = 7;
+  BOOST_CHECK_EQUAL(parse(lite_string("1234,5678"), value), 4u);
+  BOOST_CHECK_EQUAL(value, 1234);
+  BOOST_CHECK_EQUAL(parse(lite_string("abc"), value, ec), 0u);
+  BOOST_CHECK_EQUAL(value, 1234);
+
+  // views without a terminating zero
+  const std::string digits = "12345678901234567890";
+  BOOST_CHECK_EQUAL(parse<uint64>(lite_string(digits.data(), 9)), 123456789u);
+  BOOST_CHECK_EQUAL(parse<uint64>(lite_string(digits.data() + 9, 8)), 1234567u);
+
+  std::mt19937_64 random(11);
+  for (int i = 0; i < 10000; ++i) {
+    const int64 v = static_cast<int64>(random()) >> (random() % 64);
+    char buffer[max_number_length];
+    const size_t size = format(v, buffer, sizeof(buffer));
+    BOOST_CHECK_EQUAL(std::string(buffer, size), std::to_string(v));
+    BOOST_CHECK_EQUAL(parse<int64>(lite_string(buffer, size)), v);
+  }
+
+  // floating point numbers
+  BOOST_CHECK_EQUAL(parse<double>("0.1"), 0.1);
+  BOOST_CHECK_EQUAL(parse<double>("-2.5e3"), -2500.0);
+  BOOST_CHECK_EQUAL(parse<double>("1."), 1.0);
+  BOOST_CHECK_EQUAL(parse<double>(".5"), 0.5);
+  BOOST_CHECK_EQUAL(parse<double>("1E+2"), 100.0);
+  BOOST_CHECK_EQUAL(parse<double>("4.9406564584124654e-324"), 4.9406564584124654e-324);
+  BOOST_CHECK_EQUAL(parse<double>("1.7976931348623157e308"), std::numeric_limits<double>::max());
+  BOOST_CHECK_EQUAL(parse<double>("123456789012345678901234567890"), 123456789012345678901234567890.0);
+  BOOST_CHECK_EQUAL(parse<float>("0.1"), 0.1f);
+  BOOST_CHECK_EQUAL(parse<float>("3.4028235e38"), std::numeric_limits<float>::max());
+  // close to the midpoint of two floats, where rounding through a double goes the wrong way
+  BOOST_CHECK_EQUAL(parse<float>("27.58643627166748"), std::strtof("27.58643627166748", nullptr));
+  BOOST_CHECK_EQUAL(parse<float>("27.58643627166748"), 27.5864353f);
+  BOOST_CHECK_EQUAL(parse<float>("1.00000005960464477"), std::strtof("1.00000005960464477", nullptr));
+  BOOST_CHECK_EQUAL(parse<float>("16777217"), 16777216.0f);
+  BOOST_CHECK_EQUAL(parse<float>("16777219"), 16777220.0f);
+  BOOST_CHECK_EQUAL(parse<double>("-Infinity"), -std::numeric_limits<double>::infinity());
+  BOOST_CHECK(parse<double>("nan") != parse<double>("nan"));
+
+  double d = 0;
+  BOOST_CHECK_EQUAL(parse(lite_string("2e"), d), 1u);
+  BOOST_CHECK_EQUAL(d, 2.0);
+  parse<double>("1e999", ec);
+  BOOST_CHECK(ec == generic_error::out_of_range);
+  parse<float>("1e39", ec);
+  BOOST_CHECK(ec == generic_error::out_of_range);
+  const char* invalid_doubles[] = { "", "-", ".", "e5", "1.5x", "in", "--1", "1e5.5" };
+  for (size_t i = 0; i < sizeof(invalid_doubles) / sizeof(invalid_doubles[0]); ++i) {
+    parse<double>(invalid_doubles[i], ec);
+    BOOST_CHECK_MESSAGE(ec == generic_error::invalid_value, invalid_doubles[i]);
+  }
+
+  // plain decimals below 1e15, the smallest precision reading back otherwise
+  char buffer[max_number_length];
+  BOOST_CHECK_EQUAL(std::string(buffer, format(0.1, buffer, sizeof(buffer))), "0.1");
+  BOOST_CHECK_EQUAL(std::string(buffer, format(1e14, buffer, sizeof(buffer))), "100000000000000");
+  BOOST_CHECK_EQUAL(std::string(buffer, format(1e15, buffer, sizeof(buffer))), "1e+15");
+  BOOST_CHECK_EQUAL(std::string(buffer, format(0.1f, buffer, sizeof(buffer))), "0.1");
+  BOOST_CHECK_EQUAL(std::string(buffer, format(5e-324, buffer, sizeof(buffer))), "5e-324");
+  BOOST_CHECK_EQUAL(std::string(buffer, format(1e300, buffer, sizeof(buffer))), "1e+300");
+  BOOST_CHECK_EQUAL(std::string(buffer, format(-std::numeric_limits<double>::infinity(), buffer, sizeof(buffer))), "-inf");
+  BOOST_CHECK_EQUAL(format(123456, buffer, 3, ec), 0u);
+  BOOST_CHECK(ec);
+
+  for (int i = 0; i < 10000; ++i) {
+    uint64 bits = random();
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    if (v != v)
+      continue;
+    const size_t size = format(v, buffer, sizeof(buffer));
+    BOOST_CHECK_EQUAL(parse<double>(lite_string(buffer, size)), v);
+
+    const float f = static_cast<float>(static_cast<double>(random() % 2000000) / (1 + random() % 1000));
+    const size_t float_size = format(f, buffer, sizeof(buffer));
+    BOOST_CHECK_EQUAL(parse<float>(lite_string(buffer, float_size)), f);
+
+    // decimals with up to 17 digits round like the C library
+    const std::string text = std::to_string(random() % 100000000) + "." + std::to_string(random() % 1000000000);
+    BOOST_CHECK_EQUAL(parse<float>(text), std::strtof(text.c_str(), nullptr));
+    BOOST_CHECK_EQUAL(parse<double>(text), std::strtod(text.c_str(), nullptr));
+  }
+}